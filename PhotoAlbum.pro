@@ -6,8 +6,9 @@
 
 QT       += core gui
 QT       += xml
+QT       += network
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = PhotoAlbum
 TEMPLATE = app
@@ -16,13 +17,80 @@ TEMPLATE = app
 SOURCES += main.cpp\
         photoalbum.cpp\
         crop.cpp \
-        photoalbum_extra_functionality.cpp
+        photoalbum_extra_functionality.cpp \
+        trace.cpp \
+        image_buffers.cpp \
+        image_cache.cpp \
+        image_writer.cpp \
+        jpeg_transform.cpp \
+        jpeg_scanline_reader.cpp \
+        tile_pyramid.cpp \
+        tile_viewer.cpp \
+        histogram.cpp \
+        histogram_widget.cpp \
+        tiled_image.cpp \
+        album_commands.cpp \
+        photo_hash.cpp \
+        duplicate_finder.cpp \
+        duplicates_dialog.cpp \
+        gallery_exporter.cpp \
+        album_watcher.cpp \
+        exif_reader.cpp \
+        photo_importer.cpp \
+        image_filters.cpp \
+        album_checker.cpp \
+        photo_view.cpp \
+        slideshow.cpp \
+        pixel_cache.cpp \
+        filter_pipeline.cpp \
+        edit_recipe.cpp \
+        album_journal.cpp \
+        render_service.cpp \
+        latency_replay.cpp \
+        album_shards.cpp
 
 HEADERS  += photoalbum.h\
-            crop.h
+            crop.h \
+            trace.h \
+            image_buffers.h \
+            image_cache.h \
+            image_writer.h \
+            jpeg_transform.h \
+            jpeg_scanline_reader.h \
+            tile_pyramid.h \
+            tile_viewer.h \
+            histogram.h \
+            histogram_widget.h \
+            tiled_image.h \
+            album_commands.h \
+            photo_hash.h \
+            duplicate_finder.h \
+            duplicates_dialog.h \
+            gallery_exporter.h \
+            album_watcher.h \
+            exif_reader.h \
+            photo_importer.h \
+            image_filters.h \
+            album_checker.h \
+            photo_view.h \
+            slideshow.h \
+            pixel_cache.h \
+            filter_pipeline.h \
+            edit_recipe.h \
+            album_journal.h \
+            render_service.h \
+            latency_replay.h \
+            album_shards.h
 
 CONFIG   += console
 
 FORMS    += photoalbum.ui
 
 QMAKE_CXXFLAGS += -std=c++11
+
+#Lossless JPEG rotate and crop work on the DCT coefficients through libjpeg,
+#which also decodes photos too large for memory a strip at a time
+packagesExist(libjpeg) {
+    DEFINES += HAVE_LIBJPEG
+    LIBS += -ljpeg
+}
@@ -0,0 +1,451 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the AlbumChecker class declared in
+//album_checker.h. The records are copied out of the document once, so the
+//checks on the thread pool never touch the QDomDocument; each check writes
+//only its own result.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "album_checker.h"
+#include "photo_hash.h"
+#include "edit_recipe.h"
+#include "trace.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace
+{
+    //The tags of a <photo>, in order
+    const char *const PhotoTags[4] = {"file", "date", "location", "description"};
+
+    //Levels above the nearest surviving directory searched for moved files
+    const int SearchLevels = 1;
+
+    //Files looked at while searching, so a search from high up the tree
+    //cannot run away
+    const int MaxSearchedFiles = 4000000;
+
+    //Candidates hashed for one missing photo
+    const int MaxHashedCandidates = 8;
+
+    //Perceptual hash distance up to which a candidate is the same photo
+    const int MaxRelinkDistance = 4;
+
+    //Replaces the contents of element with text
+    void set_text(QDomElement element, const QString &text)
+    {
+        while(element.hasChildNodes())
+        {
+            element.removeChild(element.firstChild());
+        }
+        element.appendChild(element.ownerDocument().createTextNode(text));
+    }
+
+    //The directory to search for a file that used to be at path
+    QString search_root(const QString &path)
+    {
+        QDir dir = QFileInfo(path).absoluteDir();
+        while(!dir.exists() && !dir.isRoot())
+        {
+            if(!dir.cdUp())
+                break;
+        }
+        for(int i = 0; i < SearchLevels && !dir.isRoot(); i++)
+        {
+            dir.cdUp();
+        }
+
+        //Never search the whole file system
+        if(dir.isRoot())
+            return QString();
+        return dir.absolutePath();
+    }
+}
+
+AlbumChecker::AlbumChecker(const QDomElement &album, QObject *parent) :
+    QObject(parent),
+    cancelled(false)
+{
+    TRACE_SCOPE("read_album_records", "load");
+
+    QDomElement photo = album.firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        Result record;
+        record.file = photo.firstChildElement("file").text();
+        if(!well_formed(photo))
+            record.problems |= Malformed;
+        result.append(record);
+    }
+}
+
+AlbumChecker::~AlbumChecker()
+{
+    cancel();
+    future.waitForFinished();
+}
+
+void AlbumChecker::start()
+{
+    if(future.isRunning())
+        return;
+
+    cancelled = false;
+    future = QtConcurrent::run(this, &AlbumChecker::run);
+}
+
+void AlbumChecker::cancel()
+{
+    cancelled = true;
+}
+
+//Returns true if photo has exactly the four tags, in order, and a file
+bool AlbumChecker::well_formed(const QDomElement &photo)
+{
+    int tag = 0;
+    for(QDomNode child = photo.firstChild(); !child.isNull(); child = child.nextSibling())
+    {
+        if(child.isComment())
+            continue;
+
+        //The four tags may be followed by the photo's edits
+        if(tag == 4 && child.isElement() && child.toElement().tagName() == EditRecipe::TagName
+           && child.nextSiblingElement().isNull())
+            continue;
+
+        if(tag == 4 || !child.isElement() || child.toElement().tagName() != PhotoTags[tag])
+            return false;
+        tag++;
+    }
+
+    return tag == 4 && !photo.firstChildElement("file").text().trimmed().isEmpty();
+}
+
+//Runs on a worker thread, or on the caller's for check()
+void AlbumChecker::run()
+{
+    TRACE_SCOPE("check_album", "load");
+
+    int count = result.size();
+    emit progress(0, count);
+
+    QVector<int> indices(count);
+    for(int i = 0; i < count; i++)
+    {
+        indices[i] = i;
+    }
+
+    //Stat and probe every file in parallel. Only the header is read.
+    Result *result_data = result.data();
+    std::atomic<int> done(0);
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        if(cancelled)
+            return;
+
+        Result &record = result_data[i];
+        record.problems &= Malformed;
+        record.relink.clear();
+
+        QFileInfo info(record.file);
+        if(record.file.isEmpty() || !info.isFile())
+        {
+            record.problems |= Missing;
+        }
+        else
+        {
+            QImageReader reader(record.file);
+            if(!reader.canRead())
+                record.problems |= Unreadable;
+        }
+
+        int finished_count = ++done;
+        if(finished_count % 1024 == 0 || finished_count == count)
+            emit progress(finished_count, count);
+    });
+
+    if(!cancelled)
+        find_moved_files();
+
+    emit finished();
+}
+
+//Looks for the missing files near where they used to be
+void AlbumChecker::find_moved_files()
+{
+    TRACE_SCOPE("find_moved_files", "load");
+
+    //Missing records by file name, the files still there, and where to look
+    QHash<QString, QVector<int> > wanted;
+    QSet<QString> present;
+    QStringList roots;
+    for(int i = 0; i < result.size(); i++)
+    {
+        const Result &record = result[i];
+        if(!(record.problems & Missing))
+        {
+            present.insert(QFileInfo(record.file).absoluteFilePath());
+            continue;
+        }
+
+        QString name = QFileInfo(record.file).fileName();
+        if(name.isEmpty())
+            continue;
+
+        wanted[name].append(i);
+        QString root = search_root(record.file);
+        if(!root.isEmpty())
+            roots.append(root);
+    }
+
+    if(wanted.isEmpty())
+        return;
+
+    //Drop duplicate roots and roots inside other roots, so no directory is
+    //walked twice
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+    QStringList distinct;
+    for(int i = 0; i < roots.size(); i++)
+    {
+        bool inside = false;
+        for(int d = 0; d < distinct.size() && !inside; d++)
+        {
+            inside = roots[i].startsWith(distinct[d] + '/');
+        }
+        if(!inside)
+            distinct.append(roots[i]);
+    }
+
+    //Index the files with a wanted name. The walk is bound by directory
+    //reads, so it runs on this thread alone.
+    QHash<QString, QStringList> found;
+    int searched = 0;
+    for(int i = 0; i < distinct.size() && !cancelled && searched < MaxSearchedFiles; i++)
+    {
+        QDirIterator it(distinct[i], QDir::Files | QDir::NoDotAndDotDot | QDir::Hidden,
+                        QDirIterator::Subdirectories);
+        while(it.hasNext() && !cancelled && searched < MaxSearchedFiles)
+        {
+            it.next();
+            searched++;
+
+            QString name = it.fileName();
+            if(wanted.contains(name))
+            {
+                QString path = it.filePath();
+                if(!present.contains(path))
+                    found[name].append(path);
+            }
+        }
+    }
+
+    //Choose among the candidates for each missing photo in parallel, since
+    //hashing a candidate decodes it
+    QVector<int> missing;
+    for(QHash<QString, QVector<int> >::const_iterator it = wanted.constBegin();
+        it != wanted.constEnd(); ++it)
+    {
+        if(found.contains(it.key()))
+            missing += it.value();
+    }
+
+    Result *result_data = result.data();
+    QtConcurrent::blockingMap(missing, [&](int i)
+    {
+        if(cancelled)
+            return;
+
+        Result &record = result_data[i];
+        const QStringList candidates = found.value(QFileInfo(record.file).fileName());
+
+        PhotoHash::Hashes recorded;
+        qint64 recorded_size;
+        if(!HashCache::instance()->recorded(record.file, &recorded, &recorded_size))
+        {
+            //Nothing to compare with, so only an unambiguous name will do
+            if(candidates.size() == 1)
+                record.relink = candidates[0];
+            return;
+        }
+
+        //A file of the same size is taken to be the photo
+        QStringList same_size;
+        for(int c = 0; c < candidates.size(); c++)
+        {
+            if(QFileInfo(candidates[c]).size() == recorded_size)
+                same_size.append(candidates[c]);
+        }
+        if(same_size.size() == 1)
+        {
+            record.relink = same_size[0];
+            return;
+        }
+
+        //Otherwise the closest perceptual hash, if it is close and unique
+        const QStringList &hashed = same_size.isEmpty() ? candidates : same_size;
+        int best = MaxRelinkDistance + 1;
+        int best_count = 0;
+        for(int c = 0; c < hashed.size() && c < MaxHashedCandidates; c++)
+        {
+            PhotoHash::Hashes hashes;
+            if(!PhotoHash::compute(hashed[c], &hashes))
+                continue;
+
+            int distance = PhotoHash::distance(hashes.phash, recorded.phash);
+            if(distance < best)
+            {
+                best = distance;
+                best_count = 1;
+                record.relink = hashed[c];
+            }
+            else if(distance == best)
+            {
+                best_count++;
+            }
+        }
+        if(best_count != 1)
+            record.relink.clear();
+    });
+
+    //Keep the candidates' hashes for the next check or duplicate search
+    HashCache::instance()->save();
+}
+
+AlbumChecker::Summary AlbumChecker::summary() const
+{
+    Summary counts;
+    counts.records = result.size();
+    for(int i = 0; i < result.size(); i++)
+    {
+        const Result &record = result[i];
+        if(record.problems & Missing)
+            counts.missing++;
+        if(!record.relink.isEmpty())
+            counts.relinked++;
+        if(record.problems & Unreadable)
+            counts.unreadable++;
+        if(record.problems & Malformed)
+            counts.malformed++;
+    }
+    return counts;
+}
+
+bool AlbumChecker::matches(const QDomElement &album) const
+{
+    int i = 0;
+    QDomElement photo = album.firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"), i++)
+    {
+        if(i == result.size() || photo.firstChildElement("file").text() != result[i].file)
+            return false;
+    }
+    return i == result.size();
+}
+
+int AlbumChecker::repair(QDomElement album) const
+{
+    TRACE_SCOPE("repair_album", "load");
+
+    QList<QDomElement> dead;
+    int i = 0;
+    QDomElement photo = album.firstChildElement("photo");
+    for(; !photo.isNull() && i < result.size(); photo = photo.nextSiblingElement("photo"), i++)
+    {
+        const Result &record = result[i];
+        if((record.problems & Missing) && record.relink.isEmpty())
+        {
+            dead.append(photo);
+            continue;
+        }
+
+        QString file = record.relink.isEmpty() ? record.file : record.relink;
+        if(record.problems & Malformed)
+        {
+            //Keep the first of each known tag and the edits, and rebuild
+            //the rest
+            QString texts[4];
+            for(int tag = 0; tag < 4; tag++)
+            {
+                texts[tag] = photo.firstChildElement(PhotoTags[tag]).text();
+            }
+            texts[0] = file;
+            QDomNode edits = photo.firstChildElement(EditRecipe::TagName).cloneNode();
+
+            while(photo.hasChildNodes())
+            {
+                photo.removeChild(photo.firstChild());
+            }
+            for(int tag = 0; tag < 4; tag++)
+            {
+                QDomElement element = album.ownerDocument().createElement(PhotoTags[tag]);
+                set_text(element, texts[tag]);
+                photo.appendChild(element);
+            }
+            if(!edits.isNull())
+                photo.appendChild(edits);
+        }
+        else if(!record.relink.isEmpty())
+        {
+            set_text(photo.firstChildElement("file"), file);
+        }
+    }
+
+    for(int d = 0; d < dead.size(); d++)
+    {
+        album.removeChild(dead[d]);
+    }
+    return dead.size();
+}
+
+QString AlbumChecker::report(int max_lines) const
+{
+    Summary counts = summary();
+    QString text = QString("Checked %1 photos: %2 missing (%3 found elsewhere), "
+                           "%4 unreadable, %5 malformed\n")
+                   .arg(counts.records).arg(counts.missing).arg(counts.relinked)
+                   .arg(counts.unreadable).arg(counts.malformed);
+
+    int lines = 0;
+    for(int i = 0; i < result.size(); i++)
+    {
+        const Result &record = result[i];
+        if(record.problems == 0)
+            continue;
+
+        if(max_lines >= 0 && lines == max_lines)
+        {
+            text += QString("... and more\n");
+            break;
+        }
+
+        QStringList problems;
+        if(record.problems & Missing)
+        {
+            if(record.relink.isEmpty())
+                problems.append("missing");
+            else
+                problems.append("moved to " + record.relink);
+        }
+        if(record.problems & Unreadable)
+            problems.append("not a readable image");
+        if(record.problems & Malformed)
+            problems.append("malformed record");
+
+        text += QString("Photo %1 (%2): %3\n").arg(i + 1)
+                .arg(record.file.isEmpty() ? QString("no file") : record.file)
+                .arg(problems.join(", "));
+        lines++;
+    }
+    return text;
+}
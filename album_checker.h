@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The AlbumChecker class, which validates every <photo> of an
+//album on a background thread and can repair what it finds.
+//
+//Each record is checked for its structure (exactly one <file>, <date>,
+//<location> and <description>, in that order) and its file is checked to
+//exist and to be readable by QImageReader from its header alone. Checks run
+//in parallel and never decode pixels.
+//
+//A missing file is looked for by name under the nearest directories above
+//its old location that still exist. When the HashCache remembers the
+//photo, a candidate has to match its size or perceptual hash; otherwise a
+//single file of the same name is taken.
+//
+//Repairing relinks the files that were found, rebuilds malformed records
+//and drops records whose file is gone for good. The records are read from
+//and repaired in a QDomElement on the calling thread, so the same code
+//serves the GUI and the headless --check mode.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ALBUM_CHECKER_H
+#define ALBUM_CHECKER_H
+
+#include <QObject>
+#include <QDomElement>
+#include <QFuture>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+
+class AlbumChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Problems found with a record, or'ed together
+    enum Problem
+    {
+        Missing = 1,    //The file does not exist
+        Unreadable = 2, //The file exists but is not an image Qt can read
+        Malformed = 4   //Missing, repeated, unknown or out of order tags
+    };
+
+    //What the check found out about one <photo>
+    struct Result
+    {
+        QString file;
+        int problems;
+        QString relink; //Where a missing file was found, if it was
+
+        Result() : problems(0) {}
+    };
+
+    //Counts of a finished check or repair
+    struct Summary
+    {
+        int records;
+        int missing;
+        int relinked;
+        int unreadable;
+        int malformed;
+
+        Summary() : records(0), missing(0), relinked(0), unreadable(0), malformed(0) {}
+        int problems() const { return missing + unreadable + malformed; }
+    };
+
+    //Reads the records of the <album> element album. Must be called on the
+    //thread that owns the document.
+    explicit AlbumChecker(const QDomElement &album, QObject *parent = 0);
+    ~AlbumChecker();
+
+    //Starts the check in the background. finished() is emitted when it is
+    //done or cancelled.
+    void start();
+    void cancel();
+    bool is_cancelled() const { return cancelled.load(); }
+
+    //Checks on the calling thread, for the headless mode
+    void check() { run(); }
+
+    //One result per <photo>, in album order
+    const QVector<Result> &results() const { return result; }
+    Summary summary() const;
+
+    //Returns true if album still has the records that were checked
+    bool matches(const QDomElement &album) const;
+
+    //Repairs album with the results: relinks found files, rebuilds
+    //malformed records and drops records whose file is missing. Returns the
+    //number of records dropped.
+    int repair(QDomElement album) const;
+
+    //Describes the problems found, one line per record, at most max_lines
+    //lines (or all if max_lines is negative)
+    QString report(int max_lines = -1) const;
+
+signals:
+    void progress(int done, int total);
+    void finished();
+
+private:
+    void run();
+    void find_moved_files();
+
+    static bool well_formed(const QDomElement &photo);
+
+    QVector<Result> result;
+    std::atomic<bool> cancelled;
+    QFuture<void> future;
+};
+
+#endif // ALBUM_CHECKER_H
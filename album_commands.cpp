@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the undoable commands declared in
+//album_commands.h. The commands only describe what changes; the album
+//itself is modified through PhotoAlbum's index based editing functions,
+//which also keep the display and menu actions up to date.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "album_commands.h"
+#include "photoalbum.h"
+
+InsertPhotoCommand::InsertPhotoCommand(PhotoAlbum *album, int index, const QDomElement &photo) :
+    album(album),
+    index(index),
+    photo(photo)
+{
+    setText("Add Photo");
+}
+
+void InsertPhotoCommand::redo()
+{
+    album->insert_photo(index, photo);
+    album->show_photo(index);
+}
+
+void InsertPhotoCommand::undo()
+{
+    album->remove_photo(index);
+    album->show_photo(qMin(index, album->photo_count() - 1));
+}
+
+ImportPhotosCommand::ImportPhotosCommand(PhotoAlbum *album, int index,
+                                         const QList<QDomElement> &photos) :
+    album(album),
+    index(index),
+    photos(photos)
+{
+    setText(QString("Import %1 Photos").arg(photos.size()));
+}
+
+void ImportPhotosCommand::redo()
+{
+    album->insert_photos(index, photos);
+    album->show_photo(index);
+}
+
+void ImportPhotosCommand::undo()
+{
+    album->remove_photos(index, photos.size());
+    album->show_photo(qMin(index, album->photo_count() - 1));
+}
+
+RemovePhotoCommand::RemovePhotoCommand(PhotoAlbum *album, int index) :
+    album(album),
+    index(index)
+{
+    setText("Delete Photo");
+}
+
+//The photo after the deleted one is shown, or the one before it when the
+//last photo was deleted
+void RemovePhotoCommand::redo()
+{
+    photo = album->remove_photo(index);
+    album->show_photo(qMin(index, album->photo_count() - 1));
+}
+
+void RemovePhotoCommand::undo()
+{
+    album->insert_photo(index, photo);
+    album->show_photo(index);
+}
+
+MovePhotoCommand::MovePhotoCommand(PhotoAlbum *album, int from, int to) :
+    album(album),
+    from(from),
+    to(to)
+{
+    setText(to > from ? "Move Forward" : "Move Backward");
+}
+
+void MovePhotoCommand::redo()
+{
+    album->insert_photo(to, album->remove_photo(from));
+    album->show_photo(to);
+}
+
+void MovePhotoCommand::undo()
+{
+    album->insert_photo(from, album->remove_photo(to));
+    album->show_photo(from);
+}
+
+RepairAlbumCommand::RepairAlbumCommand(PhotoAlbum *album, const QDomElement &before,
+                                       const QDomElement &after) :
+    album(album),
+    before(before),
+    after(after)
+{
+    setText("Repair Album");
+}
+
+void RepairAlbumCommand::redo()
+{
+    album->replace_album(after);
+}
+
+void RepairAlbumCommand::undo()
+{
+    album->replace_album(before);
+}
+
+EditRecipeCommand::EditRecipeCommand(PhotoAlbum *album, int index, const QDomElement &before,
+                                     const QDomElement &after, const QString &name) :
+    album(album),
+    index(index),
+    before(before),
+    after(after)
+{
+    setText(name);
+}
+
+void EditRecipeCommand::redo()
+{
+    album->set_photo_edits(index, after);
+}
+
+void EditRecipeCommand::undo()
+{
+    album->set_photo_edits(index, before);
+}
+
+EditPhotoCommand::EditPhotoCommand(PhotoAlbum *album, const QString &path, const QString &name,
+                                   const TiledImage &before, const TiledImage &after,
+                                   const QByteArray &before_file) :
+    album(album),
+    path(path),
+    before(before),
+    after(after),
+    before_file(before_file),
+    saved(true)
+{
+    setText(name);
+}
+
+void EditPhotoCommand::redo()
+{
+    if(saved)
+    {
+        saved = false;
+        return;
+    }
+    album->restore_photo(path, after);
+}
+
+void EditPhotoCommand::undo()
+{
+    if(before.is_null())
+        album->restore_photo_file(path, before_file);
+    else
+        album->restore_photo(path, before);
+}
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The undoable commands kept in the PhotoAlbum's undo history.
+//Album structure edits (adding, deleting and moving photos) and edits of a
+//photo's pixels share the same history, so Edit>Undo always reverts the
+//most recent change of either kind.
+//
+//Structure commands refer to photos by their position in the album, since
+//the <photo> elements themselves are removed and reinserted. Image edits
+//only change a photo's <edits> recipe, so they keep copies of it before and
+//after. Writing the edits into the photo's file keeps the photo before and
+//after as TiledImages, which share the tiles the edit did not change.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ALBUM_COMMANDS_H
+#define ALBUM_COMMANDS_H
+
+#include <QUndoCommand>
+#include <QDomElement>
+#include "tiled_image.h"
+
+class PhotoAlbum;
+
+//Inserts a <photo> element at index
+class InsertPhotoCommand : public QUndoCommand
+{
+public:
+    InsertPhotoCommand(PhotoAlbum *album, int index, const QDomElement &photo);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    int index;
+    QDomElement photo;
+};
+
+//Inserts many <photo> elements at index at once, as one step of the history
+class ImportPhotosCommand : public QUndoCommand
+{
+public:
+    ImportPhotosCommand(PhotoAlbum *album, int index, const QList<QDomElement> &photos);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    int index;
+    QList<QDomElement> photos;
+};
+
+//Removes the <photo> element at index
+class RemovePhotoCommand : public QUndoCommand
+{
+public:
+    RemovePhotoCommand(PhotoAlbum *album, int index);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    int index;
+    QDomElement photo; //The removed element, kept for undo
+};
+
+//Moves the <photo> element at from so that it ends up at index to
+class MovePhotoCommand : public QUndoCommand
+{
+public:
+    MovePhotoCommand(PhotoAlbum *album, int from, int to);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    int from;
+    int to;
+};
+
+//Replaces the whole album, for repairs that touch many photos at once. The
+//album before and after are kept as detached copies.
+class RepairAlbumCommand : public QUndoCommand
+{
+public:
+    RepairAlbumCommand(PhotoAlbum *album, const QDomElement &before, const QDomElement &after);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    QDomElement before;
+    QDomElement after;
+};
+
+//Replaces the <edits> of the photo at index
+class EditRecipeCommand : public QUndoCommand
+{
+public:
+    EditRecipeCommand(PhotoAlbum *album, int index, const QDomElement &before,
+                      const QDomElement &after, const QString &name);
+    void redo();
+    void undo();
+
+private:
+    PhotoAlbum *album;
+    int index;
+    QDomElement before; //Null when the photo had no edits
+    QDomElement after;
+};
+
+//Replaces the photo file at path. The first redo() does nothing, since the
+//edit has already been saved when the command is pushed. Photos too large
+//to hold in memory are undone from the file's earlier contents instead of
+//from tiles; before is null then.
+class EditPhotoCommand : public QUndoCommand
+{
+public:
+    EditPhotoCommand(PhotoAlbum *album, const QString &path, const QString &name,
+                     const TiledImage &before, const TiledImage &after,
+                     const QByteArray &before_file = QByteArray());
+    void redo();
+    void undo();
+
+    const TiledImage &before_image() const { return before; }
+    const TiledImage &after_image() const { return after; }
+
+private:
+    PhotoAlbum *album;
+    QString path;
+    TiledImage before;
+    TiledImage after;
+    QByteArray before_file;
+    bool saved; //True until the first redo()
+};
+
+#endif // ALBUM_COMMANDS_H
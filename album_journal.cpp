@@ -0,0 +1,426 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the AlbumJournal class declared in
+//album_journal.h. Elements are kept in the journal as XML text without any
+//indentation, and made back into elements of the album when replayed.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "album_journal.h"
+#include "album_shards.h"
+#include "trace.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+//Version written in the first line of every journal
+const int JournalVersion = 1;
+
+//Time after the first change of a burst before it is synced to the disk
+const int SyncDelayMs = 500;
+
+//Changes waiting to be written that make a sync happen right away
+const int MaxPendingEntries = 64;
+
+//Writes what Qt has buffered for file and waits for the system to put it
+//on the disk
+bool flush_to_disk(QFile &file)
+{
+    if(!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+//The first line of a journal for the album file at album_path
+QJsonObject header(const QString &album_path)
+{
+    QFileInfo info(album_path);
+    QJsonObject line;
+    line.insert("journal", JournalVersion);
+    line.insert("size", double(info.size()));
+    line.insert("modified", double(info.lastModified().toMSecsSinceEpoch()));
+    return line;
+}
+
+QByteArray to_line(const QJsonObject &entry)
+{
+    return QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n';
+}
+
+QString xml_text(const QDomNode &node)
+{
+    QString text;
+    QTextStream stream(&text);
+    node.save(stream, -1);
+    return text;
+}
+
+//Makes text back into an element belonging to album, or a null element if
+//it is not XML
+QDomElement parse_element(const QString &text, QDomDocument &album)
+{
+    QDomDocument document;
+    if(!document.setContent(text, true))
+        return QDomElement();
+    return album.importNode(document.documentElement(), true).toElement();
+}
+}
+
+AlbumJournal::AlbumJournal(QObject *parent) :
+    QObject(parent),
+    pending_count(0)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setInterval(SyncDelayMs);
+    connect(timer, SIGNAL(timeout()), this, SLOT(sync()));
+}
+
+AlbumJournal::~AlbumJournal()
+{
+    sync();
+}
+
+QString AlbumJournal::journal_path(const QString &album_path)
+{
+    return album_path + ".journal";
+}
+
+//Replays every whole line of the journal that follows a header matching
+//the album file. Replay stops at the first line that is torn or does not
+//apply, and the journal is cut back to the lines before it. The shards of
+//an interrupted save are put back before anything is replayed.
+int AlbumJournal::open(const QString &album_path, QDomDocument &album, AlbumShards *shards)
+{
+    TRACE_SCOPE("replay_journal", "load");
+
+    //Changes to the album open before were not saved on purpose
+    close();
+
+    QString path = journal_path(album_path);
+    QFile old(path);
+    qint64 good = 0;
+    int replayed = 0;
+    if(old.open(QFile::ReadOnly))
+    {
+        QByteArray first = old.readLine();
+        QJsonObject stamp = QJsonDocument::fromJson(first).object();
+        if(first.endsWith('\n') && stamp == header(album_path))
+        {
+            good = old.pos();
+            QList<QJsonObject> entries;
+            QList<qint64> ends; //Position after each entry
+            while(!old.atEnd())
+            {
+                QByteArray line = old.readLine();
+                QJsonParseError error;
+                QJsonDocument entry = QJsonDocument::fromJson(line, &error);
+                if(!line.endsWith('\n') || error.error != QJsonParseError::NoError)
+                    break;
+                entries.append(entry.object());
+                ends.append(old.pos());
+                if(entry.object().value("op").toString() == "save")
+                {
+                    QJsonArray paths = entry.object().value("shards").toArray();
+                    QStringList files;
+                    for(int i = 0; i < paths.size(); i++)
+                    {
+                        files.append(paths[i].toString());
+                    }
+                    AlbumShards::restore_backups(files);
+                }
+            }
+
+            for(int i = 0; i < entries.size(); i++)
+            {
+                if(!replay(entries[i], album, shards))
+                    break;
+                good = ends[i];
+                if(entries[i].value("op").toString() != "save")
+                    replayed++;
+            }
+        }
+        old.close();
+    }
+
+    //Keep adding to a journal that still applies, without any torn line
+    if(good > 0 && QFile::resize(path, good))
+    {
+        file.setFileName(path);
+        if(file.open(QFile::WriteOnly | QFile::Append))
+            return replayed;
+        qDebug() << "Cannot append to album journal" << path << file.errorString();
+        emit failed(path, file.errorString());
+    }
+
+    start(album_path);
+    return replayed;
+}
+
+void AlbumJournal::restart(const QString &album_path)
+{
+    QString old = file.fileName();
+    timer->stop();
+    pending.clear();
+    pending_count = 0;
+    file.close();
+    if(!old.isEmpty() && old != journal_path(album_path))
+        QFile::remove(old);
+    start(album_path);
+}
+
+void AlbumJournal::close()
+{
+    timer->stop();
+    pending.clear();
+    pending_count = 0;
+    if(!file.isOpen())
+        return;
+    file.close();
+    QFile::remove(file.fileName());
+}
+
+//Writes a new journal for the album file at album_path, replacing any
+//journal it had
+bool AlbumJournal::start(const QString &album_path)
+{
+    file.setFileName(journal_path(album_path));
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        qDebug() << "Cannot write album journal" << file.fileName() << file.errorString();
+        emit failed(file.fileName(), file.errorString());
+        return false;
+    }
+    file.write(to_line(header(album_path)));
+    flush_to_disk(file);
+    return true;
+}
+
+void AlbumJournal::sync()
+{
+    timer->stop();
+    if(pending.isEmpty() || !file.isOpen())
+        return;
+
+    TRACE_SCOPE("sync_journal", "save");
+    if(file.write(pending) != pending.size() || !flush_to_disk(file))
+    {
+        qDebug() << "Cannot write album journal" << file.fileName() << file.errorString();
+        emit failed(file.fileName(), file.errorString());
+    }
+    pending.clear();
+    pending_count = 0;
+}
+
+void AlbumJournal::record(const QJsonObject &entry)
+{
+    if(!file.isOpen())
+        return;
+
+    pending += to_line(entry);
+    pending_count++;
+    if(pending_count >= MaxPendingEntries)
+        sync();
+    else if(!timer->isActive())
+        timer->start();
+}
+
+void AlbumJournal::record_insert(int index, const QList<QDomElement> &photos)
+{
+    if(!file.isOpen())
+        return;
+
+    QJsonArray texts;
+    for(int i = 0; i < photos.size(); i++)
+    {
+        texts.append(xml_text(photos[i]));
+    }
+    QJsonObject entry;
+    entry.insert("op", QString("insert"));
+    entry.insert("index", index);
+    entry.insert("photos", texts);
+    record(entry);
+}
+
+void AlbumJournal::record_remove(int index, int count)
+{
+    QJsonObject entry;
+    entry.insert("op", QString("remove"));
+    entry.insert("index", index);
+    entry.insert("count", count);
+    record(entry);
+}
+
+//A null element records that the photo no longer has the tag
+void AlbumJournal::record_tag(int index, const QString &tag, const QDomElement &element)
+{
+    if(!file.isOpen())
+        return;
+
+    QJsonObject entry;
+    entry.insert("op", QString("set"));
+    entry.insert("index", index);
+    entry.insert("tag", tag);
+    if(!element.isNull())
+        entry.insert("xml", xml_text(element));
+    record(entry);
+}
+
+//Kept by file rather than position, since metadata is read in the
+//background while photos move. Every photo of a file has the same metadata.
+void AlbumJournal::record_fill(const QString &file, const QString &tag, const QString &text)
+{
+    QJsonObject entry;
+    entry.insert("op", QString("fill"));
+    entry.insert("file", file);
+    entry.insert("tag", tag);
+    entry.insert("text", text);
+    record(entry);
+}
+
+void AlbumJournal::record_album(const QDomElement &album)
+{
+    if(!file.isOpen())
+        return;
+
+    QJsonObject entry;
+    entry.insert("op", QString("album"));
+    entry.insert("xml", xml_text(album));
+    record(entry);
+}
+
+void AlbumJournal::record_save(const QStringList &paths)
+{
+    if(!file.isOpen() || paths.isEmpty())
+        return;
+
+    QJsonObject entry;
+    entry.insert("op", QString("save"));
+    entry.insert("shards", QJsonArray::fromStringList(paths));
+    record(entry);
+    sync();
+}
+
+//Makes the change entry records to album, the way PhotoAlbum made it.
+//Returns false if the entry does not apply.
+bool AlbumJournal::replay(const QJsonObject &entry, QDomDocument &album, AlbumShards *shards)
+{
+    QString op = entry.value("op").toString();
+    QDomElement root = album.documentElement();
+    int index = entry.value("index").toInt();
+
+    //The shards were put back before replay began
+    if(op == "save")
+        return true;
+
+    if(op == "insert")
+    {
+        QDomElement next = shards->insertion_point(index);
+        QJsonArray texts = entry.value("photos").toArray();
+        for(int i = 0; i < texts.size(); i++)
+        {
+            QDomElement photo = parse_element(texts[i].toString(), album);
+            if(photo.isNull())
+                return false;
+            if(next.isNull())
+                root.appendChild(photo);
+            else
+                root.insertBefore(photo, next);
+            shards->mark_dirty(photo);
+        }
+        return true;
+    }
+
+    if(op == "remove")
+    {
+        QDomElement photo = shards->photo_at(index);
+        if(photo.isNull())
+            return false;
+        int count = entry.value("count").toInt();
+        for(int i = 0; i < count && !photo.isNull(); i++)
+        {
+            QDomElement next = shards->next_photo(photo);
+            shards->mark_dirty(photo);
+            root.removeChild(photo);
+            photo = next;
+        }
+        return true;
+    }
+
+    if(op == "set")
+    {
+        QDomElement photo = shards->photo_at(index);
+        if(photo.isNull())
+            return false;
+        QDomElement old = photo.firstChildElement(entry.value("tag").toString());
+        QDomElement element;
+        if(entry.contains("xml"))
+        {
+            element = parse_element(entry.value("xml").toString(), album);
+            if(element.isNull())
+                return false;
+        }
+        if(!old.isNull() && !element.isNull())
+            photo.replaceChild(element, old);
+        else if(!old.isNull())
+            photo.removeChild(old);
+        else if(!element.isNull())
+            photo.appendChild(element);
+        shards->mark_dirty(photo);
+        return true;
+    }
+
+    if(op == "fill")
+    {
+        QString path = entry.value("file").toString();
+        QString tag = entry.value("tag").toString();
+        shards->load_all();
+        QDomElement photo = root.firstChildElement("photo");
+        for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+        {
+            QDomElement element = photo.firstChildElement(tag);
+            if(photo.firstChildElement("file").text() != path || element.isNull()
+                    || !element.text().trimmed().isEmpty())
+                continue;
+            while(element.hasChildNodes())
+            {
+                element.removeChild(element.firstChild());
+            }
+            element.appendChild(album.createTextNode(entry.value("text").toString()));
+            shards->mark_dirty(photo);
+        }
+        return true;
+    }
+
+    if(op == "album")
+    {
+        QDomElement element = parse_element(entry.value("xml").toString(), album);
+        if(element.isNull())
+            return false;
+        album.replaceChild(element, root);
+        shards->mark_all_dirty();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The AlbumJournal class, which keeps the changes made to an
+//open album since it was last saved in a file next to it, so they survive a
+//crash. The journal is the album's path with ".journal" added, and holds one
+//line of JSON per change:
+//
+//  {"journal":1,"size":20417,"modified":1792392000000}
+//  {"op":"insert","index":12,"photos":["<photo>...</photo>"]}
+//  {"op":"remove","index":3,"count":2}
+//  {"op":"set","index":5,"tag":"description","xml":"<description>...</description>"}
+//  {"op":"fill","file":"/photos/a.jpg","tag":"date","text":"2026:07:04"}
+//  {"op":"album","xml":"<album>...</album>"}
+//  {"op":"save","shards":["/photos/2026.xml"]}
+//
+//The first line is the size and modification time of the album file the
+//changes apply to; a journal whose album has since changed is thrown away.
+//A save line is written before a save replaces any of the album's shards.
+//If the album file is then not replaced too, opening it puts the shards
+//named back from the files AlbumShards kept aside, so the changes before
+//the save line are made to the shards they were made to, not again.
+//Photos are named by their position, as the undo commands do, and a change
+//costs the size of the photos it touches, not of the album.
+//
+//Lines are buffered and written together, and the file is only synced to
+//the disk a short moment after a burst of changes, or once enough are
+//waiting. A crash can lose the last moment's changes but never leaves the
+//journal unreadable: a torn last line is dropped when the album is opened
+//again. Saving the album starts the journal over.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ALBUM_JOURNAL_H
+#define ALBUM_JOURNAL_H
+
+#include <QObject>
+#include <QDomDocument>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+class AlbumShards;
+class QJsonObject;
+class QTimer;
+
+class AlbumJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AlbumJournal(QObject *parent = 0);
+    ~AlbumJournal();
+
+    //Path of the journal of the album at album_path
+    static QString journal_path(const QString &album_path);
+
+    //Starts journaling changes to album, just read from album_path. Changes
+    //left in the album's journal by a session that did not end are made to
+    //album first, reading its shards as they are reached and marking them
+    //dirty; returns how many there were.
+    int open(const QString &album_path, QDomDocument &album, AlbumShards *shards);
+
+    //Starts the journal over for the album just saved to album_path,
+    //removing the journal of the album's previous path
+    void restart(const QString &album_path);
+
+    //Stops journaling and removes the journal, since its changes were
+    //deliberately not saved
+    void close();
+
+    bool is_open() const { return file.isOpen(); }
+
+    //Records a change the album has just had made to it
+    void record_insert(int index, const QList<QDomElement> &photos);
+    void record_remove(int index, int count);
+    void record_tag(int index, const QString &tag, const QDomElement &element);
+    void record_fill(const QString &file, const QString &tag, const QString &text);
+    void record_album(const QDomElement &album);
+
+    //Records that the shards at paths are about to be replaced, and makes
+    //sure it is on the disk before they are
+    void record_save(const QStringList &paths);
+
+signals:
+    //The journal cannot be written, so changes may not survive a crash
+    void failed(QString path, QString error);
+
+public slots:
+    //Writes the waiting lines and makes sure they are on the disk
+    void sync();
+
+private:
+    void record(const QJsonObject &entry);
+    bool start(const QString &album_path);
+    static bool replay(const QJsonObject &entry, QDomDocument &album, AlbumShards *shards);
+
+    QFile file;
+    QByteArray pending; //Lines not yet written
+    int pending_count;
+    QTimer *timer;
+};
+
+#endif // ALBUM_JOURNAL_H
@@ -0,0 +1,472 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the AlbumShards class declared in
+//album_shards.h. An <include> whose shard has been read carries a loaded
+//attribute, which is only kept in memory, so copies of the album made for
+//the undo history know which of their shards' photos they hold. It is
+//"failed" for a shard that could not be read, which is never written.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "album_shards.h"
+#include "trace.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+const char *const AlbumShards::IncludeTag = "include";
+const char *const AlbumShards::EndTag = "include_end";
+
+namespace
+{
+//Writes document to a temporary file beside path, which is only renamed
+//over path once committed. Returns NULL and sets *error if it cannot.
+QSaveFile *prepare_document(const QDomDocument &document, const QString &path, int indent,
+                            QString *error)
+{
+    QSaveFile *file = new QSaveFile(path);
+    if(file->open(QIODevice::WriteOnly))
+    {
+        QTextStream stream(file);
+        document.save(stream, indent);
+        stream.flush();
+        if(file->error() == QFileDevice::NoError)
+            return file;
+    }
+    *error = "Cannot write " + path + ": " + file->errorString();
+    delete file;
+    return NULL;
+}
+}
+
+AlbumShards::AlbumShards(QObject *parent) :
+    QObject(parent),
+    album(NULL)
+{
+}
+
+AlbumShards::~AlbumShards()
+{
+    cancel();
+}
+
+void AlbumShards::set_album(const QString &album_path, QDomDocument *album)
+{
+    this->album = album;
+    directory = QFileInfo(album_path).absolutePath();
+    dirty.clear();
+}
+
+bool AlbumShards::is_unread(const QDomElement &element)
+{
+    return element.tagName() == IncludeTag && !element.hasAttribute("loaded");
+}
+
+bool AlbumShards::is_loaded(const QDomElement &element)
+{
+    return element.tagName() == IncludeTag && element.attribute("loaded") == "true";
+}
+
+int AlbumShards::unread_count(const QDomElement &include)
+{
+    return qMax(include.attribute("photos").toInt(), 0);
+}
+
+QString AlbumShards::shard_path(const QDomElement &include) const
+{
+    return QDir(directory).absoluteFilePath(include.attribute("file"));
+}
+
+int AlbumShards::photo_count() const
+{
+    int count = 0;
+    QDomElement element = album->documentElement().firstChildElement();
+    for(; !element.isNull(); element = element.nextSiblingElement())
+    {
+        if(element.tagName() == "photo")
+            count++;
+        else if(is_unread(element))
+            count += unread_count(element);
+    }
+    return count;
+}
+
+int AlbumShards::photo_index(const QDomElement &photo) const
+{
+    int index = 0;
+    QDomElement element = album->documentElement().firstChildElement();
+    for(; !element.isNull(); element = element.nextSiblingElement())
+    {
+        if(element == photo)
+            return index;
+        if(element.tagName() == "photo")
+            index++;
+        else if(is_unread(element))
+            index += unread_count(element);
+    }
+    return -1;
+}
+
+QDomElement AlbumShards::photo_at(int index)
+{
+    int i = 0;
+    QDomElement element = album->documentElement().firstChildElement();
+    for(; !element.isNull(); element = element.nextSiblingElement())
+    {
+        if(element.tagName() == "photo")
+        {
+            if(i == index)
+                return element;
+            i++;
+        }
+        else if(is_unread(element))
+        {
+            //Reading the shard puts its photos right after element
+            if(index < i + unread_count(element))
+                load(element);
+            else
+                i += unread_count(element);
+        }
+    }
+    return QDomElement();
+}
+
+QDomElement AlbumShards::next_photo(const QDomElement &photo)
+{
+    QDomElement element = photo.nextSiblingElement();
+    for(; !element.isNull(); element = element.nextSiblingElement())
+    {
+        if(element.tagName() == "photo")
+            return element;
+        if(is_unread(element))
+            load(element);
+    }
+    return QDomElement();
+}
+
+QDomElement AlbumShards::previous_photo(const QDomElement &photo)
+{
+    QDomElement element = photo.previousSiblingElement();
+    while(!element.isNull())
+    {
+        if(element.tagName() == "photo")
+            return element;
+        if(is_unread(element))
+        {
+            //The shard's photos now lie between it and photo
+            load(element);
+            element = photo.previousSiblingElement();
+            continue;
+        }
+        element = element.previousSiblingElement();
+    }
+    return QDomElement();
+}
+
+//Photos inserted where a shard's photos end go into the shard, before its
+//<include_end/>, so a shard's last photo removed and put back returns to it
+QDomElement AlbumShards::insertion_point(int index)
+{
+    QDomElement next = photo_at(index);
+    QDomElement element;
+    if(index == 0)
+        element = album->documentElement().firstChildElement();
+    else
+        element = photo_at(index - 1).nextSiblingElement();
+
+    for(; !element.isNull() && element != next; element = element.nextSiblingElement())
+    {
+        //A shard that could not be read never gets photos, as it is never
+        //written
+        QDomElement include = element.previousSiblingElement();
+        if(element.tagName() == EndTag
+           && !(include.tagName() == IncludeTag && include.attribute("loaded") == "failed"))
+            return element;
+    }
+    return next;
+}
+
+int AlbumShards::find_photo(const QString &path) const
+{
+    int index = 0;
+    QDomElement element = album->documentElement().firstChildElement();
+    for(; !element.isNull(); element = element.nextSiblingElement())
+    {
+        if(element.tagName() == "photo")
+        {
+            if(element.firstChildElement("file").text() == path)
+                return index;
+            index++;
+        }
+        else if(is_unread(element))
+        {
+            index += unread_count(element);
+        }
+    }
+    return -1;
+}
+
+void AlbumShards::load_all()
+{
+    QDomElement element = album->documentElement().firstChildElement(IncludeTag);
+    for(; !element.isNull(); element = element.nextSiblingElement(IncludeTag))
+    {
+        if(is_unread(element))
+            load(element);
+    }
+}
+
+//Puts the photos of the shard named by include into the album after it
+void AlbumShards::load(QDomElement include)
+{
+    TRACE_SCOPE("load_shard", "load");
+
+    QString path = shard_path(include);
+    QDomElement end = album->createElement(EndTag);
+    include.parentNode().insertAfter(end, include);
+
+    //A shard that cannot be read is left out rather than read again on
+    //every step, and its file is left as it is
+    QFile file(path);
+    QDomDocument shard;
+    QString error;
+    int line = 0;
+    if(!file.open(QIODevice::ReadOnly) || !shard.setContent(&file, true, &error, &line))
+    {
+        if(error.isEmpty())
+            error = file.errorString();
+        else
+            error = QString("%1 at line %2").arg(error).arg(line);
+        include.setAttribute("loaded", "failed");
+        emit load_failed(path, error);
+        return;
+    }
+
+    include.setAttribute("loaded", "true");
+    QStringList files;
+    QDomElement photo = shard.documentElement().firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        QDomNode copy = album->importNode(photo, true);
+        include.parentNode().insertBefore(copy, end);
+        files.append(photo.firstChildElement("file").text());
+    }
+    emit loaded(path, files, files.size() != unread_count(include));
+}
+
+//The shard holding photo is the <include> before it, unless an
+//<include_end/> or an unread include comes first
+void AlbumShards::mark_dirty(const QDomElement &photo)
+{
+    QDomElement element = photo.previousSiblingElement();
+    for(; !element.isNull(); element = element.previousSiblingElement())
+    {
+        if(element.tagName() == EndTag)
+            return;
+        if(element.tagName() == IncludeTag)
+        {
+            if(is_loaded(element))
+                dirty.insert(shard_path(element));
+            return;
+        }
+    }
+}
+
+void AlbumShards::mark_all_dirty()
+{
+    QDomElement element = album->documentElement().firstChildElement(IncludeTag);
+    for(; !element.isNull(); element = element.nextSiblingElement(IncludeTag))
+    {
+        if(is_loaded(element))
+            dirty.insert(shard_path(element));
+    }
+}
+
+bool AlbumShards::save(QIODevice *device, const QString &album_path, int indent, QString *error)
+{
+    cancel();
+    QDomElement root = album->documentElement();
+    QDir new_directory = QFileInfo(album_path).absoluteDir();
+    prepared_directory = new_directory.absolutePath();
+
+    //An album without shards is written as it is
+    if(root.firstChildElement(IncludeTag).isNull())
+    {
+        QTextStream out(device);
+        album->save(out, indent);
+        return true;
+    }
+
+    TRACE_SCOPE("save_shards", "save");
+
+    //The manifest keeps everything but the photos read from shards
+    QDomDocument manifest;
+    for(QDomNode node = album->firstChild(); !node.isNull() && node != root;
+        node = node.nextSibling())
+    {
+        manifest.appendChild(manifest.importNode(node, true));
+    }
+    QDomElement manifest_root = manifest.importNode(root, false).toElement();
+    manifest.appendChild(manifest_root);
+
+    for(QDomNode node = root.firstChild(); !node.isNull(); node = node.nextSibling())
+    {
+        QDomElement element = node.toElement();
+        if(element.tagName() == EndTag)
+            continue;
+        if(element.tagName() != IncludeTag)
+        {
+            manifest_root.appendChild(manifest.importNode(node, true));
+            continue;
+        }
+
+        QString path = shard_path(element);
+        int count = unread_count(element);
+        if(is_loaded(element))
+        {
+            //Gather the shard's photos, writing them out if they changed
+            bool write = dirty.contains(path);
+            QDomDocument contents;
+            QDomElement shard_root = contents.createElement("album");
+            contents.appendChild(shard_root);
+            count = 0;
+            for(node = node.nextSibling(); !node.isNull(); node = node.nextSibling())
+            {
+                if(node.toElement().tagName() == EndTag)
+                    break;
+                if(node.toElement().tagName() == "photo")
+                    count++;
+                if(write)
+                    shard_root.appendChild(contents.importNode(node, true));
+            }
+            if(write)
+            {
+                QSaveFile *file = prepare_document(contents, path, indent, error);
+                if(file == NULL)
+                {
+                    cancel();
+                    return false;
+                }
+                prepared.append(file);
+
+                //A file left aside by an earlier save that got as far as
+                //the album is out of date
+                QFile::remove(backup_path(path));
+            }
+        }
+
+        Include update = {element, new_directory.relativeFilePath(path), count};
+        prepared_includes.append(update);
+        QDomElement include = manifest.createElement(IncludeTag);
+        include.setAttribute("file", update.file);
+        include.setAttribute("photos", count);
+        manifest_root.appendChild(include);
+
+        if(node.isNull())
+            break;
+    }
+
+    QTextStream out(device);
+    manifest.save(out, indent);
+    return true;
+}
+
+QString AlbumShards::backup_path(const QString &path)
+{
+    return path + ".previous";
+}
+
+void AlbumShards::restore_backups(const QStringList &paths)
+{
+    for(int i = 0; i < paths.size(); i++)
+    {
+        QString backup = backup_path(paths[i]);
+        if(!QFile::exists(backup))
+            continue;
+        QFile::remove(paths[i]);
+        QFile::rename(backup, paths[i]);
+    }
+}
+
+QStringList AlbumShards::prepared_paths() const
+{
+    QStringList paths;
+    for(int i = 0; i < prepared.size(); i++)
+    {
+        paths.append(prepared[i]->fileName());
+    }
+    return paths;
+}
+
+//Shards are put in place in album order, each after moving its file aside
+bool AlbumShards::commit(QString *error)
+{
+    TRACE_SCOPE("commit_shards", "save");
+
+    while(!prepared.isEmpty())
+    {
+        QSaveFile *file = prepared.takeFirst();
+        QString path = file->fileName();
+        bool moved = !QFile::exists(path) || QFile::rename(path, backup_path(path));
+        if(moved)
+            committed.append(path);
+        bool replaced = moved && file->commit();
+        if(!moved)
+            *error = "Cannot move " + path + " aside to replace it";
+        else if(!replaced)
+            *error = "Cannot write " + path + ": " + file->errorString();
+        delete file;
+        if(!replaced)
+        {
+            roll_back();
+            return false;
+        }
+    }
+    return true;
+}
+
+//The include attributes and the directory are updated together, so paths
+//keep resolving to the same shards
+void AlbumShards::finish()
+{
+    for(int i = 0; i < committed.size(); i++)
+    {
+        QFile::remove(backup_path(committed[i]));
+        dirty.remove(committed[i]);
+    }
+    committed.clear();
+
+    for(int i = 0; i < prepared_includes.size(); i++)
+    {
+        QDomElement element = prepared_includes[i].element;
+        element.setAttribute("file", prepared_includes[i].file);
+        element.setAttribute("photos", prepared_includes[i].count);
+    }
+    prepared_includes.clear();
+    directory = prepared_directory;
+}
+
+//A shard that had no file before is removed again
+void AlbumShards::roll_back()
+{
+    for(int i = 0; i < committed.size(); i++)
+    {
+        QFile::remove(committed[i]);
+        QFile::rename(backup_path(committed[i]), committed[i]);
+    }
+    committed.clear();
+    cancel();
+}
+
+void AlbumShards::cancel()
+{
+    //Deleting an uncommitted QSaveFile removes its temporary file
+    qDeleteAll(prepared);
+    prepared.clear();
+    prepared_includes.clear();
+}
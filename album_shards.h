@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The AlbumShards class, which lets an album keep its photos in
+//other album files, e.g. one per year, so a library of millions of photos
+//opens without reading them all. The album names each such shard with an
+//<include> element where its photos belong:
+//
+//  <album>
+//      <include file="2025.xml" photos="48211"/>
+//      <include file="2026.xml" photos="30954"/>
+//      <photo>...</photo>
+//  </album>
+//
+//file is relative to the album's directory, and photos is how many photos
+//the shard held when the album was last saved. A shard is an ordinary
+//album of <photo> elements; its own includes are not followed.
+//
+//A shard is read the first time a photo in it is asked for: its photos are
+//put into the album's document right after the <include>, followed by an
+//<include_end/> marker, so the rest of the application sees one list of
+//photos. Until then the shard counts as its photos count, so the position
+//of every photo stays the same as shards are read and the undo history and
+//journal can keep referring to photos by position.
+//
+//Changes to a shard's photos mark it dirty. Saving writes the album itself
+//as a manifest without the shards' photos, and rewrites only the shards
+//that are dirty. Every shard is written in full to a temporary file before
+//any of them replaces its file, so a shard that cannot be written leaves
+//every file as it was. The files the shards replace are kept aside until
+//the album itself is in place, so a save that fails after some of them, or
+//a crash in the middle of one, can put them back: the album file and its
+//shards always go together.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ALBUM_SHARDS_H
+#define ALBUM_SHARDS_H
+
+#include <QObject>
+#include <QDomDocument>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+
+class QIODevice;
+class QSaveFile;
+
+class AlbumShards : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Tags of the element naming a shard, and of the marker after its photos
+    static const char *const IncludeTag;
+    static const char *const EndTag;
+
+    explicit AlbumShards(QObject *parent = 0);
+    ~AlbumShards();
+
+    //Works on album, read from album_path, from now on. No shard is read.
+    void set_album(const QString &album_path, QDomDocument *album);
+
+    //The photos of the album by position, as PhotoAlbum counts them. A
+    //shard holding the photo asked for, or passed on the way, is read.
+    int photo_count() const;
+    int photo_index(const QDomElement &photo) const;
+    QDomElement photo_at(int index);
+    QDomElement next_photo(const QDomElement &photo);
+    QDomElement previous_photo(const QDomElement &photo);
+
+    //Returns the element a photo inserted at index goes before, or a null
+    //element if it goes at the end of the album
+    QDomElement insertion_point(int index);
+
+    //Returns the position of the first photo already read whose file is
+    //path, or -1
+    int find_photo(const QString &path) const;
+
+    //Reads every shard not read yet, for work on the whole album
+    void load_all();
+
+    //Notes that photo, which is in the album, was added or changed, or is
+    //about to be removed
+    void mark_dirty(const QDomElement &photo);
+    void mark_all_dirty();
+
+    //Writes the album to device, about to be saved at album_path, with
+    //only the includes of its shards, and writes every dirty shard to a
+    //temporary file beside its own. Includes are made relative to
+    //album_path's directory. Returns false and sets *error if a shard
+    //cannot be written. Nothing is marked saved until commit().
+    bool save(QIODevice *device, const QString &album_path, int indent, QString *error);
+
+    //Paths of the shards save() wrote, which commit() is about to replace
+    QStringList prepared_paths() const;
+
+    //Puts the shards written by save() in place of their files, before the
+    //album itself is. The files they replace are kept at backup_path().
+    //Returns false and sets *error if one cannot be, with the shards already
+    //replaced put back.
+    bool commit(QString *error);
+
+    //Marks the shards put in place by commit() saved and removes the files
+    //they replaced, once the album itself is saved
+    void finish();
+
+    //Puts back the files the shards put in place by commit() replaced, for
+    //an album that could not be saved after all
+    void roll_back();
+
+    //Drops the shards written by save() without touching their files
+    void cancel();
+
+    //Where commit() keeps the file a shard at path replaces
+    static QString backup_path(const QString &path);
+
+    //Puts back the files kept aside for the shards at paths, after a save
+    //that was interrupted before the album was written
+    static void restore_backups(const QStringList &paths);
+
+signals:
+    //A shard was read. count_changed is true if it did not hold as many
+    //photos as the album said, which moved the photos after it.
+    void loaded(QString path, QStringList files, bool count_changed);
+
+    //A shard could not be read. It holds no photos from now on, which moves
+    //the photos after it.
+    void load_failed(QString path, QString error);
+
+private:
+    static bool is_unread(const QDomElement &element);
+    static bool is_loaded(const QDomElement &element);
+    static int unread_count(const QDomElement &include);
+
+    QString shard_path(const QDomElement &include) const;
+    void load(QDomElement include);
+
+    //What commit() sets an include's attributes to
+    struct Include
+    {
+        QDomElement element;
+        QString file;
+        int count;
+    };
+
+    QDomDocument *album;
+    QString directory;   //Of the album file, which include paths start from
+    QSet<QString> dirty; //Paths of the shards changed since they were saved
+    QList<QSaveFile *> prepared;   //Shards written by save(), not yet in place
+    QStringList committed;         //Shards put in place, their files kept aside
+    QList<Include> prepared_includes;
+    QString prepared_directory;
+};
+
+#endif // ALBUM_SHARDS_H
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the AlbumWatcher class declared in
+//album_watcher.h. QFileSystemWatcher stops watching a file that is deleted
+//or replaced by a rename, which is how most programs save, so every flush
+//adds back the watched files that exist again.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "album_watcher.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+namespace
+{
+//Quiet time after the last event before changes are reported
+const int CoalesceMs = 300;
+
+//Files watched individually; directories are always watched
+const int MaxWatchedFiles = 4096;
+}
+
+AlbumWatcher::AlbumWatcher(QObject *parent) :
+    QObject(parent),
+    album_pending(false)
+{
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, SIGNAL(fileChanged(QString)), this, SLOT(file_changed(QString)));
+    connect(watcher, SIGNAL(directoryChanged(QString)), this, SLOT(directory_changed(QString)));
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setInterval(CoalesceMs);
+    connect(timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+AlbumWatcher::Stamp AlbumWatcher::stamp(const QString &path)
+{
+    QFileInfo info(path);
+    Stamp result = {-1, 0};
+    if(info.exists())
+    {
+        result.size = info.size();
+        result.modified = info.lastModified().toMSecsSinceEpoch();
+    }
+    return result;
+}
+
+void AlbumWatcher::clear()
+{
+    timer->stop();
+    if(!watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+    if(!watcher->directories().isEmpty())
+        watcher->removePaths(watcher->directories());
+
+    album.clear();
+    stamps.clear();
+    watched_files.clear();
+    directories.clear();
+    pending.clear();
+    album_pending = false;
+}
+
+void AlbumWatcher::set_album(const QString &album_path, const QStringList &files)
+{
+    clear();
+
+    album = album_path;
+    if(!album.isEmpty() && QFileInfo(album).exists())
+    {
+        watcher->addPath(album);
+        stamps.insert(album, stamp(album));
+    }
+
+    for(int i = 0; i < files.size(); i++)
+    {
+        track(files[i], i < MaxWatchedFiles);
+    }
+}
+
+void AlbumWatcher::add_file(const QString &path)
+{
+    track(path, watched_files.size() < MaxWatchedFiles);
+}
+
+void AlbumWatcher::watch(const QString &path)
+{
+    track(path, true);
+}
+
+//Starts tracking path if it is not tracked yet
+void AlbumWatcher::track(const QString &path, bool watch_file)
+{
+    if(path.isEmpty())
+        return;
+
+    if(!stamps.contains(path))
+    {
+        stamps.insert(path, stamp(path));
+
+        QString directory = QFileInfo(path).absolutePath();
+        if(!directories.contains(directory))
+            watcher->addPath(directory);
+        directories[directory].append(path);
+    }
+
+    if(watch_file && !watched_files.contains(path) && QFileInfo(path).exists())
+    {
+        watcher->addPath(path);
+        watched_files.insert(path);
+    }
+}
+
+void AlbumWatcher::note_written(const QString &path)
+{
+    if(stamps.contains(path))
+        stamps.insert(path, stamp(path));
+}
+
+void AlbumWatcher::file_changed(const QString &path)
+{
+    if(path == album)
+        album_pending = true;
+    else
+        pending.insert(path);
+    schedule();
+}
+
+//Something in directory was created, deleted or renamed. Any tracked file
+//in it may have been replaced.
+void AlbumWatcher::directory_changed(const QString &directory)
+{
+    const QStringList files = directories.value(directory);
+    for(int i = 0; i < files.size(); i++)
+    {
+        pending.insert(files[i]);
+    }
+    if(!album.isEmpty() && QFileInfo(album).absolutePath() == directory)
+        album_pending = true;
+    schedule();
+}
+
+//Restarts the quiet period, so a burst of events is reported once
+void AlbumWatcher::schedule()
+{
+    timer->start();
+}
+
+void AlbumWatcher::flush()
+{
+    QStringList changed;
+
+    //Files deleted or replaced have silently been dropped by the watcher
+    watched_files.clear();
+    const QStringList files = watcher->files();
+    for(int i = 0; i < files.size(); i++)
+    {
+        watched_files.insert(files[i]);
+    }
+
+    for(QSet<QString>::const_iterator it = pending.constBegin(); it != pending.constEnd(); ++it)
+    {
+        if(!stamps.contains(*it))
+            continue;
+        Stamp now = stamp(*it);
+
+        //A file replaced by a rename has to be watched again, even when
+        //this application did the rename and the change is not reported
+        if(now.size >= 0 && !watched_files.contains(*it) && watched_files.size() < MaxWatchedFiles)
+        {
+            watcher->addPath(*it);
+            watched_files.insert(*it);
+        }
+
+        if(stamps.value(*it) == now)
+            continue;
+        stamps.insert(*it, now);
+        changed.append(*it);
+    }
+    pending.clear();
+
+    if(album_pending)
+    {
+        album_pending = false;
+        Stamp now = stamp(album);
+        if(now.size >= 0 && !watched_files.contains(album))
+        {
+            watcher->addPath(album);
+            watched_files.insert(album);
+        }
+        if(!(stamps.value(album) == now))
+        {
+            stamps.insert(album, now);
+            emit album_changed();
+        }
+    }
+
+    if(!changed.isEmpty())
+        emit files_changed(changed);
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The AlbumWatcher class, which notices when the album XML or
+//the photo files it refers to are changed by another program, so cached
+//decodes, tiles and hashes of those files can be dropped.
+//
+//Events are coalesced: a burst of changes (an editor saving a file in
+//several steps, or a batch tool touching many files) is reported once, a
+//short moment after the burst ends. A file only counts as changed if its
+//size or modification time differ from what was last seen, which also
+//filters out the application's own saves once they are noted with
+//note_written().
+//
+//The directories holding the photos are always watched, which catches
+//files being replaced, renamed or deleted. The files themselves are watched
+//up to a limit, to stay within the system's watch quota on large albums;
+//watch() makes sure a particular file is, e.g. the one on screen.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ALBUM_WATCHER_H
+#define ALBUM_WATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+class AlbumWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AlbumWatcher(QObject *parent = 0);
+
+    //Starts watching the album file and the photo files it refers to,
+    //replacing anything watched before
+    void set_album(const QString &album_path, const QStringList &files);
+    void clear();
+
+    //Adds a photo file added to the album
+    void add_file(const QString &path);
+
+    //Watches path itself even past the file limit
+    void watch(const QString &path);
+
+    //Records a change made by this application so it is not reported
+    void note_written(const QString &path);
+
+signals:
+    void files_changed(QStringList paths);
+    void album_changed();
+
+private slots:
+    void file_changed(const QString &path);
+    void directory_changed(const QString &directory);
+    void flush();
+
+private:
+    //Size and modification time, or a size of -1 for a missing file
+    struct Stamp
+    {
+        qint64 size;
+        qint64 modified;
+        bool operator==(const Stamp &other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    static Stamp stamp(const QString &path);
+    void track(const QString &path, bool watch_file);
+    void schedule();
+
+    QFileSystemWatcher *watcher;
+    QTimer *timer;                      //Fires once a burst of events is over
+    QString album;
+    QHash<QString, Stamp> stamps;       //Last seen state of every file
+    QHash<QString, QStringList> directories; //Tracked files by directory
+    QSet<QString> watched_files;        //Files watched individually
+    QSet<QString> pending;              //Files with events since the last flush
+    bool album_pending;
+};
+
+#endif // ALBUM_WATCHER_H
@@ -9,6 +9,10 @@
 //made to fit this application's needs, namely the change_image() function
 //to allow us to change what image the Cropper window was showing. We also
 //added a signal emission when the user released the mouseclick.
+//
+//The Cropper never decodes the photo itself: it is handed the image the
+//main window already has in memory and shows it upright and at most screen
+//sized, mapping the rubber band back to full resolution stored coordinates.
 ///////////////////////////////////////////////////////////////////////////////
 
 /*
@@ -25,25 +29,56 @@ Modifications:
 #include <cstdlib>
 #include <QtGui>
 #include "crop.h"
+#include "exif_reader.h"
 #include "photoalbum.h"
+#include "trace.h"
+#include "image_buffers.h"
 
 Cropper::Cropper( QString fileName )
+    : scale_x( 1.0 ), scale_y( 1.0 )
 {
     QImage image( fileName );
-    
+    full_size = image.size();
+
     setPixmap( QPixmap::fromImage( image ) );
     setWindowTitle( tr( "Image Cropper" ) );
 
     rubberBand = new QRubberBand( QRubberBand::Rectangle, this );
 }
 
-//This changes the image displayed in the Cropper window
-void Cropper::change_image(QString path)
+//This changes the image displayed in the Cropper window. image may be the
+//full resolution photo or any smaller proxy of it, in stored pixels;
+//full_size is the stored size of the full resolution photo that crop
+//rectangles are reported against, and orientation its EXIF orientation.
+void Cropper::change_image( const QImage &image, const QSize &photo_size, int orientation )
 {
-    QImage image( path );
-    resize(image.width(), image.height()); //Resize to image dimensions
+    TRACE_SCOPE("crop_show", "scale");
 
-    setPixmap( QPixmap::fromImage( image ) );
+    full_size = photo_size;
+    QTransform upright = QImage::trueMatrix( ExifReader::transform( orientation ),
+                                             full_size.width(), full_size.height() );
+    to_stored = upright.inverted();
+
+    //Show the image upright and no larger than most of the screen, scaling
+    //it before turning it so only the smaller copy is turned
+    QSize max_size = ExifReader::upright_size(
+        QGuiApplication::primaryScreen()->availableSize() * 0.8, orientation );
+    QImage shown = image;
+    if ( image.width() > max_size.width() || image.height() > max_size.height() )
+        shown = image.scaled( max_size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+    if ( orientation != 1 )
+        shown = shown.transformed( ExifReader::transform( orientation ) );
+
+    QSize upright_size = ExifReader::upright_size( full_size, orientation );
+    scale_x = double( upright_size.width() ) / shown.width();
+    scale_y = double( upright_size.height() ) / shown.height();
+
+    resize(shown.width(), shown.height()); //Resize to shown dimensions
+
+    setPixmap( QPixmap::fromImage( shown ) );
+
+    //Account for the pixmap's buffer alongside the main window's images
+    ImageBufferManager::instance()->track_bytes( "Cropper", qint64( shown.width() ) * shown.height() * 4 );
 }
 
 // print button and location of mouse clicks
@@ -67,8 +102,15 @@ void Cropper::mouseReleaseEvent( QMouseEvent *event )
     setPixmap( pixmap()->copy(crop_area));
     setGeometry(crop_area);
 
+    //Map the selection from shown pixels back to upright full resolution
+    //pixels, then turn it back into the stored pixels the edits work on
+    QRectF upright_area( crop_area.x() * scale_x, crop_area.y() * scale_y,
+                         crop_area.width() * scale_x, crop_area.height() * scale_y );
+    QRect full_area = to_stored.mapRect( upright_area ).toRect();
+    full_area &= QRect( QPoint( 0, 0 ), full_size );
+
     //Send signal that photo has been cropped and pass new size
-    emit crop_release(crop_area);
+    emit crop_release(full_area);
 }
 
 // print keycode of key presses
@@ -9,6 +9,11 @@
 //made to fit this application's needs, namely the change_image() function
 //to allow us to change what image the Cropper window was showing. We also
 //added a signal emission when the user released the mouseclick.
+//
+//change_image() takes an already decoded image rather than a path, and shows
+//a screen sized proxy of it when it is too large to show at 1:1, turned
+//upright for its EXIF orientation. The rectangle sent with crop_release() is
+//always in the stored pixels of the full resolution photo.
 ///////////////////////////////////////////////////////////////////////////////
 
 /*
@@ -36,7 +41,7 @@ class Cropper : public QLabel
 
   public:
     Cropper( QString fileName );
-    void change_image( QString path );
+    void change_image( const QImage &image, const QSize &photo_size, int orientation );
     void mousePressEvent( QMouseEvent *event );
     void mouseMoveEvent( QMouseEvent *event );
     void mouseReleaseEvent( QMouseEvent *event );
@@ -48,6 +53,10 @@ class Cropper : public QLabel
   private:
     QRubberBand *rubberBand;
     QPoint origin;
+    QSize full_size;    // stored size of the full resolution photo being cropped
+    QTransform to_stored; // upright full resolution pixels to stored pixels
+    double scale_x;     // full resolution pixels per displayed pixel
+    double scale_y;
 };
 
 #endif
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the DuplicateFinder class declared in
+//duplicate_finder.h. Hashing and the BK-tree lookups both run on the global
+//thread pool; the tree is only read during the lookups, so they need no
+//locking. Clusters are formed afterwards with a union-find.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "duplicate_finder.h"
+#include "photo_hash.h"
+#include "trace.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+//A BK-tree of 64 bit hashes under the Hamming distance. Every child of a
+//node is filed under its distance from that node, so by the triangle
+//inequality a search within radius of a query only has to visit children
+//filed under distances within radius of the query's own distance.
+class BkTree
+{
+public:
+    void insert(quint64 hash, int item)
+    {
+        Node node = {hash, item, std::vector<std::pair<int, int> >()};
+        nodes.push_back(node);
+        int added = int(nodes.size()) - 1;
+        if(added == 0)
+            return;
+
+        int current = 0;
+        for(;;)
+        {
+            int distance = PhotoHash::distance(hash, nodes[current].hash);
+            int next = child(current, distance);
+            if(next < 0)
+            {
+                nodes[current].children.push_back(std::make_pair(distance, added));
+                return;
+            }
+            current = next;
+        }
+    }
+
+    //Adds the item of every hash within radius of hash to found
+    void search(quint64 hash, int radius, QVector<int> *found) const
+    {
+        if(nodes.empty())
+            return;
+
+        std::vector<int> pending(1, 0);
+        while(!pending.empty())
+        {
+            const Node &node = nodes[pending.back()];
+            pending.pop_back();
+
+            int distance = PhotoHash::distance(hash, node.hash);
+            if(distance <= radius)
+                found->append(node.item);
+
+            for(size_t i = 0; i < node.children.size(); i++)
+            {
+                if(std::abs(node.children[i].first - distance) <= radius)
+                    pending.push_back(node.children[i].second);
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        quint64 hash;
+        int item;
+        std::vector<std::pair<int, int> > children; //Distance, node index
+    };
+
+    int child(int node, int distance) const
+    {
+        const std::vector<std::pair<int, int> > &children = nodes[node].children;
+        for(size_t i = 0; i < children.size(); i++)
+        {
+            if(children[i].first == distance)
+                return children[i].second;
+        }
+        return -1;
+    }
+
+    std::vector<Node> nodes;
+};
+
+int find_root(QVector<int> &parents, int item)
+{
+    while(parents[item] != item)
+    {
+        parents[item] = parents[parents[item]]; //Path halving
+        item = parents[item];
+    }
+    return item;
+}
+
+bool larger_cluster(const QList<int> &a, const QList<int> &b)
+{
+    return a.size() != b.size() ? a.size() > b.size() : a.first() < b.first();
+}
+}
+
+DuplicateFinder::DuplicateFinder(const QStringList &paths, int threshold, QObject *parent) :
+    QObject(parent),
+    photo_paths(paths),
+    threshold(threshold),
+    cancelled(false)
+{
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    cancel();
+    future.waitForFinished();
+}
+
+void DuplicateFinder::start()
+{
+    if(future.isRunning())
+        return;
+
+    cancelled = false;
+    future = QtConcurrent::run(this, &DuplicateFinder::run);
+}
+
+void DuplicateFinder::cancel()
+{
+    cancelled = true;
+}
+
+//Runs on a worker thread
+void DuplicateFinder::run()
+{
+    TRACE_SCOPE("find_duplicates", "hash");
+
+    int count = photo_paths.size();
+    QVector<PhotoHash::Hashes> hashes(count);
+    QVector<char> hashed(count, 0);
+    QVector<int> indices(count);
+    for(int i = 0; i < count; i++)
+    {
+        indices[i] = i;
+    }
+
+    //Hash every photo in parallel. Each task only writes its own elements.
+    PhotoHash::Hashes *hash_data = hashes.data();
+    char *hashed_data = hashed.data();
+    std::atomic<int> done(0);
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        if(cancelled)
+            return;
+
+        hashed_data[i] = PhotoHash::compute(photo_paths[i], &hash_data[i]);
+        int finished_count = ++done;
+        if(finished_count % 64 == 0 || finished_count == count)
+            emit progress(finished_count, count);
+    });
+    HashCache::instance()->save();
+
+    result.clear();
+    if(cancelled)
+    {
+        emit finished();
+        return;
+    }
+
+    BkTree tree;
+    {
+        TRACE_SCOPE("build_bk_tree", "hash");
+        for(int i = 0; i < count; i++)
+        {
+            if(hashed[i])
+                tree.insert(hashes[i].phash, i);
+        }
+    }
+
+    //Look up every photo's neighbours in parallel. A dHash that also agrees
+    //rules out photos that only share their coarse structure.
+    QVector<QVector<int> > matches(count);
+    QVector<int> *match_data = matches.data();
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        if(!hashed_data[i] || cancelled)
+            return;
+
+        QVector<int> found;
+        tree.search(hash_data[i].phash, threshold, &found);
+        for(int j = 0; j < found.size(); j++)
+        {
+            int other = found[j];
+            if(other > i && PhotoHash::distance(hash_data[i].dhash, hash_data[other].dhash)
+                            <= 2 * threshold)
+            {
+                match_data[i].append(other);
+            }
+        }
+    });
+
+    //Join matching photos into clusters
+    QVector<int> parents(count);
+    for(int i = 0; i < count; i++)
+    {
+        parents[i] = i;
+    }
+    for(int i = 0; i < count; i++)
+    {
+        for(int j = 0; j < matches[i].size(); j++)
+        {
+            parents[find_root(parents, matches[i][j])] = find_root(parents, i);
+        }
+    }
+
+    QHash<int, QList<int> > groups;
+    for(int i = 0; i < count; i++)
+    {
+        if(hashed[i])
+            groups[find_root(parents, i)].append(i);
+    }
+
+    for(QHash<int, QList<int> >::const_iterator it = groups.constBegin(); it != groups.constEnd(); ++it)
+    {
+        if(it->size() > 1)
+            result.append(it.value());
+    }
+    std::sort(result.begin(), result.end(), larger_cluster);
+
+    emit finished();
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The DuplicateFinder class, which groups the photos of an
+//album into clusters of near duplicates on a background thread.
+//
+//Every photo is hashed in parallel with PhotoHash (cached between runs), and
+//the pHashes are put in a BK-tree, a tree of hashes ordered by Hamming
+//distance that can list all hashes within a distance of a photo without
+//comparing it to every other photo. Photos whose pHash and dHash are both
+//within the threshold are joined into one cluster, transitively.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QStringList>
+#include <atomic>
+
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Clusters of indices into the searched paths, largest cluster first
+    typedef QList<QList<int> > Clusters;
+
+    //Differing pHash bits up to which two photos count as duplicates
+    static const int DefaultThreshold = 6;
+
+    explicit DuplicateFinder(const QStringList &paths, int threshold = DefaultThreshold,
+                             QObject *parent = 0);
+    ~DuplicateFinder();
+
+    //Starts the search in the background. finished() is emitted when it is
+    //done or cancelled; a cancelled search has no clusters.
+    void start();
+    void cancel();
+    bool is_cancelled() const { return cancelled.load(); }
+
+    QStringList paths() const { return photo_paths; }
+    const Clusters &clusters() const { return result; }
+
+signals:
+    void progress(int done, int total);
+    void finished();
+
+private:
+    void run();
+
+    QStringList photo_paths;
+    int threshold;
+    Clusters result;
+    std::atomic<bool> cancelled;
+    QFuture<void> future;
+};
+
+#endif // DUPLICATE_FINDER_H
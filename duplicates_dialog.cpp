@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the DuplicatesDialog class declared in
+//duplicates_dialog.h. Every cluster is a top level item with its photos as
+//children; the photo's path is kept in the child item's text.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "duplicates_dialog.h"
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+DuplicatesDialog::DuplicatesDialog(const QStringList &paths,
+                                   const DuplicateFinder::Clusters &clusters,
+                                   QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle(tr("Duplicate Photos"));
+    resize(640, 480);
+
+    QLabel *summary = new QLabel(this);
+    summary->setText(clusters.isEmpty()
+                     ? tr("No near duplicates found among %1 photos.").arg(paths.size())
+                     : tr("%1 groups of near duplicates found among %2 photos. "
+                          "Double click a photo to show it.")
+                       .arg(clusters.size()).arg(paths.size()));
+
+    tree = new QTreeWidget(this);
+    tree->setHeaderLabels(QStringList() << tr("Photo") << tr("Position"));
+    tree->header()->setStretchLastSection(false);
+
+    for(int i = 0; i < clusters.size(); i++)
+    {
+        QTreeWidgetItem *group = new QTreeWidgetItem(tree);
+        group->setText(0, tr("Group %1 (%2 photos)").arg(i + 1).arg(clusters[i].size()));
+        for(int j = 0; j < clusters[i].size(); j++)
+        {
+            int index = clusters[i][j];
+            QTreeWidgetItem *photo = new QTreeWidgetItem(group);
+            photo->setText(0, paths[index]);
+            photo->setText(1, QString::number(index + 1));
+        }
+        group->setExpanded(true);
+    }
+    tree->resizeColumnToContents(1);
+    tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(summary);
+    layout->addWidget(tree);
+    layout->addWidget(buttons);
+
+    connect(tree, SIGNAL(itemActivated(QTreeWidgetItem*,int)),
+            this, SLOT(item_activated(QTreeWidgetItem*)));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+void DuplicatesDialog::item_activated(QTreeWidgetItem *item)
+{
+    //Group items have no parent and name no photo
+    if(item->parent() != NULL)
+        emit photo_selected(item->text(0));
+}
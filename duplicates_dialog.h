@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The DuplicatesDialog class, which lists the clusters of near
+//duplicate photos found by a DuplicateFinder. Double clicking a photo in
+//the list shows it in the main window.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DUPLICATES_DIALOG_H
+#define DUPLICATES_DIALOG_H
+
+#include <QDialog>
+#include "duplicate_finder.h"
+
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class DuplicatesDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    DuplicatesDialog(const QStringList &paths, const DuplicateFinder::Clusters &clusters,
+                     QWidget *parent = 0);
+
+signals:
+    void photo_selected(QString path);
+
+private slots:
+    void item_activated(QTreeWidgetItem *item);
+
+private:
+    QTreeWidget *tree;
+};
+
+#endif // DUPLICATES_DIALOG_H
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the EditRecipe class declared in
+//edit_recipe.h. Steps with a tag this version does not know are kept in
+//the key but skipped when rendering.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "edit_recipe.h"
+#include "filter_pipeline.h"
+#include "trace.h"
+#include <QDomNamedNodeMap>
+#include <QTransform>
+
+const char *const EditRecipe::TagName = "edits";
+
+namespace
+{
+//A rectangle in full resolution pixels, in the pixels of a copy at scale
+QRect scaled_rect(const QRect &rect, double scale)
+{
+    if(scale == 1)
+        return rect;
+    return QRect(qRound(rect.x() * scale), qRound(rect.y() * scale),
+                 qMax(1, qRound(rect.width() * scale)), qMax(1, qRound(rect.height() * scale)));
+}
+}
+
+EditRecipe::EditRecipe(const QDomElement &photo)
+{
+    QDomElement edits = photo.firstChildElement(TagName);
+    for(QDomElement element = edits.firstChildElement(); !element.isNull();
+        element = element.nextSiblingElement())
+    {
+        Step step;
+        step.name = element.tagName();
+        QDomNamedNodeMap attributes = element.attributes();
+        for(int i = 0; i < attributes.count(); i++)
+        {
+            QDomAttr attribute = attributes.item(i).toAttr();
+            step.values.insert(attribute.name(), attribute.value().toDouble());
+        }
+        steps.append(step);
+    }
+}
+
+double EditRecipe::value(int index, const QString &attribute) const
+{
+    return steps[index].values.value(attribute);
+}
+
+QString EditRecipe::key() const
+{
+    QStringList parts;
+    for(int i = 0; i < steps.size(); i++)
+    {
+        QStringList values;
+        QMap<QString, double>::const_iterator it = steps[i].values.constBegin();
+        for(; it != steps[i].values.constEnd(); ++it)
+        {
+            values.append(it.key() + "=" + QString::number(it.value(), 'g', 12));
+        }
+        parts.append(steps[i].name + "(" + values.join(",") + ")");
+    }
+    return parts.join(";");
+}
+
+QSize EditRecipe::result_size(const QSize &original) const
+{
+    QSize size = original;
+    for(int i = 0; i < steps.size(); i++)
+    {
+        const Step &step = steps[i];
+        if(step.name == "crop")
+        {
+            QRect rect(int(step.values.value("x")), int(step.values.value("y")),
+                       int(step.values.value("width")), int(step.values.value("height")));
+            size = (rect & QRect(QPoint(0, 0), size)).size();
+        }
+        else if(step.name == "rotate")
+        {
+            QTransform turn = QImage::trueMatrix(QTransform().rotate(step.values.value("angle")),
+                                                 size.width(), size.height());
+            size = turn.mapRect(QRect(QPoint(0, 0), size)).size();
+        }
+        else if(step.name == "resize")
+        {
+            double percent = step.values.value("percent") / 100;
+            size = QSize(int(size.width() * percent), int(size.height() * percent));
+        }
+    }
+    return size;
+}
+
+//The filter of step for a photo scaled by scale, or NULL if step is not a
+//filter
+FilterOp *EditRecipe::filter(const Step &step, double scale)
+{
+    const QMap<QString, double> &v = step.values;
+    if(step.name == "brighten")
+        return new BrightnessOp(int(v.value("value")));
+    if(step.name == "contrast")
+        return new ContrastOp(int(v.value("value")));
+    if(step.name == "negate")
+        return new NegateOp;
+    if(step.name == "levels")
+    {
+        int low[3] = {int(v.value("red_low")), int(v.value("green_low")),
+                      int(v.value("blue_low"))};
+        int high[3] = {int(v.value("red_high", 255)), int(v.value("green_high", 255)),
+                       int(v.value("blue_high", 255))};
+        return new CurveOp(ToneCurve::levels(low, high));
+    }
+    if(step.name == "smooth")
+        return new SmoothOp(qRound(v.value("passes") * scale * scale));
+    if(step.name == "sharpen")
+        return new UnsharpMaskOp(v.value("amount"), v.value("radius") * scale,
+                                 int(v.value("threshold")));
+    if(step.name == "blur")
+        return new GaussianBlurOp(v.value("sigma") * scale);
+    if(step.name == "median")
+        return new MedianOp(qRound(v.value("radius") * scale));
+    if(step.name == "bilateral")
+        return new BilateralOp(qRound(v.value("radius") * scale));
+    return NULL;
+}
+
+QImage EditRecipe::render(const QImage &original, double scale) const
+{
+    TRACE_SCOPE("render_edits", "filter");
+
+    if(original.isNull() || steps.isEmpty())
+        return original;
+
+    //region is the part of the pipeline's result the crops so far keep
+    FilterPipeline pipeline;
+    pipeline.set_source(original);
+    QRect region = original.rect();
+
+    //Renders what the pipeline has so far and starts a new one on it
+    auto cropped = [&]() { return region != QRect(QPoint(0, 0), pipeline.size()); };
+    auto flush = [&]()
+    {
+        if(pipeline.is_empty() && !cropped())
+            return;
+        QImage image = pipeline.render(region, 1);
+        pipeline = FilterPipeline();
+        pipeline.set_source(image);
+        region = image.rect();
+    };
+
+    for(int i = 0; i < steps.size(); i++)
+    {
+        const Step &step = steps[i];
+        if(step.name == "crop")
+        {
+            QRect rect(int(step.values.value("x")), int(step.values.value("y")),
+                       int(step.values.value("width")), int(step.values.value("height")));
+            region = scaled_rect(rect, scale).translated(region.topLeft()) & region;
+        }
+        else if(step.name == "rotate" || step.name == "resize")
+        {
+            flush();
+            QImage image = pipeline.render(1);
+            if(step.name == "rotate")
+            {
+                image = image.transformed(QTransform().rotate(step.values.value("angle")));
+            }
+            else
+            {
+                double percent = step.values.value("percent") / 100;
+                image = image.scaled(int(image.width() * percent), int(image.height() * percent),
+                                     Qt::IgnoreAspectRatio, Qt::FastTransformation);
+            }
+            pipeline = FilterPipeline();
+            pipeline.set_source(image);
+            region = image.rect();
+        }
+        else
+        {
+            FilterOp *op = filter(step, scale);
+            if(op == NULL)
+                continue;
+
+            //A filter that reads neighbouring pixels treats the edge of a
+            //crop as the edge of the photo, so the crop has to be rendered
+            //first. A point filter can stay behind it.
+            if(op->halo(1) > 0 && cropped())
+                flush();
+            pipeline.append(op);
+        }
+    }
+
+    return pipeline.render(region, 1);
+}
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The EditRecipe class, the edits made to a photo, kept in the
+//album instead of in the photo's file. The edits are the children of an
+//<edits> element at the end of the <photo>, in the order they were made:
+//
+//  <edits>
+//      <brighten value="20"/>
+//      <crop x="120" y="80" width="1600" height="1200"/>
+//  </edits>
+//
+//The photo's file is never written; the photo is shown by rendering its
+//recipe over the decoded file. Coordinates and radii are in the full
+//resolution pixels of the photo as it was when the edit was made, as they
+//are stored in the file before its EXIF orientation turns them upright. A
+//rotate's angle turns those stored pixels, so the editor reverses it for a
+//mirrored photo to turn the photo the way the user asked on screen.
+//
+//render() builds FilterPipelines from the steps. Point steps (brighten,
+//contrast, negate, levels) are fused into one lookup table, and a crop
+//becomes the region the steps before it are rendered for, so they only
+//compute the pixels it keeps. A crop is only rendered before a filter that
+//reads neighbouring pixels, and before a rotate or resize, where the
+//pipeline has to start over.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDIT_RECIPE_H
+#define EDIT_RECIPE_H
+
+#include <QDomElement>
+#include <QImage>
+#include <QList>
+#include <QMap>
+
+class FilterOp;
+
+class EditRecipe
+{
+public:
+    //Tag of the element of a <photo> that holds its edits
+    static const char *const TagName;
+
+    EditRecipe() {}
+
+    //Reads the edits of photo. A photo without any has an empty recipe.
+    explicit EditRecipe(const QDomElement &photo);
+
+    bool is_empty() const { return steps.isEmpty(); }
+    int size() const { return steps.size(); }
+
+    //Tag of the step at index, and the value of one of its attributes
+    QString step_name(int index) const { return steps[index].name; }
+    double value(int index, const QString &attribute) const;
+
+    //Text that is the same for two recipes exactly when their steps are,
+    //for keying cached renders
+    QString key() const;
+
+    //Size of the result of editing a photo of size original
+    QSize result_size(const QSize &original) const;
+
+    //Returns original with the edits made. original may be the photo scaled
+    //down by scale, such as a proxy; the crops and radii are scaled to match.
+    QImage render(const QImage &original, double scale = 1) const;
+
+private:
+    struct Step
+    {
+        QString name;
+        QMap<QString, double> values; //Attributes, sorted for key()
+    };
+
+    static FilterOp *filter(const Step &step, double scale);
+
+    QList<Step> steps;
+};
+
+#endif // EDIT_RECIPE_H
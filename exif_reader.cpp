@@ -0,0 +1,371 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the ExifReader class declared in
+//exif_reader.h. A HeaderSource hands out byte ranges of the file, reading
+//more of it only when the parser follows an offset past what it has read.
+//Every read is bounded, so a corrupt offset cannot make it read a whole
+//file.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "exif_reader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace
+{
+//Bytes read when a file is opened; enough for the EXIF of most JPEGs
+const int InitialBytes = 8 * 1024;
+
+//Bytes never read past. An APP1 segment is at most 64 KB, but other
+//segments may come before it.
+const int MaxBytes = 256 * 1024;
+
+//Entries of an IFD never followed, against corrupt counts
+const int MaxEntries = 512;
+
+//TIFF tags
+const quint16 TagOrientation = 0x0112;
+const quint16 TagDateTime = 0x0132;
+const quint16 TagExifIfd = 0x8769;
+const quint16 TagGpsIfd = 0x8825;
+const quint16 TagDateTimeOriginal = 0x9003;
+const quint16 TagGpsLatitudeRef = 0x0001;
+const quint16 TagGpsLatitude = 0x0002;
+const quint16 TagGpsLongitudeRef = 0x0003;
+const quint16 TagGpsLongitude = 0x0004;
+
+//TIFF field types used here
+const quint16 TypeAscii = 2;
+const quint16 TypeShort = 3;
+const quint16 TypeLong = 4;
+const quint16 TypeRational = 5;
+
+//Reads the start of a file on demand
+class HeaderSource
+{
+public:
+    explicit HeaderSource(const QString &path) : file(path)
+    {
+        if(file.open(QIODevice::ReadOnly))
+            data = file.read(InitialBytes);
+    }
+
+    //Returns length bytes at offset, or NULL if the file is shorter or the
+    //range is past MaxBytes. The pointer is only valid until the next call.
+    const uchar *bytes(qint64 offset, qint64 length)
+    {
+        if(offset < 0 || length < 0 || offset + length > MaxBytes)
+            return NULL;
+        if(offset + length > data.size() && file.isOpen())
+        {
+            //Read ahead in steps, so walking an IFD does not read per entry
+            qint64 want = qMin<qint64>(MaxBytes, qMax<qint64>(offset + length, data.size() * 2));
+            data.append(file.read(want - data.size()));
+        }
+        if(offset + length > data.size())
+            return NULL;
+        return reinterpret_cast<const uchar *>(data.constData()) + offset;
+    }
+
+private:
+    QFile file;
+    QByteArray data;
+};
+
+//A TIFF structure starting at base in the file
+class TiffParser
+{
+public:
+    TiffParser(HeaderSource *source, qint64 base) : source(source), base(base), little(true) {}
+
+    //Reads the byte order and returns the offset of IFD0, or 0 if this is
+    //not a TIFF header
+    quint32 header()
+    {
+        const uchar *p = source->bytes(base, 8);
+        if(p == NULL)
+            return 0;
+        if(p[0] == 'I' && p[1] == 'I')
+            little = true;
+        else if(p[0] == 'M' && p[1] == 'M')
+            little = false;
+        else
+            return 0;
+        if(u16(p + 2) != 42)
+            return 0;
+        return u32(p + 4);
+    }
+
+    //Reads the entries of the IFD at offset into data, following the
+    //Exif and GPS sub-IFDs
+    void read_ifd(quint32 offset, bool gps, ExifReader::Data *data, QString *date, QString *date_original,
+                  int depth = 0)
+    {
+        const uchar *p = source->bytes(base + offset, 2);
+        if(p == NULL || depth > 2)
+            return;
+        int count = qMin<int>(u16(p), MaxEntries);
+
+        char latitude_ref = 0, longitude_ref = 0;
+        double latitude = -1, longitude = -1;
+
+        for(int i = 0; i < count; i++)
+        {
+            const uchar *entry = source->bytes(base + offset + 2 + 12 * i, 12);
+            if(entry == NULL)
+                return;
+            quint16 tag = u16(entry);
+            quint16 type = u16(entry + 2);
+            quint32 values = u32(entry + 4);
+
+            if(gps)
+            {
+                if(tag == TagGpsLatitudeRef && type == TypeAscii)
+                    latitude_ref = entry[8];
+                else if(tag == TagGpsLongitudeRef && type == TypeAscii)
+                    longitude_ref = entry[8];
+                else if(tag == TagGpsLatitude && type == TypeRational && values == 3)
+                    latitude = degrees(u32(entry + 8));
+                else if(tag == TagGpsLongitude && type == TypeRational && values == 3)
+                    longitude = degrees(u32(entry + 8));
+                continue;
+            }
+
+            switch(tag)
+            {
+            case TagOrientation:
+                if(type == TypeShort)
+                    data->orientation = u16(entry + 8);
+                break;
+            case TagDateTime:
+                if(type == TypeAscii)
+                    *date = ascii(entry, values);
+                break;
+            case TagDateTimeOriginal:
+                if(type == TypeAscii)
+                    *date_original = ascii(entry, values);
+                break;
+            case TagExifIfd:
+            case TagGpsIfd:
+                if(type == TypeLong || type == TypeShort)
+                {
+                    quint32 sub = type == TypeLong ? u32(entry + 8) : u16(entry + 8);
+                    read_ifd(sub, tag == TagGpsIfd, data, date, date_original, depth + 1);
+                }
+                break;
+            }
+        }
+
+        if(gps && latitude >= 0 && longitude >= 0 && latitude_ref != 0 && longitude_ref != 0)
+        {
+            data->has_location = true;
+            data->latitude = latitude_ref == 'S' ? -latitude : latitude;
+            data->longitude = longitude_ref == 'W' ? -longitude : longitude;
+        }
+    }
+
+private:
+    quint16 u16(const uchar *p) const
+    {
+        return little ? quint16(p[0] | (p[1] << 8)) : quint16((p[0] << 8) | p[1]);
+    }
+
+    quint32 u32(const uchar *p) const
+    {
+        return little ? quint32(p[0] | (p[1] << 8) | (p[2] << 16) | (quint32(p[3]) << 24))
+                      : quint32((quint32(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+    }
+
+    //The ASCII value of an entry, inline if it fits in the value field
+    QString ascii(const uchar *entry, quint32 length)
+    {
+        if(length > 64)
+            return QString();
+        const uchar *p = length <= 4 ? entry + 8 : source->bytes(base + u32(entry + 8), length);
+        if(p == NULL)
+            return QString();
+        const char *text = reinterpret_cast<const char *>(p);
+        return QString::fromLatin1(text, qstrnlen(text, length));
+    }
+
+    //Three rationals (degrees, minutes, seconds) at offset as degrees,
+    //or -1 if they cannot be read
+    double degrees(quint32 offset)
+    {
+        const uchar *p = source->bytes(base + offset, 24);
+        if(p == NULL)
+            return -1;
+        double result = 0;
+        double unit = 1;
+        for(int i = 0; i < 3; i++, unit *= 60)
+        {
+            quint32 denominator = u32(p + 8 * i + 4);
+            if(denominator != 0)
+                result += double(u32(p + 8 * i)) / denominator / unit;
+        }
+        return result;
+    }
+
+    HeaderSource *source;
+    qint64 base;
+    bool little;
+};
+
+//Returns the file offset of the TIFF header inside a JPEG's EXIF segment,
+//or -1 if it has none. Walks the segment headers only.
+qint64 find_jpeg_exif(HeaderSource *source)
+{
+    qint64 offset = 2;
+    for(;;)
+    {
+        const uchar *p = source->bytes(offset, 4);
+        if(p == NULL || p[0] != 0xFF)
+            return -1;
+
+        //Pixel data starts at SOS; EXIF always comes before it
+        quint8 marker = p[1];
+        if(marker == 0xDA || marker == 0xD9)
+            return -1;
+        if(marker == 0xFF)
+        {
+            offset++; //Fill byte
+            continue;
+        }
+
+        int length = (p[2] << 8) | p[3];
+        if(marker == 0xE1 && length >= 8)
+        {
+            const uchar *id = source->bytes(offset + 4, 6);
+            if(id != NULL && qstrncmp(reinterpret_cast<const char *>(id), "Exif\0\0", 6) == 0)
+                return offset + 10;
+        }
+        offset += 2 + length;
+    }
+}
+
+//Parses an EXIF date, "YYYY:MM:DD HH:MM:SS"
+QDateTime parse_date(const QString &text)
+{
+    return QDateTime::fromString(text.trimmed(), "yyyy:MM:dd HH:mm:ss");
+}
+
+//Orientations already read, with the state of the file when they were
+struct CachedOrientation
+{
+    qint64 size;
+    qint64 modified;
+    int orientation;
+};
+
+QMutex orientation_mutex;
+QHash<QString, CachedOrientation> orientations;
+}
+
+QString ExifReader::Data::date_text() const
+{
+    if(!taken.isValid())
+        return QString();
+    //Same form as the dates typed into albums, e.g. "October 8, 2014"
+    return QLocale::c().toString(taken.date(), "MMMM d, yyyy");
+}
+
+QString ExifReader::Data::location_text() const
+{
+    if(!has_location)
+        return QString();
+    return QString("%1, %2").arg(latitude, 0, 'f', 5).arg(longitude, 0, 'f', 5);
+}
+
+ExifReader::Data ExifReader::read(const QString &path)
+{
+    Data data;
+    HeaderSource source(path);
+
+    const uchar *magic = source.bytes(0, 4);
+    if(magic == NULL)
+        return data;
+
+    qint64 base = -1;
+    if(magic[0] == 0xFF && magic[1] == 0xD8)
+        base = find_jpeg_exif(&source);
+    else if((magic[0] == 'I' && magic[1] == 'I') || (magic[0] == 'M' && magic[1] == 'M'))
+        base = 0;
+    if(base < 0)
+        return data;
+
+    TiffParser parser(&source, base);
+    quint32 ifd0 = parser.header();
+    if(ifd0 == 0)
+        return data;
+
+    QString date, date_original;
+    parser.read_ifd(ifd0, false, &data, &date, &date_original);
+
+    data.taken = parse_date(date_original);
+    if(!data.taken.isValid())
+        data.taken = parse_date(date);
+    if(data.orientation < 1 || data.orientation > 8)
+        data.orientation = 1;
+    return data;
+}
+
+int ExifReader::orientation(const QString &path)
+{
+    QFileInfo info(path);
+    qint64 size = info.size();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        QMutexLocker lock(&orientation_mutex);
+        QHash<QString, CachedOrientation>::const_iterator it = orientations.constFind(path);
+        if(it != orientations.constEnd() && it->size == size && it->modified == modified)
+            return it->orientation;
+    }
+
+    CachedOrientation cached = {size, modified, read(path).orientation};
+    QMutexLocker lock(&orientation_mutex);
+    orientations.insert(path, cached);
+    return cached.orientation;
+}
+
+void ExifReader::set_upright(const QString &path)
+{
+    QFileInfo info(path);
+    CachedOrientation cached = {info.size(), info.lastModified().toMSecsSinceEpoch(), 1};
+    QMutexLocker lock(&orientation_mutex);
+    orientations.insert(path, cached);
+}
+
+void ExifReader::forget_orientation(const QString &path)
+{
+    QMutexLocker lock(&orientation_mutex);
+    orientations.remove(path);
+}
+
+QTransform ExifReader::transform(int orientation)
+{
+    switch(orientation)
+    {
+    case 2: return QTransform(-1, 0, 0, 1, 0, 0);  //Mirrored left to right
+    case 3: return QTransform(-1, 0, 0, -1, 0, 0); //Upside down
+    case 4: return QTransform(1, 0, 0, -1, 0, 0);  //Mirrored top to bottom
+    case 5: return QTransform(0, 1, 1, 0, 0, 0);   //Transposed
+    case 6: return QTransform(0, 1, -1, 0, 0, 0);  //Needs 90 degrees clockwise
+    case 7: return QTransform(0, -1, -1, 0, 0, 0); //Transversed
+    case 8: return QTransform(0, -1, 1, 0, 0, 0);  //Needs 90 degrees counterclockwise
+    default: return QTransform();
+    }
+}
+
+QSize ExifReader::upright_size(const QSize &stored, int orientation)
+{
+    return swaps_dimensions(orientation) ? stored.transposed() : stored;
+}
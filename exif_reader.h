@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The ExifReader class, which reads the capture date, GPS
+//position and orientation a camera stores in a photo's EXIF metadata. Only
+//the TIFF structure at the start of the file is parsed; no pixels are
+//decoded. The file is read in small pieces as the parser needs them, which
+//for a typical JPEG is the first 8 KB, so reading the metadata of a whole
+//album is limited by file opens rather than by reading.
+//
+//JPEG files (EXIF in the APP1 segment) and TIFF based files (most camera
+//raw formats) are understood. Anything else simply has no metadata.
+//
+//read() is thread safe, so many files can be read at once with
+//QtConcurrent::mapped().
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef EXIF_READER_H
+#define EXIF_READER_H
+
+#include <QDateTime>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+class ExifReader
+{
+public:
+    struct Data
+    {
+        QDateTime taken;    //When the photo was taken, invalid if unknown
+        bool has_location;
+        double latitude;    //Degrees, north positive
+        double longitude;   //Degrees, east positive
+        int orientation;    //EXIF orientation 1 to 8, 1 if unknown
+
+        Data() : has_location(false), latitude(0), longitude(0), orientation(1) {}
+
+        //The date and location formatted for the album's <date> and
+        //<location> tags, or empty strings if unknown
+        QString date_text() const;
+        QString location_text() const;
+    };
+
+    //Reads the metadata of the file at path
+    static Data read(const QString &path);
+
+    //The EXIF orientation of the file at path. Remembered per file, so
+    //display_photo() can ask on every repaint; a file that changed on disk
+    //is read again.
+    static int orientation(const QString &path);
+
+    //Records that the file at path shows upright pixels, for an edit whose
+    //write (without EXIF) has not landed yet
+    static void set_upright(const QString &path);
+
+    //Forgets what set_upright() recorded, for a write that never landed
+    static void forget_orientation(const QString &path);
+
+    //The transform that turns stored pixels into the upright photo for an
+    //EXIF orientation. Meant for QPixmap::transformed() and QImage::transformed(),
+    //which drop the translation.
+    static QTransform transform(int orientation);
+
+    //Returns true if orientation turns the photo on its side, so the upright
+    //photo's width is the stored height
+    static bool swaps_dimensions(int orientation) { return orientation >= 5 && orientation <= 8; }
+
+    //Returns true if orientation mirrors the photo, so a turn of the stored
+    //pixels shows as a turn the other way
+    static bool mirrors(int orientation)
+    {
+        return orientation == 2 || orientation == 4 || orientation == 5 || orientation == 7;
+    }
+    static QSize upright_size(const QSize &stored, int orientation);
+};
+
+#endif // EXIF_READER_H
@@ -0,0 +1,352 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the FilterPipeline and FilterOp classes
+//declared in filter_pipeline.h. Every step works on a 32 bit copy of just
+//its region, split into bands of rows across threads once the region is
+//large enough to be worth it.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "filter_pipeline.h"
+#include "image_filters.h"
+#include "trace.h"
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+//Regions smaller than this are not worth splitting across threads
+const qint64 MinParallelPixels = 256 * 1024;
+
+//Returns image in a format whose pixels are whole 32 bit words
+QImage as_32bit(const QImage &image)
+{
+    if(image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        return image;
+    return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                         : QImage::Format_RGB32);
+}
+
+//Runs work(first, last) over bands of the rows of image on the thread pool
+//and returns once all of them are done
+void for_bands(const QImage &image, std::function<void(int, int)> work)
+{
+    int height = image.height();
+    int bands = 1;
+    if(qint64(image.width()) * height >= MinParallelPixels)
+        bands = qBound(1, QThread::idealThreadCount() * 2, height);
+
+    QVector<int> indices(bands);
+    for(int i = 0; i < bands; i++)
+    {
+        indices[i] = i;
+    }
+    QtConcurrent::blockingMap(indices, [&](int band)
+    {
+        work(height * band / bands, height * (band + 1) / bands);
+    });
+}
+
+//The part of input, which holds input_rect, that is output_rect
+QImage crop_to(const QImage &input, const QRect &input_rect, const QRect &output_rect)
+{
+    if(input_rect == output_rect)
+        return input;
+    return input.copy(output_rect.translated(-input_rect.topLeft()));
+}
+}
+
+int FilterOp::halo(double scale) const
+{
+    Q_UNUSED(scale);
+    return 0;
+}
+
+QImage PointOp::apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                      const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+    Q_UNUSED(scale);
+
+    quint32 red[256], green[256], blue[256];
+    for(int value = 0; value < 256; value++)
+    {
+        red[value] = quint32(qBound(0, map(0, value), 255));
+        green[value] = quint32(qBound(0, map(1, value), 255));
+        blue[value] = quint32(qBound(0, map(2, value), 255));
+    }
+
+    QImage result = input.copy(output_rect.translated(-input_rect.topLeft()));
+    uchar *bits = result.bits();
+    int stride = result.bytesPerLine();
+    int width = result.width();
+    for_bands(result, [&](int first, int last)
+    {
+        for(int y = first; y < last; y++)
+        {
+            quint32 *line = reinterpret_cast<quint32 *>(bits + qint64(y) * stride);
+            for(int x = 0; x < width; x++)
+            {
+                quint32 p = line[x];
+                line[x] = (p & 0xff000000) | red[(p >> 16) & 0xff] << 16
+                          | green[(p >> 8) & 0xff] << 8 | blue[p & 0xff];
+            }
+        }
+    });
+    return result;
+}
+
+TableOp::TableOp(const PointOp &first, const PointOp &second)
+{
+    for(int channel = 0; channel < 3; channel++)
+    {
+        for(int value = 0; value < 256; value++)
+        {
+            int between = qBound(0, first.map(channel, value), 255);
+            tables[channel][value] = uchar(qBound(0, second.map(channel, between), 255));
+        }
+    }
+}
+
+int BrightnessOp::map(int channel, int level) const
+{
+    Q_UNUSED(channel);
+    return level + value;
+}
+
+int ContrastOp::map(int channel, int level) const
+{
+    Q_UNUSED(channel);
+    return (level - value) * 2;
+}
+
+int NegateOp::map(int channel, int level) const
+{
+    Q_UNUSED(channel);
+    return 255 - level;
+}
+
+int CurveOp::map(int channel, int level) const
+{
+    return curve.map(channel, level);
+}
+
+//A pass blurs over about a pixel of the full photo, so a preview at scale
+//needs scale squared as many passes for the same look
+int SmoothOp::passes_at(double scale) const
+{
+    if(scale >= 1)
+        return passes;
+    return qRound(passes * scale * scale);
+}
+
+int SmoothOp::halo(double scale) const
+{
+    return passes_at(scale);
+}
+
+QImage SmoothOp::apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                       const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+
+    int count = passes_at(scale);
+    if(count <= 0)
+        return crop_to(input, input_rect, output_rect);
+
+    //The edge pixels of the region are kept on every pass. Where the region
+    //meets the edge of the image that is what the filter does; elsewhere
+    //they are halo, and each pass only spoils one more pixel of it.
+    QImage current = input.copy();
+    QImage next = input.copy();
+    int width = input.width();
+    int height = input.height();
+    int stride = current.bytesPerLine();
+
+    for(int pass = 0; pass < count; pass++)
+    {
+        const uchar *from = current.constBits();
+        uchar *to = next.bits();
+        for_bands(next, [&](int first, int last)
+        {
+            for(int y = first; y < last; y++)
+            {
+                const quint32 *row = reinterpret_cast<const quint32 *>(from + qint64(y) * stride);
+                quint32 *target = reinterpret_cast<quint32 *>(to + qint64(y) * stride);
+                if(y == 0 || y == height - 1)
+                {
+                    std::copy(row, row + width, target);
+                    continue;
+                }
+
+                const quint32 *above = row - stride / 4;
+                const quint32 *below = row + stride / 4;
+                target[0] = row[0];
+                target[width - 1] = row[width - 1];
+                for(int x = 1; x < width - 1; x++)
+                {
+                    int r = 0, g = 0, b = 0;
+                    for(int m = -1; m <= 1; m++)
+                    {
+                        quint32 lines[3] = {above[x + m], row[x + m], below[x + m]};
+                        for(int n = 0; n < 3; n++)
+                        {
+                            r += (lines[n] >> 16) & 0xff;
+                            g += (lines[n] >> 8) & 0xff;
+                            b += lines[n] & 0xff;
+                        }
+                    }
+                    target[x] = (row[x] & 0xff000000) | quint32(r / 9) << 16
+                                | quint32(g / 9) << 8 | quint32(b / 9);
+                }
+            }
+        });
+        std::swap(current, next);
+    }
+    return crop_to(current, input_rect, output_rect);
+}
+
+int GaussianBlurOp::halo(double scale) const
+{
+    return ImageFilters::gaussian_reach(sigma * qMin(scale, 1.0));
+}
+
+QImage GaussianBlurOp::apply(const QImage &input, const QRect &input_rect,
+                             const QRect &output_rect, const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+    QImage blurred = ImageFilters::gaussian_blur(input, sigma * qMin(scale, 1.0));
+    return crop_to(blurred, input_rect, output_rect);
+}
+
+int UnsharpMaskOp::halo(double scale) const
+{
+    return ImageFilters::gaussian_reach(radius * qMin(scale, 1.0));
+}
+
+QImage UnsharpMaskOp::apply(const QImage &input, const QRect &input_rect,
+                            const QRect &output_rect, const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+    QImage sharpened = ImageFilters::unsharp_mask(input, amount, radius * qMin(scale, 1.0),
+                                                  threshold);
+    return crop_to(sharpened, input_rect, output_rect);
+}
+
+int MedianOp::halo(double scale) const
+{
+    return qMin(qRound(radius * qMin(scale, 1.0)), int(ImageFilters::MaxMedianRadius));
+}
+
+QImage MedianOp::apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                       const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+    QImage filtered = ImageFilters::median(input, halo(scale));
+    return crop_to(filtered, input_rect, output_rect);
+}
+
+//A grid cell is about radius pixels, at least 4, and the grid blur reaches
+//two cells past the one a pixel falls in
+int BilateralOp::halo(double scale) const
+{
+    return 3 * qMax(qRound(radius * qMin(scale, 1.0)), 4);
+}
+
+QImage BilateralOp::apply(const QImage &input, const QRect &input_rect,
+                          const QRect &output_rect, const QRect &bounds, double scale) const
+{
+    Q_UNUSED(bounds);
+    QImage filtered = ImageFilters::bilateral(input, qRound(radius * qMin(scale, 1.0)));
+    return crop_to(filtered, input_rect, output_rect);
+}
+
+void FilterPipeline::set_source(const QImage &image)
+{
+    if(image.cacheKey() == source.cacheKey() && image.size() == source.size())
+        return;
+    source = image;
+    scaled_source = QImage();
+    scaled_for = 0;
+}
+
+void FilterPipeline::append(FilterOp *op)
+{
+    PointOp *point = dynamic_cast<PointOp *>(op);
+    PointOp *last = ops.isEmpty() ? NULL : dynamic_cast<PointOp *>(ops.last().data());
+    if(point && last)
+    {
+        ops.last() = QSharedPointer<FilterOp>(new TableOp(*last, *point));
+        delete op;
+        return;
+    }
+    ops.append(QSharedPointer<FilterOp>(op));
+}
+
+void FilterPipeline::clear()
+{
+    ops.clear();
+}
+
+QSize FilterPipeline::size_at(double scale) const
+{
+    if(scale >= 1)
+        return source.size();
+    return QSize(qMax(1, qRound(source.width() * scale)),
+                 qMax(1, qRound(source.height() * scale)));
+}
+
+//Returns rect of the source at scale as a 32 bit copy
+QImage FilterPipeline::source_region(const QRect &rect, double scale) const
+{
+    if(scale >= 1)
+        return as_32bit(rect == source.rect() ? source : source.copy(rect));
+
+    if(scaled_source.isNull() || scaled_for != scale)
+    {
+        TRACE_SCOPE("scale_filter_source", "scale");
+        scaled_source = as_32bit(source.scaled(size_at(scale), Qt::IgnoreAspectRatio,
+                                               Qt::SmoothTransformation));
+        scaled_for = scale;
+    }
+    return scaled_source.copy(rect);
+}
+
+QImage FilterPipeline::render(const QRect &rect, double scale) const
+{
+    TRACE_SCOPE("render_filters", "filter");
+
+    scale = qMin(scale, 1.0);
+    if(source.isNull() || scale <= 0)
+        return QImage();
+
+    //Walk back from the result to find the region every step needs
+    QRect bounds(QPoint(0, 0), size_at(scale));
+    QVector<QRect> regions(ops.size() + 1);
+    regions[ops.size()] = rect & bounds;
+    if(regions[ops.size()].isEmpty())
+        return QImage();
+    for(int i = ops.size() - 1; i >= 0; i--)
+    {
+        int halo = ops[i]->halo(scale);
+        regions[i] = regions[i + 1].adjusted(-halo, -halo, halo, halo) & bounds;
+    }
+
+    QImage image = source_region(regions[0], scale);
+    for(int i = 0; i < ops.size(); i++)
+    {
+        image = ops[i]->apply(image, regions[i], regions[i + 1], bounds, scale);
+    }
+    return image;
+}
+
+QImage FilterPipeline::render(double scale) const
+{
+    return render(QRect(QPoint(0, 0), size_at(scale)), scale);
+}
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The FilterPipeline class, a chain of filters evaluated on
+//demand for just the region that is asked for, and the FilterOp filters it
+//chains.
+//
+//Every FilterOp declares its halo, how far outside an output pixel it reads
+//its input. To render a rectangle the pipeline walks the chain backwards,
+//growing the rectangle by each halo (and clipping it to the image), so
+//only the source pixels that can reach the result are read, and each step
+//computes just the region the next one needs. A point filter has no halo; a
+//3x3 kernel run n times has a halo of n.
+//
+//A pipeline can render at a scale below 1, from a copy of the source scaled
+//down once and kept, so a preview costs what the preview shows rather than
+//what the photo holds. Filter parameters are always given in full
+//resolution pixels; each FilterOp scales its own radius to match.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FILTER_PIPELINE_H
+#define FILTER_PIPELINE_H
+
+#include <QImage>
+#include <QList>
+#include <QSharedPointer>
+#include "histogram.h"
+
+class FilterOp
+{
+public:
+    virtual ~FilterOp() {}
+
+    //How many pixels away from an output pixel the filter reads at scale
+    virtual int halo(double scale) const;
+
+    //Returns the pixels of output_rect, computed from input, which holds
+    //input_rect: output_rect grown by halo() and clipped to bounds. All
+    //three are in the pixels of the image at scale, whose extent is bounds.
+    //input is in a 32 bit format and the result must be too.
+    virtual QImage apply(const QImage &input, const QRect &input_rect,
+                         const QRect &output_rect, const QRect &bounds,
+                         double scale) const = 0;
+};
+
+//A filter that maps each channel value on its own through a table. Point
+//filters appended to a pipeline one after another are fused into a single
+//TableOp, so a run of them costs one pass.
+class PointOp : public FilterOp
+{
+public:
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+    //The new value of a value of channel (0 red, 1 green, 2 blue), both 0-255
+    virtual int map(int channel, int value) const = 0;
+};
+
+//Point filters run one after another, folded into one table per channel
+class TableOp : public PointOp
+{
+public:
+    TableOp(const PointOp &first, const PointOp &second);
+
+    int map(int channel, int value) const { return tables[channel][value]; }
+
+private:
+    uchar tables[3][256];
+};
+
+//Adds value to every channel (Dr. Weiss' examples/ip/bright.cpp)
+class BrightnessOp : public PointOp
+{
+public:
+    explicit BrightnessOp(int value) : value(value) {}
+
+    int map(int channel, int level) const;
+
+private:
+    int value;
+};
+
+//Doubles every channel's distance above value (examples/ip/contrast.cpp)
+class ContrastOp : public PointOp
+{
+public:
+    explicit ContrastOp(int value) : value(value) {}
+
+    int map(int channel, int level) const;
+
+private:
+    int value;
+};
+
+//Inverts every channel
+class NegateOp : public PointOp
+{
+public:
+    int map(int channel, int level) const;
+};
+
+//A ToneCurve, such as the stretch of Auto Levels
+class CurveOp : public PointOp
+{
+public:
+    explicit CurveOp(const ToneCurve &curve) : curve(curve) {}
+
+    int map(int channel, int level) const;
+
+private:
+    ToneCurve curve;
+};
+
+//Averages every pixel with its eight neighbours, passes times over
+//(examples/ip/smooth.cpp). The pixels on the edge of the image are kept.
+class SmoothOp : public FilterOp
+{
+public:
+    explicit SmoothOp(int passes) : passes(passes) {}
+
+    int halo(double scale) const;
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+private:
+    int passes_at(double scale) const;
+
+    int passes;
+};
+
+//ImageFilters::gaussian_blur()
+class GaussianBlurOp : public FilterOp
+{
+public:
+    explicit GaussianBlurOp(double sigma) : sigma(sigma) {}
+
+    int halo(double scale) const;
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+private:
+    double sigma;
+};
+
+//ImageFilters::unsharp_mask()
+class UnsharpMaskOp : public FilterOp
+{
+public:
+    UnsharpMaskOp(double amount, double radius, int threshold) :
+        amount(amount), radius(radius), threshold(threshold) {}
+
+    int halo(double scale) const;
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+private:
+    double amount;
+    double radius;
+    int threshold;
+};
+
+//ImageFilters::median()
+class MedianOp : public FilterOp
+{
+public:
+    explicit MedianOp(int radius) : radius(radius) {}
+
+    int halo(double scale) const;
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+private:
+    int radius;
+};
+
+//ImageFilters::bilateral(). The bilateral grid has no exact reach, so the
+//halo covers the grid cells around a pixel, which carry nearly all of its
+//weight.
+class BilateralOp : public FilterOp
+{
+public:
+    explicit BilateralOp(int radius) : radius(radius) {}
+
+    int halo(double scale) const;
+    QImage apply(const QImage &input, const QRect &input_rect, const QRect &output_rect,
+                 const QRect &bounds, double scale) const;
+
+private:
+    int radius;
+};
+
+class FilterPipeline
+{
+public:
+    FilterPipeline() : scaled_for(0) {}
+
+    //Filters image from now on. The scaled down copy is only dropped when
+    //the pixels change.
+    void set_source(const QImage &image);
+
+    //Appends op to the end of the chain, which then owns it. A point filter
+    //after another is fused with it.
+    void append(FilterOp *op);
+
+    //Removes every filter, keeping the source
+    void clear();
+
+    bool is_empty() const { return ops.isEmpty(); }
+
+    //Size of the result at full resolution, and at scale
+    QSize size() const { return source.size(); }
+    QSize size_at(double scale) const;
+
+    //Returns the pixels of rect of the result at scale (at most 1), in
+    //the pixels of the result at that scale
+    QImage render(const QRect &rect, double scale) const;
+
+    //Returns the whole result at scale
+    QImage render(double scale = 1) const;
+
+private:
+    QImage source_region(const QRect &rect, double scale) const;
+
+    QImage source;
+    QList<QSharedPointer<FilterOp> > ops;
+    mutable QImage scaled_source; //source at scaled_for, made on first use
+    mutable double scaled_for;
+};
+
+#endif // FILTER_PIPELINE_H
@@ -0,0 +1,516 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the GalleryExporter class declared in
+//gallery_exporter.h. Files are named after a hash of the source path rather
+//than the photo's position, so reordering the album does not invalidate
+//any rendition; only the pages whose previous/next links changed are
+//rewritten. Every file is written through QSaveFile, so an interrupted
+//export never leaves a truncated image or page behind.
+//
+//Output layout:
+//    index.html, index2.html, ...  thumbnail pages
+//    photos/<id>.html              one page per photo
+//    thumbs/<id>.jpg, screen/<id>.jpg, full/<id>.<suffix>
+//    .gallery-manifest             what was exported, for the next run
+///////////////////////////////////////////////////////////////////////////////
+
+#include "gallery_exporter.h"
+#include "exif_reader.h"
+#include "trace.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QtConcurrent>
+
+namespace
+{
+const char *ManifestName = ".gallery-manifest";
+
+//Thumbnails per index page
+const int IndexPageSize = 200;
+
+//Formats browsers show directly, copied as the full size rendition
+const char *WebFormats[] = {"jpg", "jpeg", "png", "gif"};
+
+QString photo_id(const QString &path)
+{
+    QByteArray hash = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(),
+                                               QCryptographicHash::Sha1);
+    return QString(hash.toHex().left(16));
+}
+
+QString index_name(int page)
+{
+    return page == 0 ? QString("index.html") : QString("index%1.html").arg(page + 1);
+}
+
+bool is_web_format(const QString &suffix)
+{
+    for(size_t i = 0; i < sizeof(WebFormats) / sizeof(WebFormats[0]); i++)
+    {
+        if(suffix == WebFormats[i])
+            return true;
+    }
+    return false;
+}
+
+bool save_image(const QImage &image, const QString &path, const char *format, int quality,
+                QString *error)
+{
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        *error = file.errorString();
+        return false;
+    }
+
+    QImageWriter writer(&file, format);
+    writer.setQuality(quality);
+    if(!writer.write(image))
+    {
+        *error = writer.errorString();
+        file.cancelWriting();
+        return false;
+    }
+    if(!file.commit())
+    {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString page_header(const QString &title, const QString &root)
+{
+    return QString("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+                   "<title>%1</title>\n"
+                   "<link rel=\"stylesheet\" href=\"%2gallery.css\">\n"
+                   "</head>\n<body>\n").arg(title.toHtmlEscaped(), root);
+}
+
+const char *Stylesheet =
+    "body { background: #222; color: #ddd; font-family: sans-serif; margin: 1em; }\n"
+    "a { color: #9cf; }\n"
+    ".grid { display: flex; flex-wrap: wrap; gap: 8px; }\n"
+    ".grid img { display: block; }\n"
+    ".photo img { max-width: 100%; height: auto; }\n"
+    ".nav { margin: 1em 0; }\n"
+    ".nav a { margin-right: 1em; }\n";
+}
+
+GalleryExporter::GalleryExporter(const QList<Photo> &photos, const QString &directory,
+                                 const Settings &settings, QObject *parent) :
+    QObject(parent),
+    photos(photos),
+    output(directory),
+    settings(settings),
+    cancelled(false),
+    rendered_count(0)
+{
+}
+
+GalleryExporter::~GalleryExporter()
+{
+    cancel();
+    future.waitForFinished();
+}
+
+void GalleryExporter::start()
+{
+    if(future.isRunning())
+        return;
+
+    cancelled = false;
+    future = QtConcurrent::run(this, &GalleryExporter::run);
+}
+
+void GalleryExporter::cancel()
+{
+    cancelled = true;
+}
+
+QStringList GalleryExporter::errors() const
+{
+    QMutexLocker lock(&error_mutex);
+    return error_list;
+}
+
+QString GalleryExporter::settings_key() const
+{
+    return QString("t%1 s%2 q%3").arg(settings.thumbnail_size).arg(settings.screen_size)
+                                 .arg(settings.quality);
+}
+
+QHash<QString, GalleryExporter::Record> GalleryExporter::read_manifest() const
+{
+    QHash<QString, Record> records;
+    QFile file(output + "/" + ManifestName);
+    if(!file.open(QFile::ReadOnly | QFile::Text))
+        return records;
+
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while(!in.atEnd())
+    {
+        QStringList fields = in.readLine().split('\t');
+        if(fields.size() != 7)
+            continue;
+
+        Record record;
+        record.size = fields[1].toLongLong();
+        record.modified = fields[2].toLongLong();
+        record.settings = fields[3];
+        record.full_name = fields[4];
+        record.page = fields[5].toLatin1();
+        record.edits = fields[6];
+        records.insert(fields[0], record);
+    }
+    return records;
+}
+
+bool GalleryExporter::write_manifest(const QHash<QString, Record> &records) const
+{
+    QSaveFile file(output + "/" + ManifestName);
+    if(!file.open(QFile::WriteOnly | QFile::Text))
+        return false;
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    for(QHash<QString, Record>::const_iterator it = records.constBegin(); it != records.constEnd(); ++it)
+    {
+        out << it.key() << '\t' << it->size << '\t' << it->modified << '\t' << it->settings
+            << '\t' << it->full_name << '\t' << QString(it->page) << '\t' << it->edits << '\n';
+    }
+    out.flush();
+    return file.commit();
+}
+
+//Writes html to path unless the page already there has the same contents.
+//*hash is the hash of the page last written and is updated.
+bool GalleryExporter::write_page(const QString &path, const QString &html, QByteArray *hash)
+{
+    QByteArray bytes = html.toUtf8();
+    QByteArray new_hash = QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex();
+    if(hash != NULL && *hash == new_hash && QFile::exists(path))
+        return true;
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size() || !file.commit())
+        return false;
+
+    if(hash != NULL)
+        *hash = new_hash;
+    return true;
+}
+
+//Makes every rendition of one photo from a single decode
+bool GalleryExporter::render_photo(const Photo &photo, const QString &id, Record *record,
+                                   QString *error)
+{
+    TRACE_SCOPE("render_photo", "export");
+
+    QString suffix = QFileInfo(photo.path).suffix().toLower();
+    bool copy_full = is_web_format(suffix) && photo.edits.is_empty();
+
+    //Unless the full size has to be re-encoded, decode no larger than the
+    //screen rendition. JPEGs scale down while decoding. Edits are made at
+    //full size, since their crops are in its pixels.
+    QImageReader reader(photo.path);
+    QSize size = reader.size();
+    QSize screen_box(settings.screen_size, settings.screen_size);
+    if(copy_full && size.isValid()
+       && (size.width() > settings.screen_size || size.height() > settings.screen_size))
+    {
+        reader.setScaledSize(size.scaled(screen_box, Qt::KeepAspectRatio));
+    }
+
+    QImage decoded;
+    {
+        TRACE_SCOPE("decode", "decode");
+        decoded = reader.read();
+    }
+    if(decoded.isNull())
+    {
+        *error = photo.path + ": " + reader.errorString();
+        return false;
+    }
+
+    if(!photo.edits.is_empty())
+    {
+        TRACE_SCOPE("render_edits", "filter");
+        decoded = photo.edits.render(decoded);
+    }
+
+    //The scaled renditions are written without EXIF, so a photo the camera
+    //stored on its side is turned upright before it is scaled
+    int orientation = ExifReader::orientation(photo.path);
+    if(orientation != 1)
+        decoded = decoded.transformed(ExifReader::transform(orientation));
+
+    QImage screen = decoded;
+    if(decoded.width() > settings.screen_size || decoded.height() > settings.screen_size)
+        screen = decoded.scaled(screen_box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    QImage thumbnail = screen.scaled(settings.thumbnail_size, settings.thumbnail_size,
+                                     Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    if(!save_image(thumbnail, output + "/thumbs/" + id + ".jpg", "jpg", settings.quality, error)
+       || !save_image(screen, output + "/screen/" + id + ".jpg", "jpg", settings.quality, error))
+    {
+        error->prepend(photo.path + ": ");
+        return false;
+    }
+
+    //The original itself when browsers can show it as it is, else a
+    //lossless PNG
+    QString full_name = copy_full ? id + "." + suffix : id + ".png";
+    QString full_path = output + "/full/" + full_name;
+    if(copy_full)
+    {
+        QFile::remove(full_path);
+        if(!QFile::copy(photo.path, full_path))
+        {
+            *error = photo.path + ": cannot copy to " + full_path;
+            return false;
+        }
+    }
+    else if(!save_image(decoded, full_path, "png", -1, error))
+    {
+        error->prepend(photo.path + ": ");
+        return false;
+    }
+
+    record->full_name = full_name;
+    return true;
+}
+
+QString GalleryExporter::photo_page(int index, const QStringList &ids,
+                                    const QHash<QString, Record> &records) const
+{
+    const Photo &photo = photos[index];
+    const QString &id = ids[index];
+    QString name = QFileInfo(photo.path).fileName();
+
+    QString html = page_header(name, "../");
+    html += "<div class=\"nav\">";
+    if(index > 0)
+        html += QString("<a href=\"%1.html\">&larr; Previous</a>").arg(ids[index - 1]);
+    html += QString("<a href=\"../%1\">Index</a>").arg(index_name(index / IndexPageSize));
+    if(index + 1 < ids.size())
+        html += QString("<a href=\"%1.html\">Next &rarr;</a>").arg(ids[index + 1]);
+    html += "</div>\n";
+
+    html += QString("<div class=\"photo\"><a href=\"../full/%1\"><img src=\"../screen/%2.jpg\" "
+                    "alt=\"%3\"></a></div>\n")
+            .arg(records.value(id).full_name, id, photo.description.toHtmlEscaped());
+
+    if(!photo.date.isEmpty())
+        html += "<p class=\"date\">" + photo.date.toHtmlEscaped() + "</p>\n";
+    if(!photo.location.isEmpty())
+        html += "<p class=\"location\">" + photo.location.toHtmlEscaped() + "</p>\n";
+    if(!photo.description.isEmpty())
+        html += "<p class=\"description\">" + photo.description.toHtmlEscaped() + "</p>\n";
+
+    html += "</body>\n</html>\n";
+    return html;
+}
+
+QStringList GalleryExporter::index_pages(const QStringList &ids) const
+{
+    QStringList all;
+    int pages = qMax(1, (ids.size() + IndexPageSize - 1) / IndexPageSize);
+    for(int page = 0; page < pages; page++)
+    {
+        QString html = page_header(settings.title, "");
+        html += "<h1>" + settings.title.toHtmlEscaped() + "</h1>\n";
+
+        html += "<div class=\"nav\">";
+        for(int other = 0; other < pages && pages > 1; other++)
+        {
+            if(other == page)
+                html += QString("<b>%1</b> ").arg(other + 1);
+            else
+                html += QString("<a href=\"%1\">%2</a> ").arg(index_name(other)).arg(other + 1);
+        }
+        html += "</div>\n<div class=\"grid\">\n";
+
+        int end = qMin(ids.size(), (page + 1) * IndexPageSize);
+        for(int i = page * IndexPageSize; i < end; i++)
+        {
+            html += QString("<a href=\"photos/%1.html\"><img src=\"thumbs/%1.jpg\" loading=\"lazy\" "
+                            "alt=\"%2\"></a>\n")
+                    .arg(ids[i], photos[i].description.toHtmlEscaped());
+        }
+        html += "</div>\n</body>\n</html>\n";
+        all.append(html);
+    }
+    return all;
+}
+
+//Runs on a worker thread
+void GalleryExporter::run()
+{
+    TRACE_SCOPE("export_gallery", "export");
+
+    QDir directory(output);
+    QStringList subdirectories = QStringList() << "thumbs" << "screen" << "full" << "photos";
+    for(int i = 0; i < subdirectories.size(); i++)
+    {
+        if(!directory.mkpath(subdirectories[i]))
+        {
+            QMutexLocker lock(&error_mutex);
+            error_list.append("Cannot create " + output + "/" + subdirectories[i]);
+            emit finished();
+            return;
+        }
+    }
+
+    //Ids follow the source path; a file in the album twice gets a suffix
+    int count = photos.size();
+    QStringList ids;
+    QSet<QString> used;
+    for(int i = 0; i < count; i++)
+    {
+        QString id = photo_id(photos[i].path);
+        for(int n = 2; used.contains(id); n++)
+        {
+            id = photo_id(photos[i].path) + "_" + QString::number(n);
+        }
+        used.insert(id);
+        ids.append(id);
+    }
+
+    QHash<QString, Record> previous = read_manifest();
+    QString key = settings_key();
+
+    //Renditions, in parallel. Each task only writes its own record.
+    QVector<Record> records(count);
+    Record *record_data = records.data();
+    QVector<int> indices(count);
+    for(int i = 0; i < count; i++)
+    {
+        indices[i] = i;
+    }
+
+    std::atomic<int> done(0);
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        //A cancelled export keeps the previous record of what is on disk
+        if(cancelled)
+        {
+            record_data[i] = previous.value(ids[i]);
+            return;
+        }
+
+        QFileInfo info(photos[i].path);
+        Record record;
+        record.size = info.size();
+        record.modified = info.lastModified().toMSecsSinceEpoch();
+        record.settings = key;
+        record.edits = photos[i].edits.key();
+
+        QHash<QString, Record>::const_iterator old = previous.constFind(ids[i]);
+        bool current = old != previous.constEnd() && old->size == record.size
+                       && old->modified == record.modified && old->settings == key
+                       && old->edits == record.edits
+                       && QFile::exists(output + "/full/" + old->full_name)
+                       && QFile::exists(output + "/screen/" + ids[i] + ".jpg")
+                       && QFile::exists(output + "/thumbs/" + ids[i] + ".jpg");
+
+        QString error;
+        if(current)
+        {
+            record.full_name = old->full_name;
+            record.page = old->page;
+        }
+        else if(render_photo(photos[i], ids[i], &record, &error))
+        {
+            //Adding or removing edits changes the full size file's name
+            if(old != previous.constEnd() && !old->full_name.isEmpty()
+               && old->full_name != record.full_name)
+                QFile::remove(output + "/full/" + old->full_name);
+            rendered_count++;
+        }
+        else
+        {
+            QMutexLocker lock(&error_mutex);
+            error_list.append(error);
+            record.settings.clear(); //Try again next time
+        }
+        record_data[i] = record;
+
+        int finished_count = ++done;
+        if(finished_count % 16 == 0 || finished_count == count)
+            emit progress(finished_count, count);
+    });
+
+    QHash<QString, Record> exported;
+    for(int i = 0; i < count; i++)
+    {
+        exported.insert(ids[i], records[i]);
+    }
+
+    //Photo pages, in parallel, only written when their contents changed
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        if(cancelled)
+            return;
+
+        QString path = output + "/photos/" + ids[i] + ".html";
+        if(!write_page(path, photo_page(i, ids, exported), &record_data[i].page))
+        {
+            QMutexLocker lock(&error_mutex);
+            error_list.append("Cannot write " + path);
+        }
+    });
+
+    //Index pages and the stylesheet
+    QStringList pages = index_pages(ids);
+    for(int page = 0; page < pages.size(); page++)
+    {
+        write_page(output + "/" + index_name(page), pages[page], NULL);
+    }
+    write_page(output + "/gallery.css", Stylesheet, NULL);
+
+    //Remove what is left of photos that are no longer in the album
+    for(QHash<QString, Record>::const_iterator it = previous.constBegin(); it != previous.constEnd(); ++it)
+    {
+        if(used.contains(it.key()))
+            continue;
+
+        QFile::remove(output + "/thumbs/" + it.key() + ".jpg");
+        QFile::remove(output + "/screen/" + it.key() + ".jpg");
+        QFile::remove(output + "/photos/" + it.key() + ".html");
+        if(!it->full_name.isEmpty())
+            QFile::remove(output + "/full/" + it->full_name);
+    }
+    for(int page = pages.size(); QFile::exists(output + "/" + index_name(page)); page++)
+    {
+        QFile::remove(output + "/" + index_name(page));
+    }
+
+    exported.clear();
+    for(int i = 0; i < count; i++)
+    {
+        if(!records[i].settings.isEmpty())
+            exported.insert(ids[i], records[i]);
+    }
+    if(!write_manifest(exported))
+    {
+        QMutexLocker lock(&error_mutex);
+        error_list.append("Cannot write " + output + "/" + ManifestName);
+    }
+
+    emit finished();
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The GalleryExporter class, which publishes an album as a
+//static web gallery on a background thread. The gallery has an index page
+//of thumbnails and one page per photo with its date, location and
+//description, linking to a screen sized rendition and the full size photo.
+//
+//Photos are processed in parallel. Each photo is decoded once, at the
+//largest size any rendition needs, and the smaller renditions are scaled
+//from that. JPEG, PNG and GIF originals without edits are copied as the
+//full size rendition without decoding them at all. A photo's edits are
+//rendered into all of its renditions.
+//
+//Exports are incremental: a manifest in the output directory records the
+//size and modification time of every source, its edits and the settings it
+//was rendered with, so photos that have not changed are skipped, and pages are
+//only rewritten when their contents change. Renditions of photos no longer
+//in the album are deleted.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GALLERY_EXPORTER_H
+#define GALLERY_EXPORTER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <atomic>
+#include "edit_recipe.h"
+
+class GalleryExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    //The information of one <photo>
+    struct Photo
+    {
+        QString path;
+        QString date;
+        QString location;
+        QString description;
+        EditRecipe edits;
+    };
+
+    struct Settings
+    {
+        int thumbnail_size; //Longest side of a thumbnail in pixels
+        int screen_size;    //Longest side of the screen rendition
+        int quality;        //JPEG quality of the scaled renditions
+        QString title;
+
+        Settings() : thumbnail_size(240), screen_size(1600), quality(85) {}
+    };
+
+    GalleryExporter(const QList<Photo> &photos, const QString &directory,
+                    const Settings &settings = Settings(), QObject *parent = 0);
+    ~GalleryExporter();
+
+    //Starts the export in the background. finished() is emitted when it is
+    //done, failed or cancelled.
+    void start();
+    void cancel();
+
+    QString directory() const { return output; }
+    int rendered() const { return rendered_count; } //Photos not skipped
+    QStringList errors() const;
+
+signals:
+    void progress(int done, int total);
+    void finished();
+
+private:
+    //What the manifest records about one exported photo
+    struct Record
+    {
+        qint64 size;
+        qint64 modified;
+        QString settings;   //Settings key the renditions were made with
+        QString edits;      //EditRecipe::key() of the edits rendered
+        QString full_name;  //File name of the full size rendition
+        QByteArray page;    //Hash of the photo page's contents
+    };
+
+    void run();
+    bool render_photo(const Photo &photo, const QString &id, Record *record, QString *error);
+    bool write_page(const QString &path, const QString &html, QByteArray *hash);
+    QString photo_page(int index, const QStringList &ids, const QHash<QString, Record> &records) const;
+    QStringList index_pages(const QStringList &ids) const;
+    QString settings_key() const;
+
+    QHash<QString, Record> read_manifest() const;
+    bool write_manifest(const QHash<QString, Record> &records) const;
+
+    QList<Photo> photos;
+    QString output;
+    Settings settings;
+    std::atomic<bool> cancelled;
+    std::atomic<int> rendered_count;
+    mutable QMutex error_mutex;
+    QStringList error_list;
+    QFuture<void> future;
+};
+
+#endif // GALLERY_EXPORTER_H
@@ -0,0 +1,323 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the Histogram and ToneCurve classes declared
+//in histogram.h. Pixels are read straight from scanLine() memory as 32 bit
+//words. Counting alternates between two sets of bins, because adjacent
+//pixels of a photo usually have the same value and incrementing one counter
+//twice in a row makes each increment wait for the previous one.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "histogram.h"
+#include "trace.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+//Images smaller than this are not worth splitting across threads
+const qint64 MinParallelPixels = 256 * 1024;
+
+//Number of histograms kept by Histogram::of()
+const int CachedHistograms = 16;
+
+QMutex cache_mutex;
+QCache<qint64, Histogram> cache(CachedHistograms);
+
+//Luminance in 0-255 from the Rec. 601 weights scaled to sum to 256
+inline int luminance(int r, int g, int b)
+{
+    return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
+//Returns image in a format whose pixels are whole 32 bit words of colour
+//that is not premultiplied by alpha, so counts and curves see true colours
+QImage as_32bit(const QImage &image)
+{
+    if(image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        return image;
+    return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                         : QImage::Format_RGB32);
+}
+
+//Calls work(first, last) for bands of rows covering height, one band per
+//thread, and returns once every band is done
+void for_each_band(const QImage &image, std::function<void(int, int)> work)
+{
+    int height = image.height();
+    int bands = 1;
+    if(qint64(image.width()) * height >= MinParallelPixels)
+        bands = qBound(1, QThread::idealThreadCount(), height);
+
+    QVector<int> indices(bands);
+    for(int band = 0; band < bands; band++)
+    {
+        indices[band] = band;
+    }
+
+    QtConcurrent::blockingMap(indices, [&](int band)
+    {
+        work(height * band / bands, height * (band + 1) / bands);
+    });
+}
+}
+
+Histogram::Histogram() :
+    pixels(0)
+{
+    std::memset(bins, 0, sizeof(bins));
+}
+
+Histogram &Histogram::operator+=(const Histogram &other)
+{
+    for(int channel = 0; channel < ChannelCount; channel++)
+    {
+        for(int value = 0; value < Bins; value++)
+        {
+            bins[channel][value] += other.bins[channel][value];
+        }
+    }
+    pixels += other.pixels;
+    return *this;
+}
+
+//Counts rows first up to (not including) last of a 32 bit image
+void Histogram::count_rows(const QImage &image, int first, int last)
+{
+    //Two sets of bins for even and odd pixels, merged at the end
+    static const int Sets = 2;
+    quint32 partial[Sets][ChannelCount][Bins];
+    std::memset(partial, 0, sizeof(partial));
+
+    int width = image.width();
+    for(int y = first; y < last; y++)
+    {
+        const quint32 *line = reinterpret_cast<const quint32 *>(image.constScanLine(y));
+        int x = 0;
+        for(; x + 1 < width; x += 2)
+        {
+            quint32 p = line[x], q = line[x + 1];
+            int r0 = (p >> 16) & 0xff, g0 = (p >> 8) & 0xff, b0 = p & 0xff;
+            int r1 = (q >> 16) & 0xff, g1 = (q >> 8) & 0xff, b1 = q & 0xff;
+            partial[0][Red][r0]++;
+            partial[1][Red][r1]++;
+            partial[0][Green][g0]++;
+            partial[1][Green][g1]++;
+            partial[0][Blue][b0]++;
+            partial[1][Blue][b1]++;
+            partial[0][Luminance][luminance(r0, g0, b0)]++;
+            partial[1][Luminance][luminance(r1, g1, b1)]++;
+        }
+        if(x < width)
+        {
+            quint32 p = line[x];
+            int r = (p >> 16) & 0xff, g = (p >> 8) & 0xff, b = p & 0xff;
+            partial[0][Red][r]++;
+            partial[0][Green][g]++;
+            partial[0][Blue][b]++;
+            partial[0][Luminance][luminance(r, g, b)]++;
+        }
+    }
+
+    for(int channel = 0; channel < ChannelCount; channel++)
+    {
+        for(int value = 0; value < Bins; value++)
+        {
+            bins[channel][value] = partial[0][channel][value] + partial[1][channel][value];
+        }
+    }
+    pixels = qint64(width) * (last - first);
+}
+
+Histogram Histogram::compute(const QImage &image)
+{
+    TRACE_SCOPE("histogram", "filter");
+
+    Histogram result;
+    if(image.isNull())
+        return result;
+
+    QImage pixels32 = as_32bit(image);
+
+    //Every band counts into its own histogram, summed once all are done
+    QMutex mutex;
+    for_each_band(pixels32, [&](int first, int last)
+    {
+        Histogram band;
+        band.count_rows(pixels32, first, last);
+
+        QMutexLocker lock(&mutex);
+        result += band;
+    });
+
+    return result;
+}
+
+Histogram Histogram::of(const QImage &image)
+{
+    qint64 key = image.cacheKey();
+    {
+        QMutexLocker lock(&cache_mutex);
+        if(Histogram *cached = cache.object(key))
+            return *cached;
+    }
+
+    Histogram result = compute(image);
+
+    QMutexLocker lock(&cache_mutex);
+    cache.insert(key, new Histogram(result));
+    return result;
+}
+
+quint32 Histogram::max_count(Channel channel) const
+{
+    quint32 largest = 0;
+    for(int value = 0; value < Bins; value++)
+    {
+        largest = qMax(largest, bins[channel][value]);
+    }
+    return largest;
+}
+
+int Histogram::percentile(Channel channel, double fraction) const
+{
+    //At least one pixel, so a fraction of 0 is the darkest value present,
+    //and at most all of them, so 1 is the brightest. The small tolerance
+    //keeps 1.0 - clip from rounding up past the pixels it means.
+    qint64 target = qint64(std::ceil(fraction * pixels - 1e-6));
+    target = qBound(qint64(1), target, qMax(pixels, qint64(1)));
+
+    qint64 sum = 0;
+    for(int value = 0; value < Bins; value++)
+    {
+        sum += bins[channel][value];
+        if(sum >= target)
+            return value;
+    }
+    return Bins - 1;
+}
+
+ToneCurve::ToneCurve()
+{
+    for(int channel = 0; channel < 3; channel++)
+    {
+        stretch(channel, 0, Histogram::Bins - 1);
+    }
+}
+
+//Maps low to 0 and high to 255 linearly in channel, clamping everything
+//outside
+void ToneCurve::stretch(int channel, int low, int high)
+{
+    uchar *table = tables[channel];
+    lows[channel] = low;
+    highs[channel] = high;
+    if(high <= low)
+    {
+        //A flat channel has nothing to stretch
+        for(int value = 0; value < Histogram::Bins; value++)
+        {
+            table[value] = uchar(value);
+        }
+        return;
+    }
+
+    for(int value = 0; value < Histogram::Bins; value++)
+    {
+        int mapped = ((value - low) * 255 + (high - low) / 2) / (high - low);
+        table[value] = uchar(qBound(0, mapped, 255));
+    }
+}
+
+ToneCurve ToneCurve::auto_levels(const Histogram &histogram, double clip)
+{
+    ToneCurve curve;
+    if(histogram.is_empty())
+        return curve;
+
+    for(int channel = Histogram::Red; channel <= Histogram::Blue; channel++)
+    {
+        Histogram::Channel c = Histogram::Channel(channel);
+        curve.stretch(channel, histogram.percentile(c, clip),
+                      histogram.percentile(c, 1.0 - clip));
+    }
+    return curve;
+}
+
+ToneCurve ToneCurve::auto_contrast(const Histogram &histogram, double clip)
+{
+    ToneCurve curve;
+    if(histogram.is_empty())
+        return curve;
+
+    //The darkest and brightest of the three channels set one common stretch
+    int low = Histogram::Bins - 1, high = 0;
+    for(int channel = Histogram::Red; channel <= Histogram::Blue; channel++)
+    {
+        Histogram::Channel c = Histogram::Channel(channel);
+        low = qMin(low, histogram.percentile(c, clip));
+        high = qMax(high, histogram.percentile(c, 1.0 - clip));
+    }
+
+    for(int channel = 0; channel < 3; channel++)
+    {
+        curve.stretch(channel, low, high);
+    }
+    return curve;
+}
+
+ToneCurve ToneCurve::levels(const int low[3], const int high[3])
+{
+    ToneCurve curve;
+    for(int channel = 0; channel < 3; channel++)
+    {
+        curve.stretch(channel, qBound(0, low[channel], Histogram::Bins - 1),
+                      qBound(0, high[channel], Histogram::Bins - 1));
+    }
+    return curve;
+}
+
+QImage ToneCurve::apply(const QImage &image) const
+{
+    TRACE_SCOPE("tone_curve", "filter");
+
+    if(image.isNull())
+        return image;
+
+    QImage source = as_32bit(image);
+    QImage result(source.size(), source.format());
+
+    //Take the pointers up front so the worker threads never detach result
+    uchar *bits = result.bits();
+    int bytes_per_line = result.bytesPerLine();
+    const uchar *red = tables[0], *green = tables[1], *blue = tables[2];
+
+    for_each_band(source, [&](int first, int last)
+    {
+        int width = source.width();
+        for(int y = first; y < last; y++)
+        {
+            const quint32 *in = reinterpret_cast<const quint32 *>(source.constScanLine(y));
+            quint32 *out = reinterpret_cast<quint32 *>(bits + qint64(y) * bytes_per_line);
+            for(int x = 0; x < width; x++)
+            {
+                quint32 p = in[x];
+                out[x] = (p & 0xff000000)
+                         | (quint32(red[(p >> 16) & 0xff]) << 16)
+                         | (quint32(green[(p >> 8) & 0xff]) << 8)
+                         | quint32(blue[p & 0xff]);
+            }
+        }
+    });
+
+    return result;
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The Histogram class, the tonal distribution of an image per
+//color channel and for luminance, and the ToneCurve class, a per channel
+//lookup table built from a histogram.
+//
+//A histogram is computed in a single pass over the scanlines, split into
+//bands of rows that are counted on separate threads and then summed.
+//Histograms are cached by the image's cacheKey(), so asking again for the
+//histogram of an unchanged image costs nothing.
+//
+//ToneCurve::auto_levels() stretches each channel on its own between its
+//darkest and brightest values, which also removes color casts.
+//ToneCurve::auto_contrast() stretches all three channels by the same amount,
+//which keeps the colors as they are.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QImage>
+#include <QVector>
+
+class Histogram
+{
+public:
+    enum Channel { Red, Green, Blue, Luminance, ChannelCount };
+
+    static const int Bins = 256;
+
+    Histogram();
+
+    //Counts every pixel of image
+    static Histogram compute(const QImage &image);
+
+    //Like compute(), but returns the cached histogram when image has not
+    //changed since its histogram was last asked for
+    static Histogram of(const QImage &image);
+
+    bool is_empty() const { return pixels == 0; }
+    qint64 total() const { return pixels; }
+    quint32 count(Channel channel, int value) const { return bins[channel][value]; }
+    quint32 max_count(Channel channel) const;
+
+    //Smallest value with at least fraction of the pixels at or below it
+    int percentile(Channel channel, double fraction) const;
+
+    Histogram &operator+=(const Histogram &other);
+
+private:
+    void count_rows(const QImage &image, int first, int last);
+
+    quint32 bins[ChannelCount][Bins];
+    qint64 pixels;
+};
+
+class ToneCurve
+{
+public:
+    //The identity curve
+    ToneCurve();
+
+    //Clip is the fraction of pixels allowed to turn pure black or pure white
+    //at each end, so a few outliers do not limit the stretch
+    static ToneCurve auto_levels(const Histogram &histogram, double clip);
+    static ToneCurve auto_contrast(const Histogram &histogram, double clip);
+
+    //Stretches each channel from low to high, the curve an auto adjustment
+    //chose, so it can be kept and applied again without the histogram
+    static ToneCurve levels(const int low[3], const int high[3]);
+
+    //The values of channel (0 red, 1 green, 2 blue) stretched to 0 and 255
+    int low(int channel) const { return lows[channel]; }
+    int high(int channel) const { return highs[channel]; }
+
+    int map(int channel, int value) const { return tables[channel][value]; }
+
+    //Returns image with the curve applied to every pixel
+    QImage apply(const QImage &image) const;
+
+private:
+    void stretch(int channel, int low, int high);
+
+    uchar tables[3][Histogram::Bins]; //Red, green and blue
+    int lows[3];
+    int highs[3];
+};
+
+#endif // HISTOGRAM_H
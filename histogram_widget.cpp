@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the HistogramWidget class declared in
+//histogram_widget.h. All channels share one vertical scale so they can be
+//compared; the pure black and pure white bins are left out of it, since
+//clipped photos pile up there and would flatten everything else.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "histogram_widget.h"
+#include <QPainter>
+#include <QPainterPath>
+
+HistogramWidget::HistogramWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+QSize HistogramWidget::sizeHint() const
+{
+    return QSize(Histogram::Bins, 64);
+}
+
+void HistogramWidget::set_histogram(const Histogram &histogram)
+{
+    this->histogram = histogram;
+    update();
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().dark());
+
+    if(histogram.is_empty())
+        return;
+
+    //Tallest bin of any channel, not counting the two end bins
+    quint32 largest = 1;
+    for(int channel = 0; channel < Histogram::ChannelCount; channel++)
+    {
+        for(int value = 1; value < Histogram::Bins - 1; value++)
+        {
+            largest = qMax(largest, histogram.count(Histogram::Channel(channel), value));
+        }
+    }
+
+    double bin_width = double(width()) / Histogram::Bins;
+    int h = height();
+
+    const QColor colors[Histogram::ChannelCount] =
+        { QColor(255, 64, 64), QColor(64, 200, 64), QColor(64, 128, 255), QColor(200, 200, 200) };
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    //Luminance first, filled, with the color channels drawn over it
+    for(int channel = Histogram::ChannelCount - 1; channel >= 0; channel--)
+    {
+        QPainterPath path(QPointF(0, h));
+        for(int value = 0; value < Histogram::Bins; value++)
+        {
+            quint32 count = qMin(histogram.count(Histogram::Channel(channel), value), largest);
+            path.lineTo((value + 0.5) * bin_width, h - double(count) * (h - 1) / largest);
+        }
+        path.lineTo(width(), h);
+
+        if(channel == Histogram::Luminance)
+        {
+            painter.fillPath(path, colors[channel]);
+        }
+        else
+        {
+            painter.setPen(colors[channel]);
+            painter.drawPath(path);
+        }
+    }
+}
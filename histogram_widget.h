@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The HistogramWidget class, which draws a Histogram as a gray
+//luminance area with the red, green and blue channels outlined on top. It
+//is shown in the balance widget and follows the preview image as the
+//slider moves.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HISTOGRAM_WIDGET_H
+#define HISTOGRAM_WIDGET_H
+
+#include <QWidget>
+#include "histogram.h"
+
+class HistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistogramWidget(QWidget *parent = 0);
+
+    void set_histogram(const Histogram &histogram);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    Histogram histogram;
+};
+
+#endif // HISTOGRAM_WIDGET_H
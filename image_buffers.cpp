@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the ImageBufferManager class declared in
+//image_buffers.h. All bookkeeping happens under one mutex so owners can
+//report from worker threads, but the caches' evictors are always called with
+//the mutex released, since evicting means calling back into release().
+///////////////////////////////////////////////////////////////////////////////
+
+#include "image_buffers.h"
+#include <QMutexLocker>
+#include <QSet>
+
+namespace
+{
+//Budget used until set_budget() is called
+const qint64 DefaultBudget = qint64(1024) * 1024 * 1024;
+}
+
+ImageBufferManager::ImageBufferManager(QObject *parent) :
+    QObject(parent),
+    budget_bytes(DefaultBudget)
+{
+}
+
+ImageBufferManager *ImageBufferManager::instance()
+{
+    static ImageBufferManager manager;
+    return &manager;
+}
+
+qint64 ImageBufferManager::image_bytes(const QImage &image)
+{
+    return qint64(image.bytesPerLine()) * image.height();
+}
+
+void ImageBufferManager::track(const QString &owner, const QImage &image)
+{
+    if(image.isNull())
+    {
+        release(owner);
+        return;
+    }
+
+    {
+        QMutexLocker lock(&mutex);
+        Buffer buffer = {image.cacheKey(), image_bytes(image)};
+        buffers.insert(owner, buffer);
+    }
+
+    enforce_budget();
+}
+
+void ImageBufferManager::track_bytes(const QString &owner, qint64 bytes)
+{
+    if(bytes <= 0)
+    {
+        release(owner);
+        return;
+    }
+
+    {
+        QMutexLocker lock(&mutex);
+        Buffer buffer = {0, bytes};
+        buffers.insert(owner, buffer);
+    }
+
+    enforce_budget();
+}
+
+void ImageBufferManager::release(const QString &owner)
+{
+    qint64 total;
+    {
+        QMutexLocker lock(&mutex);
+        if(buffers.remove(owner) == 0)
+            return;
+        total = total_locked();
+    }
+
+    emit usage_changed(total, budget());
+}
+
+void ImageBufferManager::register_cache(const QString &name, Evictor evict)
+{
+    QMutexLocker lock(&mutex);
+    caches.append(qMakePair(name, evict));
+}
+
+void ImageBufferManager::set_budget(qint64 bytes)
+{
+    {
+        QMutexLocker lock(&mutex);
+        budget_bytes = bytes;
+    }
+
+    enforce_budget();
+}
+
+qint64 ImageBufferManager::budget() const
+{
+    QMutexLocker lock(&mutex);
+    return budget_bytes;
+}
+
+qint64 ImageBufferManager::total_bytes() const
+{
+    QMutexLocker lock(&mutex);
+    return total_locked();
+}
+
+qint64 ImageBufferManager::exclusive_bytes(const QString &owner) const
+{
+    QMutexLocker lock(&mutex);
+    QHash<QString, Buffer>::const_iterator held = buffers.constFind(owner);
+    if(held == buffers.constEnd())
+        return 0;
+    if(held->key == 0)
+        return held->bytes;
+
+    for(QHash<QString, Buffer>::const_iterator it = buffers.constBegin();
+        it != buffers.constEnd(); ++it)
+    {
+        if(it->key == held->key && it.key() != owner)
+            return 0;
+    }
+    return held->bytes;
+}
+
+//Sums every owner's buffer, skipping buffers that share a cacheKey with one
+//already counted (implicitly shared copies of the same pixels)
+qint64 ImageBufferManager::total_locked() const
+{
+    QSet<qint64> counted;
+    qint64 total = 0;
+    for(QHash<QString, Buffer>::const_iterator it = buffers.constBegin();
+        it != buffers.constEnd(); ++it)
+    {
+        if(it->key != 0)
+        {
+            if(counted.contains(it->key))
+                continue;
+            counted.insert(it->key);
+        }
+        total += it->bytes;
+    }
+    return total;
+}
+
+//Asks each registered cache in turn to free memory until bytes have been
+//freed or every cache has been asked. Returns the bytes freed.
+qint64 ImageBufferManager::evict(qint64 bytes)
+{
+    QVector<QPair<QString, Evictor> > to_ask;
+    {
+        QMutexLocker lock(&mutex);
+        to_ask = caches;
+    }
+
+    qint64 freed = 0;
+    for(int i = 0; i < to_ask.size() && freed < bytes; i++)
+    {
+        freed += to_ask[i].second(bytes - freed);
+    }
+    return freed;
+}
+
+void ImageBufferManager::enforce_budget()
+{
+    qint64 total = total_bytes();
+    qint64 limit = budget();
+
+    if(total > limit)
+    {
+        evict(total - limit);
+        total = total_bytes();
+    }
+
+    emit usage_changed(total, limit);
+}
+
+bool ImageBufferManager::reserve(qint64 bytes)
+{
+    qint64 available = budget() - total_bytes();
+    if(bytes <= available)
+        return true;
+
+    evict(bytes - available);
+    return bytes <= budget() - total_bytes();
+}
+
+QString ImageBufferManager::summary() const
+{
+    const double MB = 1024.0 * 1024.0;
+    return QString("Images: %1 / %2 MB")
+            .arg(total_bytes() / MB, 0, 'f', 1)
+            .arg(budget() / MB, 0, 'f', 0);
+}
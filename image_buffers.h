@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The ImageBufferManager class, which keeps a central account of
+//every live decoded pixel buffer in the application. Each holder of an image
+//(the main window, the preview, the Cropper, the decode cache...) reports
+//what it holds under an owner name. Buffers are counted by their QImage
+//cacheKey, so implicitly shared copies of one image are only counted once.
+//
+//The manager enforces a configurable budget: when the total goes over it,
+//registered caches are asked to evict until the total fits again. Code that
+//is about to decode a large image can call reserve() first to find out
+//whether the decoded buffer will fit.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_BUFFERS_H
+#define IMAGE_BUFFERS_H
+
+#include <QObject>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <functional>
+
+class ImageBufferManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Called with the number of bytes a cache should free.
+    //Returns the number of bytes actually freed.
+    typedef std::function<qint64(qint64)> Evictor;
+
+    static ImageBufferManager *instance();
+
+    //Records that owner now holds image, replacing whatever it held before.
+    //A null image is the same as release(owner).
+    void track(const QString &owner, const QImage &image);
+
+    //Records that owner holds a buffer that is not a QImage (e.g. a QPixmap)
+    void track_bytes(const QString &owner, qint64 bytes);
+
+    //Records that owner no longer holds any buffer
+    void release(const QString &owner);
+
+    //Registers a cache that can give memory back under pressure. Caches are
+    //asked to evict in the order they were registered.
+    void register_cache(const QString &name, Evictor evict);
+
+    void set_budget(qint64 bytes);
+    qint64 budget() const;
+
+    //Total bytes held by every owner, counting shared buffers once
+    qint64 total_bytes() const;
+
+    //Bytes owner releasing its buffer would free: none if another owner
+    //shares it
+    qint64 exclusive_bytes(const QString &owner) const;
+
+    //Returns true if a new buffer of the given size fits in the budget,
+    //evicting caches to make room if needed
+    bool reserve(qint64 bytes);
+
+    //Short human readable usage string for the status bar
+    QString summary() const;
+
+    //Bytes used by the pixel data of image
+    static qint64 image_bytes(const QImage &image);
+
+signals:
+    void usage_changed(qint64 total, qint64 budget);
+
+private:
+    explicit ImageBufferManager(QObject *parent = 0);
+
+    struct Buffer
+    {
+        qint64 key;   //QImage::cacheKey(), or 0 for untyped buffers
+        qint64 bytes;
+    };
+
+    qint64 total_locked() const;
+    qint64 evict(qint64 bytes);
+    void enforce_budget();
+
+    mutable QMutex mutex;
+    QHash<QString, Buffer> buffers; //Owner name -> what it holds
+    QVector<QPair<QString, Evictor> > caches;
+    qint64 budget_bytes;
+};
+
+#endif // IMAGE_BUFFERS_H
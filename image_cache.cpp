@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the ImageCache class declared in
+//image_cache.h. Proxies are stored next to full resolution entries under
+//their own key, so a proxy is never mistaken for the real image. Calls into
+//the ImageBufferManager are always made with the cache mutex released,
+//because tracking a new entry may make the manager call back into evict().
+///////////////////////////////////////////////////////////////////////////////
+
+#include "image_cache.h"
+#include "image_buffers.h"
+#include "edit_recipe.h"
+#include "trace.h"
+#include <QImageReader>
+#include <QMutexLocker>
+
+namespace
+{
+//Owner name prefix for entries reported to the ImageBufferManager
+const QString OwnerPrefix = "ImageCache:";
+
+//Suffix added to a path to form the cache key of its proxy
+const QString ProxySuffix = "#proxy";
+
+//Separates a path from the edits in the cache key of a render
+const QString RenderSeparator = "#edits:";
+}
+
+ImageCache::ImageCache()
+{
+    ImageBufferManager::instance()->register_cache("ImageCache",
+        [this](qint64 bytes) { return evict(bytes); });
+}
+
+ImageCache *ImageCache::instance()
+{
+    static ImageCache cache;
+    return &cache;
+}
+
+QImage ImageCache::find_key(const QString &key)
+{
+    QMutexLocker lock(&mutex);
+
+    QHash<QString, QImage>::const_iterator it = images.constFind(key);
+    if(it == images.constEnd())
+        return QImage();
+
+    //Mark as most recently used
+    lru.removeOne(key);
+    lru.append(key);
+    return it.value();
+}
+
+void ImageCache::insert_key(const QString &key, const QImage &image)
+{
+    {
+        QMutexLocker lock(&mutex);
+        images.insert(key, image);
+        lru.removeOne(key);
+        lru.append(key);
+    }
+
+    ImageBufferManager::instance()->track(OwnerPrefix + key, image);
+}
+
+void ImageCache::remove_key(const QString &key)
+{
+    {
+        QMutexLocker lock(&mutex);
+        if(images.remove(key) == 0)
+            return;
+        lru.removeOne(key);
+    }
+
+    ImageBufferManager::instance()->release(OwnerPrefix + key);
+}
+
+QImage ImageCache::find(const QString &path)
+{
+    return find_key(path);
+}
+
+//Drops every render of path
+void ImageCache::remove_renders(const QString &path)
+{
+    QStringList keys;
+    {
+        QMutexLocker lock(&mutex);
+        QString prefix = path + RenderSeparator;
+        for(int i = 0; i < lru.size(); i++)
+        {
+            if(lru[i].startsWith(prefix))
+                keys.append(lru[i]);
+        }
+    }
+
+    for(int i = 0; i < keys.size(); i++)
+    {
+        remove_key(keys[i]);
+    }
+}
+
+void ImageCache::insert(const QString &path, const QImage &image)
+{
+    //A full resolution image makes any proxy or render of the same path stale
+    remove_key(path + ProxySuffix);
+    remove_renders(path);
+    insert_key(path, image);
+}
+
+void ImageCache::remove(const QString &path)
+{
+    remove_key(path);
+    remove_key(path + ProxySuffix);
+    remove_renders(path);
+}
+
+QImage ImageCache::find_render(const QString &path, const QString &edits)
+{
+    return find_key(path + RenderSeparator + edits);
+}
+
+void ImageCache::insert_render(const QString &path, const QString &edits, const QImage &image)
+{
+    insert_key(path + RenderSeparator + edits, image);
+}
+
+void ImageCache::clear()
+{
+    QStringList keys;
+    {
+        QMutexLocker lock(&mutex);
+        keys = lru;
+        images.clear();
+        lru.clear();
+    }
+
+    for(int i = 0; i < keys.size(); i++)
+    {
+        ImageBufferManager::instance()->release(OwnerPrefix + keys[i]);
+    }
+}
+
+qint64 ImageCache::evict(qint64 bytes)
+{
+    QStringList keys;
+    {
+        QMutexLocker lock(&mutex);
+        keys = lru;
+    }
+
+    QStringList evicted;
+    qint64 freed = 0;
+    for(int i = 0; i < keys.size() && freed < bytes; i++)
+    {
+        //Pixels also held by the window, a preview or a write stay in
+        //memory whether the cache drops them or not, so they are kept
+        qint64 held = ImageBufferManager::instance()->exclusive_bytes(OwnerPrefix + keys[i]);
+        if(held == 0)
+            continue;
+
+        QMutexLocker lock(&mutex);
+        if(images.remove(keys[i]) == 0)
+            continue;
+        lru.removeOne(keys[i]);
+        freed += held;
+        evicted.append(keys[i]);
+    }
+
+    for(int i = 0; i < evicted.size(); i++)
+    {
+        ImageBufferManager::instance()->release(OwnerPrefix + evicted[i]);
+    }
+    return freed;
+}
+
+QImage ImageCache::load(const QString &path, const QSize &proxy_size, bool *is_proxy)
+{
+    if(is_proxy)
+        *is_proxy = false;
+
+    QImage image = find_key(path);
+    if(!image.isNull())
+        return image;
+
+    //Read just the header to find out how large the decoded image will be
+    QImageReader reader(path);
+    QSize full_size = reader.size();
+    qint64 full_bytes = qint64(full_size.width()) * full_size.height() * 4;
+
+    if(!full_size.isValid() || proxy_size.isEmpty()
+       || ImageBufferManager::instance()->reserve(full_bytes))
+    {
+        TRACE_SCOPE("decode", "decode");
+        reader.read(&image);
+        if(!image.isNull())
+            insert_key(path, image);
+        return image;
+    }
+
+    //The full image does not fit, so fall back to a proxy
+    if(is_proxy)
+        *is_proxy = true;
+
+    image = find_key(path + ProxySuffix);
+    if(!image.isNull())
+        return image;
+
+    TRACE_SCOPE("decode_proxy", "decode");
+    reader.setScaledSize(full_size.scaled(proxy_size, Qt::KeepAspectRatio));
+    reader.read(&image);
+    if(!image.isNull())
+        insert_key(path + ProxySuffix, image);
+    return image;
+}
+
+QImage ImageCache::load_render(const QString &path, const EditRecipe &edits,
+                               const QSize &proxy_size, bool *is_proxy)
+{
+    if(edits.is_empty())
+        return load(path, proxy_size, is_proxy);
+
+    if(is_proxy)
+        *is_proxy = false;
+    QString key = edits.key();
+    QImage image = find_render(path, key);
+    if(!image.isNull())
+        return image;
+
+    bool proxy = false;
+    QImage original = load(path, proxy_size, &proxy);
+    if(proxy)
+    {
+        if(is_proxy)
+            *is_proxy = true;
+        QSize full_size = QImageReader(path).size();
+        double scale = full_size.isEmpty() ? 1 : double(original.width()) / full_size.width();
+        return edits.render(original, scale);
+    }
+
+    image = edits.render(original);
+    if(!image.isNull())
+        insert_render(path, key, image);
+    return image;
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The ImageCache class, a least-recently-used cache of decoded
+//photos keyed by file path. It keeps display_photo() from decoding the same
+//file again on every window resize or page back and forth. Every entry is
+//reported to the ImageBufferManager, which asks the cache to evict its
+//oldest entries whenever the image memory budget is exceeded.
+//
+//Photos too large to decode within the budget are decoded as a reduced
+//size proxy instead, so that huge panoramas can still be displayed.
+//
+//Renders of a photo's edit recipe are cached beside its decode, keyed by
+//the recipe, and are dropped together with it when the file changes.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+class EditRecipe;
+
+class ImageCache
+{
+public:
+    static ImageCache *instance();
+
+    //Returns the cached full resolution image for path, or a null image
+    QImage find(const QString &path);
+
+    //Adds or replaces the full resolution image for path
+    void insert(const QString &path, const QImage &image);
+
+    //Drops every cached image (full, proxy or render) for path
+    void remove(const QString &path);
+
+    //Returns the cached full resolution render of path with the edits whose
+    //EditRecipe::key() is edits, or a null image
+    QImage find_render(const QString &path, const QString &edits);
+    void insert_render(const QString &path, const QString &edits, const QImage &image);
+
+    void clear();
+
+    //Returns the decoded image at path, from the cache when possible. If the
+    //full image does not fit in the memory budget, a proxy scaled to fit
+    //within proxy_size is returned instead and *is_proxy is set to true.
+    QImage load(const QString &path, const QSize &proxy_size, bool *is_proxy = 0);
+
+    //Returns the photo at path with edits made, as load() does. A render
+    //of the full image is cached; a render of a proxy is made every time.
+    QImage load_render(const QString &path, const EditRecipe &edits, const QSize &proxy_size,
+                       bool *is_proxy = 0);
+
+    //Frees at least bytes by dropping the least recently used entries
+    //whose pixels no one else holds. Returns the number of bytes actually
+    //freed.
+    qint64 evict(qint64 bytes);
+
+private:
+    ImageCache();
+
+    QImage find_key(const QString &key);
+    void insert_key(const QString &key, const QImage &image);
+    void remove_key(const QString &key);
+    void remove_renders(const QString &path);
+
+    QMutex mutex;
+    QHash<QString, QImage> images;
+    QStringList lru; //Cache keys, least recently used first
+};
+
+#endif // IMAGE_CACHE_H
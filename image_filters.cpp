@@ -0,0 +1,659 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the ImageFilters class declared in
+//image_filters.h. Pixels are read straight from the image memory as 32 bit
+//words; the destination's bits are fetched once before the threads start,
+//since scanLine() on a shared image would detach it from every thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "image_filters.h"
+#include "trace.h"
+#include <QThread>
+#include <QtConcurrent>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace
+{
+//Images smaller than this are not worth splitting across threads
+const qint64 MinParallelPixels = 256 * 1024;
+
+//Histogram bins per channel, and coarse bins of 16 values each
+const int Bins = 256;
+const int CoarseBins = 16;
+const int FineBins = Bins / CoarseBins;
+
+//Memory the bilateral grid stays under, by growing its cells if needed
+const qint64 MaxGridBytes = 64 * 1024 * 1024;
+
+//Smallest bilateral grid cell, in pixels
+const int MinCellSize = 4;
+
+//Cells of padding around the grid, the reach of the grid blur
+const int GridPadding = 2;
+
+//Box blurs stacked to approximate a Gaussian
+const int BoxPasses = 3;
+
+//Sigma below which blurring changes nothing visible
+const double MinSigma = 0.5;
+
+//Returns image in a format whose pixels are whole 32 bit words
+QImage as_32bit(const QImage &image)
+{
+    switch(image.format())
+    {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return image;
+    default:
+        return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                             : QImage::Format_RGB32);
+    }
+}
+
+//Luminance in 0-255 from the Rec. 601 weights scaled to sum to 256
+inline int luminance(quint32 p)
+{
+    return (77 * ((p >> 16) & 0xff) + 150 * ((p >> 8) & 0xff) + 29 * (p & 0xff)) >> 8;
+}
+
+//Runs work(0) to work(count - 1) on the thread pool and returns once all
+//of them are done
+void parallel_for(int count, std::function<void(int)> work)
+{
+    QVector<int> indices(count);
+    for(int i = 0; i < count; i++)
+    {
+        indices[i] = i;
+    }
+    QtConcurrent::blockingMap(indices, [&](int i) { work(i); });
+}
+
+//Number of pieces to split an image into, at most limit
+int pieces(const QImage &image, int limit)
+{
+    if(qint64(image.width()) * image.height() < MinParallelPixels)
+        return 1;
+    return qBound(1, QThread::idealThreadCount() * 2, limit);
+}
+
+//The pixels of a 32 bit image as raw memory
+struct Pixels
+{
+    uchar *bits;
+    int stride;
+    int width;
+    int height;
+
+    quint32 *line(int y) const
+    {
+        return reinterpret_cast<quint32 *>(bits + qint64(y) * stride);
+    }
+
+    //Pixel at x, y with the edge pixels repeated outside the image
+    quint32 clamped(int x, int y) const
+    {
+        return line(qBound(0, y, height - 1))[qBound(0, x, width - 1)];
+    }
+};
+
+//Histograms of one column of the median window: 256 fine and 16 coarse
+//bins for each of red, green and blue
+struct ColumnHistogram
+{
+    quint16 fine[3][Bins];
+    quint16 coarse[3][CoarseBins];
+
+    void add(quint32 p, int delta)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            int value = (p >> (16 - 8 * c)) & 0xff;
+            fine[c][value] += delta;
+            coarse[c][value / FineBins] += delta;
+        }
+    }
+};
+
+//Median filters the columns first up to (not including) last of source into
+//target. The strip keeps a histogram for each of its columns plus radius
+//columns on either side.
+void median_strip(const Pixels &source, const Pixels &target, int radius, int first, int last)
+{
+    const int window = 2 * radius + 1;
+    const int half = window * window / 2;
+    const int columns = last - first + 2 * radius;
+    const int unknown = -window - 1; //Marks a fine kernel bin as out of date
+
+    //Column j covers image column first - radius + j
+    std::vector<ColumnHistogram> histograms(columns);
+    for(int j = 0; j < columns; j++)
+    {
+        std::memset(&histograms[j], 0, sizeof(ColumnHistogram));
+        for(int dy = -radius; dy <= radius; dy++)
+        {
+            histograms[j].add(source.clamped(first - radius + j, dy), 1);
+        }
+    }
+
+    int coarse[3][CoarseBins];
+    int fine[3][Bins];
+    int fine_column[3][CoarseBins]; //Window start each fine bin is valid for
+
+    for(int y = 0; y < source.height; y++)
+    {
+        //Slide every column histogram down to row y
+        if(y > 0)
+        {
+            for(int j = 0; j < columns; j++)
+            {
+                int x = first - radius + j;
+                histograms[j].add(source.clamped(x, y - radius - 1), -1);
+                histograms[j].add(source.clamped(x, y + radius), 1);
+            }
+        }
+
+        //The coarse kernel of the first window; fine bins are filled lazily
+        std::memset(coarse, 0, sizeof(coarse));
+        for(int j = 0; j < window; j++)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                for(int b = 0; b < CoarseBins; b++)
+                {
+                    coarse[c][b] += histograms[j].coarse[c][b];
+                }
+            }
+        }
+        for(int c = 0; c < 3; c++)
+        {
+            for(int b = 0; b < CoarseBins; b++)
+            {
+                fine_column[c][b] = unknown;
+            }
+        }
+
+        const quint32 *in = source.line(y);
+        quint32 *out = target.line(y);
+        for(int k = 0; k < last - first; k++)
+        {
+            //Window k spans columns k to k + 2 * radius
+            if(k > 0)
+            {
+                const ColumnHistogram &added = histograms[k + window - 1];
+                const ColumnHistogram &removed = histograms[k - 1];
+                for(int c = 0; c < 3; c++)
+                {
+                    for(int b = 0; b < CoarseBins; b++)
+                    {
+                        coarse[c][b] += added.coarse[c][b] - removed.coarse[c][b];
+                    }
+                }
+            }
+
+            quint32 result = in[first + k] & 0xff000000;
+            for(int c = 0; c < 3; c++)
+            {
+                //Coarse bin holding the median
+                int count = 0;
+                int b = 0;
+                while(count + coarse[c][b] <= half)
+                {
+                    count += coarse[c][b];
+                    b++;
+                }
+
+                //Bring that bin's fine counts up to window k
+                int *bin = fine[c] + b * FineBins;
+                int valid = fine_column[c][b];
+                if(k - valid >= window)
+                {
+                    for(int i = 0; i < FineBins; i++)
+                    {
+                        bin[i] = 0;
+                    }
+                    for(int j = k; j < k + window; j++)
+                    {
+                        const quint16 *column = histograms[j].fine[c] + b * FineBins;
+                        for(int i = 0; i < FineBins; i++)
+                        {
+                            bin[i] += column[i];
+                        }
+                    }
+                }
+                else
+                {
+                    for(int m = valid + 1; m <= k; m++)
+                    {
+                        const quint16 *added = histograms[m + window - 1].fine[c] + b * FineBins;
+                        const quint16 *removed = histograms[m - 1].fine[c] + b * FineBins;
+                        for(int i = 0; i < FineBins; i++)
+                        {
+                            bin[i] += added[i] - removed[i];
+                        }
+                    }
+                }
+                fine_column[c][b] = k;
+
+                int i = 0;
+                while(count + bin[i] <= half)
+                {
+                    count += bin[i];
+                    i++;
+                }
+                result |= quint32(b * FineBins + i) << (16 - 8 * c);
+            }
+            out[first + k] = result;
+        }
+    }
+}
+
+//Radii of the BoxPasses box blurs whose succession approximates a Gaussian
+//of sigma: the widths are the two odd numbers around the ideal width, as
+//many of each as gives the closest variance
+void box_radii(double sigma, int radii[BoxPasses])
+{
+    const int n = BoxPasses;
+    double variance = 12 * sigma * sigma;
+    int lower = int(std::floor(std::sqrt(variance / n + 1)));
+    if(lower % 2 == 0)
+        lower--;
+    lower = qMax(lower, 1);
+    int upper = lower + 2;
+    int lower_count = int(std::floor((variance - n * lower * lower - 4 * n * lower - 3 * n)
+                                     / (-4 * lower - 4) + 0.5));
+    for(int i = 0; i < n; i++)
+    {
+        radii[i] = ((i < lower_count ? lower : upper) - 1) / 2;
+    }
+}
+
+//Box blurs rows first up to (not including) last of source along x into
+//target, keeping a running sum per channel
+void box_rows(const Pixels &source, const Pixels &target, int radius, int first, int last)
+{
+    const int window = 2 * radius + 1;
+    const int width = source.width;
+    for(int y = first; y < last; y++)
+    {
+        const quint32 *in = source.line(y);
+        quint32 *out = target.line(y);
+
+        int sums[3] = {0, 0, 0};
+        for(int i = -radius; i <= radius; i++)
+        {
+            quint32 p = in[qBound(0, i, width - 1)];
+            sums[0] += (p >> 16) & 0xff;
+            sums[1] += (p >> 8) & 0xff;
+            sums[2] += p & 0xff;
+        }
+
+        for(int x = 0; x < width; x++)
+        {
+            out[x] = (in[x] & 0xff000000)
+                     | (quint32((sums[0] + window / 2) / window) << 16)
+                     | (quint32((sums[1] + window / 2) / window) << 8)
+                     | quint32((sums[2] + window / 2) / window);
+
+            quint32 added = in[qMin(x + radius + 1, width - 1)];
+            quint32 removed = in[qMax(x - radius, 0)];
+            sums[0] += int((added >> 16) & 0xff) - int((removed >> 16) & 0xff);
+            sums[1] += int((added >> 8) & 0xff) - int((removed >> 8) & 0xff);
+            sums[2] += int(added & 0xff) - int(removed & 0xff);
+        }
+    }
+}
+
+//Box blurs columns first up to (not including) last of source along y into
+//target. The strip's running sums move down the image together, so every
+//row is read in order.
+void box_columns(const Pixels &source, const Pixels &target, int radius, int first, int last)
+{
+    const int window = 2 * radius + 1;
+    const int height = source.height;
+    std::vector<int> sums(3 * (last - first), 0);
+
+    for(int i = -radius; i <= radius; i++)
+    {
+        const quint32 *in = source.line(qBound(0, i, height - 1));
+        for(int x = first; x < last; x++)
+        {
+            int *sum = &sums[3 * (x - first)];
+            sum[0] += (in[x] >> 16) & 0xff;
+            sum[1] += (in[x] >> 8) & 0xff;
+            sum[2] += in[x] & 0xff;
+        }
+    }
+
+    for(int y = 0; y < height; y++)
+    {
+        const quint32 *in = source.line(y);
+        const quint32 *added = source.line(qMin(y + radius + 1, height - 1));
+        const quint32 *removed = source.line(qMax(y - radius, 0));
+        quint32 *out = target.line(y);
+        for(int x = first; x < last; x++)
+        {
+            int *sum = &sums[3 * (x - first)];
+            out[x] = (in[x] & 0xff000000)
+                     | (quint32((sum[0] + window / 2) / window) << 16)
+                     | (quint32((sum[1] + window / 2) / window) << 8)
+                     | quint32((sum[2] + window / 2) / window);
+
+            sum[0] += int((added[x] >> 16) & 0xff) - int((removed[x] >> 16) & 0xff);
+            sum[1] += int((added[x] >> 8) & 0xff) - int((removed[x] >> 8) & 0xff);
+            sum[2] += int(added[x] & 0xff) - int(removed[x] & 0xff);
+        }
+    }
+}
+
+//Size of a bilateral grid, with cells of cell pixels and range luminance
+//levels
+struct Grid
+{
+    int cell;
+    int range;
+    int width;
+    int height;
+    int depth;
+
+    Grid(int image_width, int image_height, int cell, int range) :
+        cell(cell),
+        range(range)
+    {
+        width = (image_width - 1 + cell / 2) / cell + 1 + 2 * GridPadding;
+        height = (image_height - 1 + cell / 2) / cell + 1 + 2 * GridPadding;
+        depth = (255 + range / 2) / range + 1 + 2 * GridPadding;
+    }
+
+    qint64 cells() const { return qint64(width) * height * depth; }
+
+    //Offset of the red, green, blue and weight sums of a cell
+    qint64 at(int x, int y, int z) const
+    {
+        return ((qint64(y) * width + x) * depth + z) * 4;
+    }
+};
+
+//Blurs grid data along one axis (0 for x, 1 for y, 2 for luminance) with
+//the binomial kernel 1 4 6 4 1, into blurred
+void blur_grid(const Grid &grid, const float *data, float *blurred, int axis)
+{
+    static const float Weights[5] = {1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f};
+
+    parallel_for(grid.height, [&](int y)
+    {
+        for(int x = 0; x < grid.width; x++)
+        {
+            for(int z = 0; z < grid.depth; z++)
+            {
+                float sums[4] = {0, 0, 0, 0};
+                for(int k = -2; k <= 2; k++)
+                {
+                    int nx = x + (axis == 0 ? k : 0);
+                    int ny = y + (axis == 1 ? k : 0);
+                    int nz = z + (axis == 2 ? k : 0);
+                    if(nx < 0 || nx >= grid.width || ny < 0 || ny >= grid.height
+                       || nz < 0 || nz >= grid.depth)
+                        continue;
+                    const float *cell = data + grid.at(nx, ny, nz);
+                    for(int i = 0; i < 4; i++)
+                    {
+                        sums[i] += Weights[k + 2] * cell[i];
+                    }
+                }
+                float *out = blurred + grid.at(x, y, z);
+                for(int i = 0; i < 4; i++)
+                {
+                    out[i] = sums[i];
+                }
+            }
+        }
+    });
+}
+}
+
+QImage ImageFilters::median(const QImage &image, int radius)
+{
+    TRACE_SCOPE("median", "filter");
+
+    radius = qMin(radius, int(MaxMedianRadius));
+    if(image.isNull() || radius <= 0)
+        return image;
+
+    QImage source = as_32bit(image);
+    QImage result(source.size(), source.format());
+
+    Pixels in = {const_cast<uchar *>(source.constBits()), source.bytesPerLine(),
+                 source.width(), source.height()};
+    Pixels out = {result.bits(), result.bytesPerLine(), result.width(), result.height()};
+
+    //Vertical strips, so each thread slides its own column histograms down
+    //the whole image
+    int strips = pieces(source, qMax(1, source.width() / 64));
+    parallel_for(strips, [&](int strip)
+    {
+        median_strip(in, out, radius, in.width * strip / strips, in.width * (strip + 1) / strips);
+    });
+    return result;
+}
+
+QImage ImageFilters::bilateral(const QImage &image, int radius, int range_sigma)
+{
+    TRACE_SCOPE("bilateral", "filter");
+
+    if(image.isNull() || radius <= 0)
+        return image;
+
+    QImage source = as_32bit(image);
+    int width = source.width();
+    int height = source.height();
+
+    //A cell per radius pixels, grown until the grid fits its memory limit
+    int cell = qMax(radius, MinCellSize);
+    int range = qBound(1, range_sigma, 255);
+    while(Grid(width, height, cell, range).cells() * 4 * qint64(sizeof(float)) > MaxGridBytes)
+    {
+        cell++;
+    }
+    Grid grid(width, height, cell, range);
+
+    std::vector<float> data(grid.cells() * 4, 0.0f);
+    std::vector<float> blurred(data.size());
+
+    Pixels in = {const_cast<uchar *>(source.constBits()), source.bytesPerLine(), width, height};
+
+    //Accumulate every pixel into its nearest cell. Bands own whole rows of
+    //cells, so no two threads add to the same cell.
+    int cell_rows = (height - 1 + cell / 2) / cell + 1;
+    int bands = pieces(source, cell_rows);
+    parallel_for(bands, [&](int band)
+    {
+        int first_cell = cell_rows * band / bands;
+        int last_cell = cell_rows * (band + 1) / bands;
+        int first = qMax(0, first_cell * cell - cell / 2);
+        int last = qMin(height, last_cell * cell - cell / 2);
+        for(int y = first; y < last; y++)
+        {
+            const quint32 *line = in.line(y);
+            int gy = (y + cell / 2) / cell + GridPadding;
+            for(int x = 0; x < width; x++)
+            {
+                quint32 p = line[x];
+                int gx = (x + cell / 2) / cell + GridPadding;
+                int gz = (luminance(p) + range / 2) / range + GridPadding;
+                float *sums = data.data() + grid.at(gx, gy, gz);
+                sums[0] += (p >> 16) & 0xff;
+                sums[1] += (p >> 8) & 0xff;
+                sums[2] += p & 0xff;
+                sums[3] += 1;
+            }
+        }
+    });
+
+    //Blurring the grid smooths over space and luminance at once
+    blur_grid(grid, data.data(), blurred.data(), 0);
+    blur_grid(grid, blurred.data(), data.data(), 1);
+    blur_grid(grid, data.data(), blurred.data(), 2);
+
+    //Read every pixel back from the grid at its position and luminance
+    QImage result(source.size(), source.format());
+    Pixels out = {result.bits(), result.bytesPerLine(), width, height};
+    const float *smoothed = blurred.data();
+    bands = pieces(source, height);
+    parallel_for(bands, [&](int band)
+    {
+        int first = height * band / bands;
+        int last = height * (band + 1) / bands;
+        for(int y = first; y < last; y++)
+        {
+            const quint32 *line = in.line(y);
+            quint32 *target = out.line(y);
+            float fy = float(y) / cell + GridPadding;
+            int y0 = int(fy);
+            float ty = fy - y0;
+            for(int x = 0; x < width; x++)
+            {
+                quint32 p = line[x];
+                float fx = float(x) / cell + GridPadding;
+                float fz = float(luminance(p)) / range + GridPadding;
+                int x0 = int(fx);
+                int z0 = int(fz);
+                float tx = fx - x0;
+                float tz = fz - z0;
+
+                //Trilinear interpolation of the eight surrounding cells
+                float sums[4] = {0, 0, 0, 0};
+                for(int corner = 0; corner < 8; corner++)
+                {
+                    int dx = corner & 1, dy = (corner >> 1) & 1, dz = (corner >> 2) & 1;
+                    float weight = (dx ? tx : 1 - tx) * (dy ? ty : 1 - ty) * (dz ? tz : 1 - tz);
+                    const float *cell_sums = smoothed + grid.at(x0 + dx, y0 + dy, z0 + dz);
+                    for(int i = 0; i < 4; i++)
+                    {
+                        sums[i] += weight * cell_sums[i];
+                    }
+                }
+
+                if(sums[3] <= 1e-6f)
+                {
+                    target[x] = p;
+                    continue;
+                }
+                int r = qBound(0, int(sums[0] / sums[3] + 0.5f), 255);
+                int g = qBound(0, int(sums[1] / sums[3] + 0.5f), 255);
+                int b = qBound(0, int(sums[2] / sums[3] + 0.5f), 255);
+                target[x] = (p & 0xff000000) | (r << 16) | (g << 8) | b;
+            }
+        }
+    });
+    return result;
+}
+
+QImage ImageFilters::gaussian_blur(const QImage &image, double sigma)
+{
+    TRACE_SCOPE("gaussian_blur", "filter");
+
+    if(image.isNull() || sigma < MinSigma)
+        return image;
+
+    QImage source = as_32bit(image);
+    int width = source.width();
+    int height = source.height();
+    int radii[BoxPasses];
+    box_radii(sigma, radii);
+
+    //Every pass blurs the rows into buffer and the columns of buffer into
+    //result, which the next pass starts from
+    QImage buffer(source.size(), source.format());
+    QImage result(source.size(), source.format());
+    Pixels in = {const_cast<uchar *>(source.constBits()), source.bytesPerLine(), width, height};
+    Pixels temp = {buffer.bits(), buffer.bytesPerLine(), width, height};
+    Pixels out = {result.bits(), result.bytesPerLine(), width, height};
+
+    int bands = pieces(source, height);
+    int strips = pieces(source, qMax(1, width / 64));
+    for(int pass = 0; pass < BoxPasses; pass++)
+    {
+        const Pixels &from = pass == 0 ? in : out;
+        int radius = radii[pass];
+        parallel_for(bands, [&](int band)
+        {
+            box_rows(from, temp, radius, height * band / bands, height * (band + 1) / bands);
+        });
+        parallel_for(strips, [&](int strip)
+        {
+            box_columns(temp, out, radius, width * strip / strips, width * (strip + 1) / strips);
+        });
+    }
+    return result;
+}
+
+int ImageFilters::gaussian_reach(double sigma)
+{
+    if(sigma < MinSigma)
+        return 0;
+
+    int radii[BoxPasses];
+    box_radii(sigma, radii);
+    int reach = 0;
+    for(int pass = 0; pass < BoxPasses; pass++)
+    {
+        reach += radii[pass];
+    }
+    return reach;
+}
+
+QImage ImageFilters::unsharp_mask(const QImage &image, double amount, double radius, int threshold)
+{
+    TRACE_SCOPE("unsharp_mask", "filter");
+
+    if(image.isNull() || amount <= 0 || radius < MinSigma)
+        return image;
+
+    QImage source = as_32bit(image);
+    QImage blurred = gaussian_blur(source, radius);
+    QImage result(source.size(), source.format());
+    int width = source.width();
+    int height = source.height();
+
+    Pixels in = {const_cast<uchar *>(source.constBits()), source.bytesPerLine(), width, height};
+    Pixels soft = {const_cast<uchar *>(blurred.constBits()), blurred.bytesPerLine(), width, height};
+    Pixels out = {result.bits(), result.bytesPerLine(), width, height};
+
+    //Amount in 1/256ths, so the per pixel work is integer only
+    int gain = int(amount * 256 + 0.5);
+    int bands = pieces(source, height);
+    parallel_for(bands, [&](int band)
+    {
+        int last = height * (band + 1) / bands;
+        for(int y = height * band / bands; y < last; y++)
+        {
+            const quint32 *original = in.line(y);
+            const quint32 *smooth = soft.line(y);
+            quint32 *target = out.line(y);
+            for(int x = 0; x < width; x++)
+            {
+                quint32 p = original[x];
+                quint32 result_pixel = p & 0xff000000;
+                for(int shift = 16; shift >= 0; shift -= 8)
+                {
+                    int value = (p >> shift) & 0xff;
+                    int difference = value - int((smooth[x] >> shift) & 0xff);
+                    if(difference >= threshold || -difference >= threshold)
+                        value = qBound(0, value + difference * gain / 256, 255);
+                    result_pixel |= quint32(value) << shift;
+                }
+                target[x] = result_pixel;
+            }
+        }
+    });
+    return result;
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The ImageFilters class, neighbourhood filters whose cost per
+//pixel does not grow with their radius, so a large radius on a full size
+//photo is still interactive. Every filter splits the image across threads
+//and keeps the alpha channel as it was.
+//
+//  - median() uses per column histograms (Perreault and Hebert): moving the
+//    window one pixel adds one column histogram and removes another, and the
+//    fine bins are only brought up to date for the coarse bin holding the
+//    median.
+//  - bilateral() uses a bilateral grid (Paris and Durand): the pixels are
+//    accumulated into a coarse 3D grid of position and luminance, the grid
+//    is blurred, and every pixel reads its result back by interpolation.
+//  - gaussian_blur() runs three box blurs in succession, whose widths are
+//    chosen so the result is close to a Gaussian (Kovesi). A box blur keeps
+//    a running sum, so it costs the same at any width.
+//  - unsharp_mask() adds back the difference between the image and its
+//    Gaussian blur.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_FILTERS_H
+#define IMAGE_FILTERS_H
+
+#include <QImage>
+
+class ImageFilters
+{
+public:
+    //Largest radius median() accepts
+    static const int MaxMedianRadius = 127;
+
+    //Luminance difference the bilateral filter smooths across, out of 255
+    static const int DefaultRangeSigma = 24;
+
+    //Replaces every pixel by the per channel median of the square of
+    //radius around it. Removes speckle noise while keeping edges sharp.
+    static QImage median(const QImage &image, int radius);
+
+    //Smooths image over about radius pixels, but only across luminance
+    //differences up to about range_sigma, so edges are kept
+    static QImage bilateral(const QImage &image, int radius, int range_sigma = DefaultRangeSigma);
+
+    //Blurs image with a Gaussian of sigma pixels
+    static QImage gaussian_blur(const QImage &image, double sigma);
+
+    //How many pixels away gaussian_blur() reads from at sigma. Blurring a
+    //region grown by this much gives the same pixels inside it as blurring
+    //the whole image.
+    static int gaussian_reach(double sigma);
+
+    //Sharpens image by amount times its difference from a Gaussian blur of
+    //sigma radius. Differences below threshold (out of 255) are left
+    //alone, so smooth areas and noise are not sharpened.
+    static QImage unsharp_mask(const QImage &image, double amount, double radius, int threshold);
+};
+
+#endif // IMAGE_FILTERS_H
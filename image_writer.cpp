@@ -0,0 +1,284 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the ImageWriteQueue class declared in
+//image_writer.h. Each queued path is handled by a WriteTask on the queue's
+//own thread pool. QSaveFile provides the write-to-temporary-then-rename
+//behaviour, and the written()/failed() signals reach the GUI thread through
+//queued connections.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "image_writer.h"
+#include "image_buffers.h"
+#include "image_cache.h"
+#include "trace.h"
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+
+namespace
+{
+//Default limit on image bytes being encoded at once
+const qint64 DefaultMaxPending = qint64(512) * 1024 * 1024;
+
+//Default limit on image bytes queued or being written
+const qint64 DefaultMaxQueued = qint64(1024) * 1024 * 1024;
+
+//Owner name prefix for queued images reported to the ImageBufferManager
+const QString OwnerPrefix = "ImageWriteQueue:";
+}
+
+//Writes the newest queued image for one path
+class WriteTask : public QRunnable
+{
+public:
+    WriteTask(ImageWriteQueue *queue, const QString &path) : queue(queue), path(path) {}
+    void run() { queue->run_job(path); }
+
+private:
+    ImageWriteQueue *queue;
+    QString path;
+};
+
+ImageWriteQueue::ImageWriteQueue(QObject *parent) :
+    QObject(parent),
+    pending_bytes(0),
+    waiting_bytes(0),
+    max_pending_bytes(DefaultMaxPending),
+    max_queued_bytes(DefaultMaxQueued)
+{
+    //Encoding is CPU bound; leave a core free for the GUI
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ImageWriteQueue *ImageWriteQueue::instance()
+{
+    static ImageWriteQueue queue;
+    return &queue;
+}
+
+void ImageWriteQueue::set_max_pending_bytes(qint64 bytes)
+{
+    QMutexLocker lock(&mutex);
+    max_pending_bytes = bytes;
+    start_waiting();
+}
+
+void ImageWriteQueue::set_max_queued_bytes(qint64 bytes)
+{
+    QMutexLocker lock(&mutex);
+    max_queued_bytes = bytes;
+}
+
+int ImageWriteQueue::pending() const
+{
+    QMutexLocker lock(&mutex);
+
+    int count = running.size();
+    for(QHash<QString, Job>::const_iterator it = queued.constBegin(); it != queued.constEnd(); ++it)
+    {
+        if(!running.contains(it.key()))
+            count++;
+    }
+    return count;
+}
+
+void ImageWriteQueue::wait_for_done()
+{
+    pool.waitForDone();
+}
+
+void ImageWriteQueue::wait_for(const QString &path)
+{
+    QMutexLocker lock(&mutex);
+    while(queued.contains(path) || running.contains(path))
+    {
+        path_done.wait(&mutex);
+    }
+}
+
+bool ImageWriteQueue::is_pending(const QString &path) const
+{
+    QMutexLocker lock(&mutex);
+    return queued.contains(path) || running.contains(path);
+}
+
+void ImageWriteQueue::enqueue(const QString &path, const QImage &image, int quality)
+{
+    Job job = {image, quality, Encoder()};
+    enqueue_job(path, job);
+}
+
+void ImageWriteQueue::enqueue_encoded(const QString &path, const QImage &image, Encoder encoder)
+{
+    Job job = {image, -1, encoder};
+    enqueue_job(path, job);
+}
+
+void ImageWriteQueue::enqueue_job(const QString &path, const Job &job)
+{
+    const QImage &image = job.image;
+
+    qint64 bytes = ImageBufferManager::image_bytes(image);
+    {
+        QMutexLocker lock(&mutex);
+
+        //The ImageCache cannot free pixels the queue holds, so the queue
+        //refuses writes rather than grow without bound. failed() is queued,
+        //so the caller has finished before it hears about it.
+        qint64 old_bytes = queued.contains(path)
+                           ? ImageBufferManager::image_bytes(queued[path].image) : 0;
+        if(pending_bytes > 0 && pending_bytes - old_bytes + bytes > max_queued_bytes)
+        {
+            QString error = "too many images are waiting to be saved";
+            QMetaObject::invokeMethod(this, "failed", Qt::QueuedConnection,
+                                      Q_ARG(QString, path), Q_ARG(QString, error));
+            return;
+        }
+
+        //Show the new version right away, whether or not it is on disk yet
+        ImageCache::instance()->insert(path, image);
+
+        //A write that has not started yet is superseded by this one
+        if(queued.contains(path))
+        {
+            pending_bytes -= old_bytes;
+            if(waiting.contains(path))
+                waiting_bytes -= old_bytes;
+        }
+
+        queued.insert(path, job);
+        pending_bytes += bytes;
+        ImageBufferManager::instance()->track(OwnerPrefix + path, image);
+
+        //A path already being written is restarted when that write finishes
+        if(running.contains(path))
+            return;
+        if(!waiting.contains(path))
+            waiting.append(path);
+        waiting_bytes += bytes;
+        start_waiting();
+    }
+}
+
+//Starts the writes held back, oldest first, while the images being written
+//stay within the limit. A write always starts when no other is running.
+//Called with the mutex held.
+void ImageWriteQueue::start_waiting()
+{
+    while(!waiting.isEmpty())
+    {
+        qint64 bytes = ImageBufferManager::image_bytes(queued.value(waiting.first()).image);
+        if(!running.isEmpty() && pending_bytes - waiting_bytes + bytes > max_pending_bytes)
+            return;
+        waiting_bytes -= bytes;
+        start_job(waiting.takeFirst());
+    }
+}
+
+//Called with the mutex held
+void ImageWriteQueue::start_job(const QString &path)
+{
+    running.insert(path);
+    pool.start(new WriteTask(this, path));
+}
+
+void ImageWriteQueue::run_job(const QString &path)
+{
+    Job job;
+    {
+        QMutexLocker lock(&mutex);
+        job = queued.take(path);
+    }
+
+    if(Tracer::is_enabled())
+        Tracer::set_thread_name("ImageWriteQueue");
+
+    QString error;
+    {
+        TRACE_SCOPE("encode_write", "encode");
+
+        //Custom encoders run before the file is opened, so a failing
+        //encoder leaves the original untouched
+        QByteArray encoded;
+        bool encoded_ok = !job.encoder || job.encoder(&encoded, &error);
+
+        QSaveFile file(path);
+        if(!encoded_ok)
+        {
+            //error was set by the encoder
+        }
+        else if(!file.open(QIODevice::WriteOnly))
+        {
+            error = file.errorString();
+        }
+        else if(job.encoder)
+        {
+            if(file.write(encoded) != encoded.size())
+            {
+                error = file.errorString();
+                file.cancelWriting();
+            }
+            else if(!file.commit()) //Atomically renames over the original
+            {
+                error = file.errorString();
+            }
+        }
+        else
+        {
+            QImageWriter writer(&file, QFileInfo(path).suffix().toLatin1());
+            if(job.quality >= 0)
+                writer.setQuality(job.quality);
+
+            if(!writer.write(job.image))
+            {
+                error = writer.errorString();
+                file.cancelWriting();
+            }
+            else if(!file.commit()) //Atomically renames over the original
+            {
+                error = file.errorString();
+            }
+        }
+    }
+
+    bool superseded;
+    {
+        QMutexLocker lock(&mutex);
+        pending_bytes -= ImageBufferManager::image_bytes(job.image);
+
+        //Write the newer image if one was queued while this one was written.
+        //It waits its turn like any other write.
+        running.remove(path);
+        superseded = queued.contains(path);
+        if(superseded)
+        {
+            waiting.append(path);
+            waiting_bytes += ImageBufferManager::image_bytes(queued[path].image);
+        }
+        else
+        {
+            ImageBufferManager::instance()->release(OwnerPrefix + path);
+            path_done.wakeAll();
+        }
+        start_waiting();
+    }
+
+    if(error.isEmpty())
+    {
+        emit written(path);
+        return;
+    }
+
+    //The cache shows pixels that never reached the file, unless a newer
+    //write of it is still to come
+    if(!superseded)
+        ImageCache::instance()->remove(path);
+    emit failed(path, error);
+}
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The ImageWriteQueue class, which encodes and writes images to
+//disk on background threads so that saving a processed photo never blocks
+//the GUI. Each write goes to a temporary file that is renamed over the
+//target only once the encode succeeded, so a failed or interrupted save
+//never leaves a half written photo behind.
+//
+//Writes to different files run in parallel. If a file is queued again
+//before its earlier write started, only the newest image is written. The
+//number of image bytes being written at once is bounded; a write over the
+//limit waits in the queue, without holding up enqueue(), until earlier
+//writes finish. The bytes held by the queue as a whole are bounded too: a
+//write that would go past that limit is refused and reported through
+//failed(), and the file is left as it is.
+//
+//Writes can also carry their own Encoder that produces the file's bytes on
+//the worker thread, e.g. a lossless JPEG transform of the current file.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <QObject>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <functional>
+
+class ImageWriteQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Produces the complete contents of the file to write. Returns false and
+    //sets the error message on failure.
+    typedef std::function<bool(QByteArray *, QString *)> Encoder;
+
+    static ImageWriteQueue *instance();
+
+    //Queues image to be encoded and written to path. The format is taken
+    //from the file suffix. The decode cache is updated right away, so the
+    //new version is shown without reading the file back, and is dropped
+    //again if the write fails. A refused write leaves the cache alone.
+    void enqueue(const QString &path, const QImage &image, int quality = -1);
+
+    //Queues a write whose bytes come from encoder, run on a worker thread.
+    //image is the decoded result and is only used to update the cache.
+    void enqueue_encoded(const QString &path, const QImage &image, Encoder encoder);
+
+    //Returns true while a write to path is queued or in progress
+    bool is_pending(const QString &path) const;
+
+    //Limit on the bytes of image data being encoded at once
+    void set_max_pending_bytes(qint64 bytes);
+
+    //Limit on the bytes of image data queued or being written. A single
+    //write is always accepted when nothing else is queued.
+    void set_max_queued_bytes(qint64 bytes);
+
+    //Number of files queued or being written
+    int pending() const;
+
+    //Blocks until every queued write has finished
+    void wait_for_done();
+
+    //Blocks until every queued write to path has finished, leaving writes
+    //to other files running
+    void wait_for(const QString &path);
+
+signals:
+    void written(QString path);
+    void failed(QString path, QString error);
+
+private:
+    explicit ImageWriteQueue(QObject *parent = 0);
+
+    struct Job
+    {
+        QImage image;
+        int quality;
+        Encoder encoder; //Used instead of QImageWriter when set
+    };
+
+    friend class WriteTask;
+    void enqueue_job(const QString &path, const Job &job);
+    void run_job(const QString &path);
+    void start_job(const QString &path);
+    void start_waiting();
+
+    mutable QMutex mutex;
+    QWaitCondition path_done;       //Signalled whenever a path's writes are done
+    QHash<QString, Job> queued;     //Writes waiting for a thread, by path
+    QSet<QString> running;          //Paths currently being written
+    QStringList waiting;            //Paths held back by the limit, oldest first
+    qint64 pending_bytes;           //Of every queued or running write
+    qint64 waiting_bytes;           //Of the writes held back
+    qint64 max_pending_bytes;
+    qint64 max_queued_bytes;
+    QThreadPool pool;
+};
+
+#endif // IMAGE_WRITER_H
@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the JpegScanlineReader class declared in
+//jpeg_scanline_reader.h. The file is memory mapped and handed to libjpeg,
+//which keeps its decoder state between calls to read(). libjpeg reports
+//errors by calling error_exit(), which jumps back out of the call with
+//longjmp.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "jpeg_scanline_reader.h"
+#include "jpeg_transform.h"
+#include "trace.h"
+
+#ifdef HAVE_LIBJPEG
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <jpeglib.h>
+
+namespace
+{
+struct ErrorManager
+{
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void error_exit(j_common_ptr cinfo)
+{
+    ErrorManager *err = reinterpret_cast<ErrorManager *>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    longjmp(err->jump, 1);
+}
+
+//Warnings (e.g. corrupt data that libjpeg can recover from) are ignored
+void output_message(j_common_ptr)
+{
+}
+}
+
+struct JpegScanlineReader::State
+{
+    jpeg_decompress_struct cinfo;
+    ErrorManager err;
+    bool created;
+};
+
+JpegScanlineReader::JpegScanlineReader(const QString &path) :
+    state(new State),
+    file(path),
+    ready(false)
+{
+    std::memset(&state->cinfo, 0, sizeof(state->cinfo));
+    state->created = false;
+}
+
+JpegScanlineReader::~JpegScanlineReader()
+{
+    if(state->created)
+        jpeg_destroy_decompress(&state->cinfo);
+    delete state;
+}
+
+bool JpegScanlineReader::open()
+{
+    if(!JpegTransform::is_jpeg(file.fileName()))
+    {
+        error = "Not a JPEG";
+        return false;
+    }
+    if(!file.open(QFile::ReadOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+    uchar *data = file.map(0, file.size());
+    if(data == NULL)
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    jpeg_decompress_struct *cinfo = &state->cinfo;
+    if(setjmp(state->err.jump))
+    {
+        error = state->err.message;
+        return false;
+    }
+
+    cinfo->err = jpeg_std_error(&state->err.pub);
+    state->err.pub.error_exit = error_exit;
+    state->err.pub.output_message = output_message;
+    jpeg_create_decompress(cinfo);
+    state->created = true;
+    jpeg_mem_src(cinfo, data, file.size());
+    jpeg_read_header(cinfo, TRUE);
+
+    //CMYK and YCCK photos are left to QImageReader
+    if(cinfo->jpeg_color_space == JCS_GRAYSCALE)
+        cinfo->out_color_space = JCS_GRAYSCALE;
+    else if(cinfo->jpeg_color_space == JCS_YCbCr || cinfo->jpeg_color_space == JCS_RGB)
+        cinfo->out_color_space = JCS_RGB;
+    else
+    {
+        error = "Unsupported JPEG color space";
+        return false;
+    }
+
+    jpeg_start_decompress(cinfo);
+    image_size = QSize(cinfo->output_width, cinfo->output_height);
+    ready = true;
+    return true;
+}
+
+QImage JpegScanlineReader::read(int rows)
+{
+    TRACE_SCOPE("decode_scanlines", "decode");
+
+    jpeg_decompress_struct *cinfo = &state->cinfo;
+    if(!ready)
+        return QImage();
+
+    int first = cinfo->output_scanline;
+    rows = qMin(rows, image_size.height() - first);
+    if(rows <= 0)
+        return QImage();
+
+    QImage strip(image_size.width(), rows, cinfo->out_color_space == JCS_GRAYSCALE
+                                           ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+    if(strip.isNull())
+    {
+        error = "Out of memory";
+        return strip;
+    }
+
+    if(setjmp(state->err.jump))
+    {
+        error = state->err.message;
+        ready = false;
+        return QImage();
+    }
+
+    while(int(cinfo->output_scanline) < first + rows)
+    {
+        JSAMPROW row = strip.scanLine(cinfo->output_scanline - first);
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+    return strip;
+}
+
+#else // HAVE_LIBJPEG
+
+struct JpegScanlineReader::State
+{
+};
+
+JpegScanlineReader::JpegScanlineReader(const QString &path) :
+    state(new State),
+    file(path),
+    ready(false)
+{
+}
+
+JpegScanlineReader::~JpegScanlineReader()
+{
+    delete state;
+}
+
+bool JpegScanlineReader::open()
+{
+    error = "Built without libjpeg";
+    return false;
+}
+
+QImage JpegScanlineReader::read(int)
+{
+    return QImage();
+}
+
+#endif // HAVE_LIBJPEG
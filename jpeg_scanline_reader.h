@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The JpegScanlineReader class, which decodes a JPEG from top
+//to bottom a few rows at a time through libjpeg. A photo too large to hold
+//in memory can then be processed in strips while it is decoded only once.
+//QImageReader cannot do that: a clip rectangle decodes every row above it
+//again, and most formats decode the whole image for any clip.
+//
+//Requires libjpeg; without HAVE_LIBJPEG open() always fails.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef JPEG_SCANLINE_READER_H
+#define JPEG_SCANLINE_READER_H
+
+#include <QFile>
+#include <QImage>
+#include <QString>
+
+class JpegScanlineReader
+{
+public:
+    explicit JpegScanlineReader(const QString &path);
+    ~JpegScanlineReader();
+
+    //Reads the header and gets ready to decode. Returns false if the file is
+    //not a JPEG in a color space libjpeg can turn into RGB or gray.
+    bool open();
+
+    //Size of the decoded image, once open() succeeded
+    QSize size() const { return image_size; }
+
+    //Decodes the next rows, or as many as are left. Returns a null image at
+    //the end of the image or on error.
+    QImage read(int rows);
+
+    QString error_string() const { return error; }
+
+private:
+    JpegScanlineReader(const JpegScanlineReader &);
+    JpegScanlineReader &operator=(const JpegScanlineReader &);
+
+    struct State; //libjpeg's, kept out of this header
+    State *state;
+    QFile file;
+    QSize image_size;
+    bool ready;
+    QString error;
+};
+
+#endif // JPEG_SCANLINE_READER_H
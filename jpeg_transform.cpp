@@ -0,0 +1,533 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the JpegTransform class declared in
+//jpeg_transform.h. The source file is memory mapped and handed to libjpeg,
+//which reads the coefficient blocks into virtual arrays. Each destination
+//block is then filled from one source block:
+//
+//  Crop       dst(x, y) = src(x + dx, y + dy)                   unchanged
+//  Rotate180  dst(x, y) = src(W-1-x, H-1-y)           coef[v][u] * (-1)^(u+v)
+//  Rotate90   dst(x, y) = src(y, H-1-x)       coef[v][u] = src[u][v] * (-1)^u
+//  Rotate270  dst(x, y) = src(W-1-y, x)       coef[v][u] = src[u][v] * (-1)^v
+//
+//where W and H are the source width and height in blocks, u and v are the
+//horizontal and vertical frequency of a coefficient, and a mirror negates
+//the odd frequencies along its axis. libjpeg reports errors by calling
+//error_exit(), which jumps back out of the transform with longjmp.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "jpeg_transform.h"
+#include "trace.h"
+#include <QFile>
+
+bool JpegTransform::is_jpeg(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QFile::ReadOnly))
+        return false;
+
+    QByteArray magic = file.read(3);
+    return magic == QByteArray("\xFF\xD8\xFF", 3);
+}
+
+#ifdef HAVE_LIBJPEG
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <jpeglib.h>
+
+namespace
+{
+enum Operation { Crop, Rotate90, Rotate180, Rotate270 };
+
+struct ErrorManager
+{
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void error_exit(j_common_ptr cinfo)
+{
+    ErrorManager *err = reinterpret_cast<ErrorManager *>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    longjmp(err->jump, 1);
+}
+
+//Warnings (e.g. corrupt data that libjpeg can recover from) are ignored
+void output_message(j_common_ptr)
+{
+}
+
+struct HeaderInfo
+{
+    int width;
+    int height;
+    int imcu_width;  //iMCU size in pixels
+    int imcu_height;
+};
+
+JDIMENSION div_round_up(long a, long b)
+{
+    return JDIMENSION((a + b - 1) / b);
+}
+
+JDIMENSION round_up(long a, long b)
+{
+    return JDIMENSION(div_round_up(a, b) * b);
+}
+
+//Largest sampling factors of the components. The MCU of a single
+//component image is a single block whatever its sampling factors say.
+void max_samp_factors(j_decompress_ptr src, int *max_h, int *max_v)
+{
+    *max_h = 1;
+    *max_v = 1;
+    if(src->num_components == 1)
+        return;
+
+    for(int ci = 0; ci < src->num_components; ci++)
+    {
+        *max_h = qMax(*max_h, src->comp_info[ci].h_samp_factor);
+        *max_v = qMax(*max_v, src->comp_info[ci].v_samp_factor);
+    }
+}
+
+void setup_source(j_decompress_ptr src, ErrorManager *err,
+                  const uchar *data, unsigned long size)
+{
+    src->err = jpeg_std_error(&err->pub);
+    err->pub.error_exit = error_exit;
+    err->pub.output_message = output_message;
+    jpeg_create_decompress(src);
+    jpeg_mem_src(src, const_cast<uchar *>(data), size);
+}
+
+bool read_header(const uchar *data, unsigned long size, HeaderInfo *info)
+{
+    jpeg_decompress_struct src;
+    ErrorManager err;
+
+    std::memset(&src, 0, sizeof(src));
+    if(setjmp(err.jump))
+    {
+        jpeg_destroy_decompress(&src);
+        return false;
+    }
+
+    setup_source(&src, &err, data, size);
+    jpeg_read_header(&src, TRUE);
+
+    int max_h, max_v;
+    max_samp_factors(&src, &max_h, &max_v);
+    info->width = src.image_width;
+    info->height = src.image_height;
+    info->imcu_width = max_h * DCTSIZE;
+    info->imcu_height = max_v * DCTSIZE;
+
+    jpeg_destroy_decompress(&src);
+    return true;
+}
+
+//Transposes a quantization table, needed when rows become columns
+void transpose_table(JQUANT_TBL *table)
+{
+    for(int v = 0; v < DCTSIZE; v++)
+    {
+        for(int u = 0; u < v; u++)
+        {
+            qSwap(table->quantval[v * DCTSIZE + u], table->quantval[u * DCTSIZE + v]);
+        }
+    }
+}
+
+//Fills one destination block from its source block for the operation.
+//Each case is its own loop so the compiler can unroll and vectorize it.
+void transform_block(Operation op, JCOEFPTR src, JCOEFPTR dst)
+{
+    switch(op)
+    {
+    case Crop:
+        std::memcpy(dst, src, sizeof(JBLOCK));
+        break;
+    case Rotate180:
+        for(int v = 0; v < DCTSIZE; v++)
+        {
+            for(int u = 0; u < DCTSIZE; u++)
+            {
+                JCOEF c = src[v * DCTSIZE + u];
+                dst[v * DCTSIZE + u] = ((u + v) & 1) ? JCOEF(-c) : c;
+            }
+        }
+        break;
+    case Rotate90:
+        for(int v = 0; v < DCTSIZE; v++)
+        {
+            for(int u = 0; u < DCTSIZE; u++)
+            {
+                JCOEF c = src[u * DCTSIZE + v];
+                dst[v * DCTSIZE + u] = (u & 1) ? JCOEF(-c) : c;
+            }
+        }
+        break;
+    case Rotate270:
+        for(int v = 0; v < DCTSIZE; v++)
+        {
+            for(int u = 0; u < DCTSIZE; u++)
+            {
+                JCOEF c = src[u * DCTSIZE + v];
+                dst[v * DCTSIZE + u] = (v & 1) ? JCOEF(-c) : c;
+            }
+        }
+        break;
+    }
+}
+
+//Copies the APPn and COM markers saved from the source to the destination,
+//except the JFIF and Adobe markers that libjpeg writes itself
+void copy_markers(j_decompress_ptr src, j_compress_ptr dst)
+{
+    for(jpeg_saved_marker_ptr marker = src->marker_list; marker != NULL; marker = marker->next)
+    {
+        if(dst->write_JFIF_header && marker->marker == JPEG_APP0
+           && marker->data_length >= 5 && std::memcmp(marker->data, "JFIF", 5) == 0)
+            continue;
+        if(dst->write_Adobe_marker && marker->marker == JPEG_APP0 + 14
+           && marker->data_length >= 5 && std::memcmp(marker->data, "Adobe", 5) == 0)
+            continue;
+
+        jpeg_write_marker(dst, marker->marker, marker->data, marker->data_length);
+    }
+}
+
+//Runs the transform. crop is only used for Crop and must have its corner
+//on the iMCU grid. On success *output holds a malloc'd JPEG of *output_size
+//bytes that the caller frees; on failure message holds libjpeg's error.
+bool transform(const uchar *data, unsigned long size, Operation op,
+               int crop_x, int crop_y, int crop_width, int crop_height,
+               unsigned char **output, unsigned long *output_size, char *message)
+{
+    jpeg_decompress_struct src;
+    jpeg_compress_struct dst;
+    ErrorManager err;
+    jvirt_barray_ptr dst_coefs[MAX_COMPONENTS];
+    JDIMENSION dst_width_blocks[MAX_COMPONENTS];
+    JDIMENSION dst_height_blocks[MAX_COMPONENTS];
+
+    std::memset(&src, 0, sizeof(src));
+    std::memset(&dst, 0, sizeof(dst));
+    *output = NULL;
+    *output_size = 0;
+
+    if(setjmp(err.jump))
+    {
+        jpeg_destroy_compress(&dst);
+        jpeg_destroy_decompress(&src);
+        std::free(*output);
+        *output = NULL;
+        std::strcpy(message, err.message);
+        return false;
+    }
+
+    setup_source(&src, &err, data, size);
+    for(int m = 0; m < 16; m++)
+    {
+        jpeg_save_markers(&src, JPEG_APP0 + m, 0xFFFF);
+    }
+    jpeg_save_markers(&src, JPEG_COM, 0xFFFF);
+    jpeg_read_header(&src, TRUE);
+
+    dst.err = &err.pub;
+    jpeg_create_compress(&dst);
+
+    bool transpose = (op == Rotate90 || op == Rotate270);
+    int max_h, max_v;
+    max_samp_factors(&src, &max_h, &max_v);
+
+    //Destination size in pixels
+    JDIMENSION dst_width = src.image_width;
+    JDIMENSION dst_height = src.image_height;
+    if(op == Crop)
+    {
+        dst_width = crop_width;
+        dst_height = crop_height;
+    }
+    else if(transpose)
+    {
+        qSwap(dst_width, dst_height);
+    }
+
+    //Request the destination coefficient arrays; jpeg_read_coefficients()
+    //realizes them together with the source arrays
+    for(int ci = 0; ci < src.num_components; ci++)
+    {
+        jpeg_component_info *comp = src.comp_info + ci;
+        int h_samp = (src.num_components == 1) ? 1 : comp->h_samp_factor;
+        int v_samp = (src.num_components == 1) ? 1 : comp->v_samp_factor;
+        int dst_max_h = transpose ? max_v : max_h;
+        int dst_max_v = transpose ? max_h : max_v;
+        if(transpose)
+            qSwap(h_samp, v_samp);
+
+        dst_width_blocks[ci] = div_round_up(long(dst_width) * h_samp, dst_max_h * DCTSIZE);
+        dst_height_blocks[ci] = div_round_up(long(dst_height) * v_samp, dst_max_v * DCTSIZE);
+        dst_coefs[ci] = (*src.mem->request_virt_barray)(
+                    reinterpret_cast<j_common_ptr>(&src), JPOOL_IMAGE, FALSE,
+                    round_up(dst_width_blocks[ci], h_samp),
+                    round_up(dst_height_blocks[ci], v_samp), v_samp);
+    }
+
+    jvirt_barray_ptr *src_coefs = jpeg_read_coefficients(&src);
+
+    jpeg_copy_critical_parameters(&src, &dst);
+    dst.optimize_coding = FALSE; //Standard tables: one pass instead of two
+    dst.image_width = dst_width;
+    dst.image_height = dst_height;
+    if(transpose)
+    {
+        for(int ci = 0; ci < dst.num_components; ci++)
+        {
+            jpeg_component_info *comp = dst.comp_info + ci;
+            qSwap(comp->h_samp_factor, comp->v_samp_factor);
+        }
+        for(int t = 0; t < NUM_QUANT_TBLS; t++)
+        {
+            if(dst.quant_tbl_ptrs[t] != NULL)
+                transpose_table(dst.quant_tbl_ptrs[t]);
+        }
+    }
+
+    //Rearrange the blocks of each component
+    for(int ci = 0; ci < src.num_components; ci++)
+    {
+        jpeg_component_info *comp = src.comp_info + ci;
+        int h_samp = (src.num_components == 1) ? 1 : comp->h_samp_factor;
+        int v_samp = (src.num_components == 1) ? 1 : comp->v_samp_factor;
+        JDIMENSION src_width_blocks = comp->width_in_blocks;
+        JDIMENSION src_height_blocks = comp->height_in_blocks;
+        JDIMENSION src_rows = round_up(src_height_blocks, v_samp);
+        JDIMENSION src_cols = round_up(src_width_blocks, h_samp);
+        JDIMENSION x_offset = (crop_x / (max_h * DCTSIZE)) * h_samp;
+        JDIMENSION y_offset = (crop_y / (max_v * DCTSIZE)) * v_samp;
+
+        for(JDIMENSION dy = 0; dy < dst_height_blocks[ci]; dy++)
+        {
+            JBLOCKARRAY dst_row = (*src.mem->access_virt_barray)(
+                        reinterpret_cast<j_common_ptr>(&src), dst_coefs[ci], dy, 1, TRUE);
+
+            for(JDIMENSION dx = 0; dx < dst_width_blocks[ci]; dx++)
+            {
+                JDIMENSION sx = dx, sy = dy;
+                switch(op)
+                {
+                case Crop:
+                    sx = dx + x_offset;
+                    sy = dy + y_offset;
+                    break;
+                case Rotate180:
+                    sx = src_width_blocks - 1 - dx;
+                    sy = src_height_blocks - 1 - dy;
+                    break;
+                case Rotate90:
+                    sx = dy;
+                    sy = src_height_blocks - 1 - dx;
+                    break;
+                case Rotate270:
+                    sx = src_width_blocks - 1 - dy;
+                    sy = dx;
+                    break;
+                }
+
+                //Padding blocks past the source edge are left empty
+                if(sx >= src_cols || sy >= src_rows)
+                {
+                    std::memset(dst_row[0][dx], 0, sizeof(JBLOCK));
+                    continue;
+                }
+
+                JBLOCKARRAY src_row = (*src.mem->access_virt_barray)(
+                            reinterpret_cast<j_common_ptr>(&src), src_coefs[ci], sy, 1, FALSE);
+                transform_block(op, src_row[0][sx], dst_row[0][dx]);
+            }
+        }
+    }
+
+    jpeg_mem_dest(&dst, output, output_size);
+    jpeg_write_coefficients(&dst, dst_coefs);
+    copy_markers(&src, &dst);
+    jpeg_finish_compress(&dst);
+    jpeg_destroy_compress(&dst);
+
+    jpeg_finish_decompress(&src);
+    jpeg_destroy_decompress(&src);
+    return true;
+}
+
+//Maps the file at path for the lifetime of the object
+class MappedFile
+{
+public:
+    MappedFile(const QString &path) : file(path), data(NULL)
+    {
+        if(file.open(QFile::ReadOnly) && file.size() > 0)
+            data = file.map(0, file.size());
+    }
+
+    const uchar *bytes() const { return data; }
+    unsigned long size() const { return data ? (unsigned long)file.size() : 0; }
+    QString error_string() const { return file.errorString(); }
+
+private:
+    QFile file;
+    uchar *data;
+};
+
+bool run(const QString &path, Operation op, const QRect &rect,
+         QByteArray *output, QString *error)
+{
+    MappedFile file(path);
+    if(file.bytes() == NULL)
+    {
+        if(error)
+            *error = file.error_string();
+        return false;
+    }
+
+    unsigned char *buffer = NULL;
+    unsigned long buffer_size = 0;
+    char message[JMSG_LENGTH_MAX];
+    if(!transform(file.bytes(), file.size(), op, rect.x(), rect.y(), rect.width(), rect.height(),
+                  &buffer, &buffer_size, message))
+    {
+        if(error)
+            *error = QString::fromLocal8Bit(message);
+        return false;
+    }
+
+    *output = QByteArray(reinterpret_cast<const char *>(buffer), int(buffer_size));
+    std::free(buffer);
+    return true;
+}
+
+bool header(const QString &path, HeaderInfo *info)
+{
+    MappedFile file(path);
+    return file.bytes() != NULL && read_header(file.bytes(), file.size(), info);
+}
+
+//Maps any multiple of 90 degrees onto a clockwise rotation, or Crop for none
+Operation rotation(int degrees)
+{
+    switch(((degrees % 360) + 360) % 360)
+    {
+    case 90:
+        return Rotate90;
+    case 180:
+        return Rotate180;
+    case 270:
+        return Rotate270;
+    default:
+        return Crop;
+    }
+}
+}
+
+bool JpegTransform::can_rotate(const QString &path, int degrees)
+{
+    if(degrees % 90 != 0 || rotation(degrees) == Crop || !is_jpeg(path))
+        return false;
+
+    HeaderInfo info;
+    return header(path, &info)
+           && info.width % info.imcu_width == 0
+           && info.height % info.imcu_height == 0;
+}
+
+bool JpegTransform::can_crop(const QString &path, const QRect &rect)
+{
+    HeaderInfo info;
+    if(!is_jpeg(path) || !header(path, &info))
+        return false;
+
+    return !rect.isEmpty()
+           && QRect(0, 0, info.width, info.height).contains(rect)
+           && rect.x() % info.imcu_width == 0
+           && rect.y() % info.imcu_height == 0;
+}
+
+QRect JpegTransform::align_crop(const QString &path, const QRect &rect)
+{
+    HeaderInfo info;
+    if(!is_jpeg(path) || !header(path, &info))
+        return rect;
+
+    int left = rect.x() - rect.x() % info.imcu_width;
+    int top = rect.y() - rect.y() % info.imcu_height;
+    return QRect(QPoint(left, top), rect.bottomRight());
+}
+
+bool JpegTransform::rotate(const QString &path, int degrees, QByteArray *output, QString *error)
+{
+    TRACE_SCOPE("jpeg_lossless_rotate", "encode");
+
+    Operation op = rotation(degrees);
+    if(op == Crop)
+    {
+        if(error)
+            *error = "Only multiples of 90 degrees can be rotated losslessly";
+        return false;
+    }
+    return run(path, op, QRect(), output, error);
+}
+
+bool JpegTransform::crop(const QString &path, const QRect &rect, QByteArray *output, QString *error)
+{
+    TRACE_SCOPE("jpeg_lossless_crop", "encode");
+
+    if(!can_crop(path, rect))
+    {
+        if(error)
+            *error = "The crop is not aligned to the JPEG block grid";
+        return false;
+    }
+    return run(path, Crop, rect, output, error);
+}
+
+#else // HAVE_LIBJPEG
+
+bool JpegTransform::can_rotate(const QString &, int)
+{
+    return false;
+}
+
+bool JpegTransform::can_crop(const QString &, const QRect &)
+{
+    return false;
+}
+
+QRect JpegTransform::align_crop(const QString &, const QRect &rect)
+{
+    return rect;
+}
+
+bool JpegTransform::rotate(const QString &, int, QByteArray *, QString *error)
+{
+    if(error)
+        *error = "Built without libjpeg";
+    return false;
+}
+
+bool JpegTransform::crop(const QString &, const QRect &, QByteArray *, QString *error)
+{
+    if(error)
+        *error = "Built without libjpeg";
+    return false;
+}
+
+#endif // HAVE_LIBJPEG
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The JpegTransform class, which rotates and crops JPEG files
+//without decoding them to pixels, the same way jpegtran does. libjpeg reads
+//the quantized DCT coefficient blocks, the blocks are rearranged (and for
+//rotations transposed and sign flipped) and then written back out with the
+//original quantization tables. Nothing is re-quantized, so the result has
+//no generation loss and skips the IDCT, color conversion and encode.
+//
+//The transforms are only exact on whole iMCUs (the 8 or 16 pixel square
+//blocks a JPEG is coded in):
+//  - Rotations need the image width and height to be iMCU multiples.
+//  - Crops need the top left corner on the iMCU grid; align_crop() grows a
+//    crop rectangle up and left to the nearest grid point.
+//can_rotate()/can_crop() tell callers when to fall back to the pixel path.
+//
+//Requires libjpeg; without HAVE_LIBJPEG every check returns false.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef JPEG_TRANSFORM_H
+#define JPEG_TRANSFORM_H
+
+#include <QByteArray>
+#include <QRect>
+#include <QString>
+
+class JpegTransform
+{
+public:
+    //Returns true if the file at path is a JPEG (by content, not suffix)
+    static bool is_jpeg(const QString &path);
+
+    //Returns true if path can be rotated clockwise by degrees losslessly
+    static bool can_rotate(const QString &path, int degrees);
+
+    //Returns true if rect of the image at path can be cropped losslessly
+    static bool can_crop(const QString &path, const QRect &rect);
+
+    //Returns rect grown up and left so its corner lies on the iMCU grid of
+    //the JPEG at path, or rect unchanged if path is not a readable JPEG
+    static QRect align_crop(const QString &path, const QRect &rect);
+
+    //Rotates the JPEG at path clockwise by 90, 180 or 270 degrees (negative
+    //angles count counterclockwise) and stores the new file in output
+    static bool rotate(const QString &path, int degrees, QByteArray *output, QString *error);
+
+    //Crops the JPEG at path to rect and stores the new file in output
+    static bool crop(const QString &path, const QRect &rect, QByteArray *output, QString *error);
+};
+
+#endif // JPEG_TRANSFORM_H
@@ -0,0 +1,382 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the LatencyReplay class declared in
+//latency_replay.h. Frames are caught with an application event filter: a
+//window draws a frame when it handles QEvent::UpdateRequest, so the filter
+//handles that event itself and takes the time once the frame is drawn. A
+//PhotoView painted outside of such a frame, by a direct repaint(), counts
+//as a frame of its own.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "latency_replay.h"
+#include "photoalbum.h"
+#include "photo_view.h"
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScreen>
+#include <QSlider>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//Slider values dragged across, one per frame
+const int SliderSteps = 200;
+
+//Pixels the window grows by every frame, and how many frames it grows for
+const int ResizeStep = 4;
+const int ResizeSteps = 150;
+
+//Photos paged past in each direction, at most
+const int MaxPageSteps = 100;
+
+//Interval of input at 60 Hz, and of a held key's repeat
+const int FrameMs = 16;
+const int KeyRepeatMs = 33;
+
+//Time the last steps of a scenario get to reach the screen
+const int SettleMs = 2000;
+
+//Quiet time between scenarios, so one does not spill into the next
+const int PauseMs = 250;
+
+//The latency q of the way up sorted latencies
+qint64 percentile(const QVector<qint64> &sorted, double q)
+{
+    if(sorted.isEmpty())
+        return 0;
+    int index = int(std::ceil(q * sorted.size())) - 1;
+    return sorted[qBound(0, index, sorted.size() - 1)];
+}
+
+QString milliseconds(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 1) + " ms";
+}
+}
+
+QString LatencyReplay::Result::text() const
+{
+    QString line = QString("%1: %2 steps, p50 %3, p95 %4, p99 %5, worst %6, %7 frames dropped")
+                   .arg(name).arg(steps).arg(milliseconds(p50_us)).arg(milliseconds(p95_us))
+                   .arg(milliseconds(p99_us)).arg(milliseconds(worst_us)).arg(dropped);
+    if(unpainted > 0)
+        line += QString(", %1 never painted").arg(unpainted);
+    return line;
+}
+
+LatencyReplay::LatencyReplay(PhotoAlbum *album, QObject *parent) :
+    QObject(parent),
+    album(album),
+    current(-1),
+    next(0),
+    replaying(false),
+    unpainted(0),
+    view_painted(false),
+    in_frame(false)
+{
+    qreal rate = QGuiApplication::primaryScreen()->refreshRate();
+    frame_us = qint64(1000000 / (rate > 0 ? rate : 60));
+
+    step_timer = new QTimer(this);
+    step_timer->setSingleShot(true);
+    step_timer->setTimerType(Qt::PreciseTimer);
+    connect(step_timer, SIGNAL(timeout()), this, SLOT(next_step()));
+
+    settle_timer = new QTimer(this);
+    settle_timer->setSingleShot(true);
+    settle_timer->setInterval(SettleMs);
+    connect(settle_timer, SIGNAL(timeout()), this, SLOT(give_up()));
+}
+
+bool LatencyReplay::scenario(const QString &name, int photo_count, Scenario *result,
+                             QString *error)
+{
+    result->name = name;
+    result->steps.clear();
+
+    if(name == "slider")
+    {
+        Step open;
+        open.slot = "on_actionBrightness_triggered";
+        result->steps.append(open);
+        for(int i = 0; i < SliderSteps; i++)
+        {
+            Step step;
+            step.at_ms = qint64(i + 1) * FrameMs;
+            step.slider = i - SliderSteps / 2;
+            result->steps.append(step);
+        }
+        Step cancel;
+        cancel.at_ms = qint64(SliderSteps + 1) * FrameMs;
+        cancel.slot = "on_balance_buttons_rejected";
+        result->steps.append(cancel);
+        return true;
+    }
+
+    if(name == "resize")
+    {
+        for(int i = 0; i < ResizeSteps; i++)
+        {
+            Step step;
+            step.at_ms = qint64(i) * FrameMs;
+            step.size = QSize(800 + i * ResizeStep, 600 + i * ResizeStep * 3 / 4);
+            result->steps.append(step);
+        }
+        return true;
+    }
+
+    if(name == "page")
+    {
+        int pages = qMin(photo_count - 1, MaxPageSteps);
+        if(pages < 1)
+        {
+            *error = "The page scenario needs an album of at least two photos";
+            return false;
+        }
+        for(int i = 0; i < 2 * pages; i++)
+        {
+            Step step;
+            step.at_ms = qint64(i) * KeyRepeatMs;
+            step.slot = i < pages ? "on_actionPage_Forward_triggered"
+                                  : "on_actionPage_Backward_triggered";
+            result->steps.append(step);
+        }
+        return true;
+    }
+
+    //A file of recorded steps
+    QFile file(name);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        *error = "Unknown scenario " + name + ": " + file.errorString();
+        return false;
+    }
+    result->name = QFileInfo(name).baseName();
+    for(int line = 1; !file.atEnd(); line++)
+    {
+        QByteArray text = file.readLine().trimmed();
+        if(text.isEmpty())
+            continue;
+
+        QJsonObject object = QJsonDocument::fromJson(text).object();
+        Step step;
+        step.at_ms = qint64(object.value("at").toDouble());
+        if(object.contains("slot"))
+        {
+            step.slot = object.value("slot").toString();
+        }
+        else if(object.contains("slider"))
+        {
+            step.slider = object.value("slider").toInt();
+        }
+        else if(object.contains("resize"))
+        {
+            QJsonArray size = object.value("resize").toArray();
+            step.size = QSize(size.at(0).toInt(), size.at(1).toInt());
+        }
+        else
+        {
+            *error = QString("%1:%2: not a step").arg(name).arg(line);
+            return false;
+        }
+        result->steps.append(step);
+    }
+
+    //Steps are replayed in the order they are due
+    std::stable_sort(result->steps.begin(), result->steps.end(),
+                     [](const Step &a, const Step &b) { return a.at_ms < b.at_ms; });
+    return true;
+}
+
+void LatencyReplay::run(const QList<Scenario> &scenarios)
+{
+    this->scenarios = scenarios;
+    finished_results.clear();
+    current = -1;
+    qApp->installEventFilter(this);
+    QTimer::singleShot(PauseMs, this, SLOT(start_scenario()));
+}
+
+void LatencyReplay::start_scenario()
+{
+    current++;
+    if(current >= scenarios.size())
+    {
+        qApp->removeEventFilter(this);
+        emit finished();
+        return;
+    }
+
+    if(album->photo_count() > 0)
+        album->show_photo(0);
+
+    replaying = true;
+    next = 0;
+    pending_us.clear();
+    latencies_us.clear();
+    unpainted = 0;
+    clock.start();
+    next_step();
+}
+
+//Makes every step that is due, then waits for the next one, or for the
+//last ones to be painted
+void LatencyReplay::next_step()
+{
+    const QList<Step> &steps = scenarios[current].steps;
+    qint64 now = clock.nsecsElapsed() / 1000;
+    while(next < steps.size() && steps[next].at_ms * 1000 <= now)
+    {
+        pending_us.append(steps[next].at_ms * 1000);
+        inject(steps[next]);
+        next++;
+        now = clock.nsecsElapsed() / 1000;
+    }
+
+    if(next < steps.size())
+        step_timer->start(int((steps[next].at_ms * 1000 - now) / 1000));
+    else if(pending_us.isEmpty())
+        finish_scenario();
+    else
+        settle_timer->start();
+}
+
+void LatencyReplay::inject(const Step &step)
+{
+    if(!step.slot.isEmpty())
+    {
+        QMetaObject::invokeMethod(album, step.slot.toLatin1().constData());
+    }
+    else if(step.size.isValid())
+    {
+        album->resize(step.size);
+    }
+    else
+    {
+        QSlider *slider = album->findChild<QSlider *>("balance_slider");
+        if(slider != NULL)
+            slider->setValue(step.slider);
+    }
+}
+
+bool LatencyReplay::eventFilter(QObject *watched, QEvent *event)
+{
+    if(!replaying)
+        return false;
+
+    if(event->type() == QEvent::Paint && qobject_cast<PhotoView *>(watched) != NULL)
+    {
+        if(in_frame)
+        {
+            view_painted = true;
+        }
+        else
+        {
+            //Painted straight away, so the frame ends with this paint
+            watched->event(event);
+            frame_painted();
+            return true;
+        }
+    }
+    else if(event->type() == QEvent::UpdateRequest && watched->isWidgetType()
+            && static_cast<QWidget *>(watched)->isWindow() && !in_frame)
+    {
+        in_frame = true;
+        view_painted = false;
+        watched->event(event);
+        in_frame = false;
+        if(view_painted)
+            frame_painted();
+        return true;
+    }
+    return false;
+}
+
+//Every step waiting for the screen is on it now
+void LatencyReplay::frame_painted()
+{
+    if(pending_us.isEmpty())
+        return;
+
+    qint64 now = clock.nsecsElapsed() / 1000;
+    for(int i = 0; i < pending_us.size(); i++)
+    {
+        latencies_us.append(now - pending_us[i]);
+    }
+    pending_us.clear();
+
+    if(next >= scenarios[current].steps.size())
+        finish_scenario();
+}
+
+//The last steps did not reach the screen in time
+void LatencyReplay::give_up()
+{
+    qint64 now = clock.nsecsElapsed() / 1000;
+    for(int i = 0; i < pending_us.size(); i++)
+    {
+        latencies_us.append(now - pending_us[i]);
+    }
+    unpainted = pending_us.size();
+    pending_us.clear();
+    finish_scenario();
+}
+
+void LatencyReplay::finish_scenario()
+{
+    step_timer->stop();
+    settle_timer->stop();
+
+    QVector<qint64> sorted = latencies_us;
+    std::sort(sorted.begin(), sorted.end());
+
+    Result result;
+    result.name = scenarios[current].name;
+    result.steps = sorted.size();
+    result.unpainted = unpainted;
+    result.p50_us = percentile(sorted, 0.50);
+    result.p95_us = percentile(sorted, 0.95);
+    result.p99_us = percentile(sorted, 0.99);
+    result.worst_us = sorted.isEmpty() ? 0 : sorted.last();
+    for(int i = 0; i < sorted.size(); i++)
+    {
+        result.dropped += int(sorted[i] / frame_us);
+    }
+    finished_results.append(result);
+
+    //Frames drawn between scenarios are not measured
+    replaying = false;
+    QTimer::singleShot(PauseMs, this, SLOT(start_scenario()));
+}
+
+QString LatencyReplay::check(const Budget &budget) const
+{
+    QStringList failures;
+    for(int i = 0; i < finished_results.size(); i++)
+    {
+        const Result &result = finished_results[i];
+        if(budget.p95_ms >= 0 && result.p95_us > budget.p95_ms * 1000)
+            failures.append(QString("%1: p95 %2 over the budget of %3 ms")
+                            .arg(result.name).arg(milliseconds(result.p95_us)).arg(budget.p95_ms));
+        if(budget.p99_ms >= 0 && result.p99_us > budget.p99_ms * 1000)
+            failures.append(QString("%1: p99 %2 over the budget of %3 ms")
+                            .arg(result.name).arg(milliseconds(result.p99_us)).arg(budget.p99_ms));
+        if(budget.dropped >= 0 && result.dropped > budget.dropped)
+            failures.append(QString("%1: %2 frames dropped, over the budget of %3")
+                            .arg(result.name).arg(result.dropped).arg(budget.dropped));
+        if(result.unpainted > 0)
+            failures.append(QString("%1: %2 steps never painted")
+                            .arg(result.name).arg(result.unpainted));
+    }
+    return failures.join("\n");
+}
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The LatencyReplay class, which replays input against a
+//PhotoAlbum window and measures how long each input takes to reach the
+//screen, for --replay. It covers the interactive paths no timing of a
+//single function shows: dragging the balance slider, resizing the window
+//and holding Page Forward.
+//
+//A scenario is a list of steps, each due a number of milliseconds after
+//the scenario starts. The built-in scenarios are:
+//
+//  slider  opens Brightness and drags the slider across 200 values, one
+//          per 60 Hz frame, then cancels
+//  resize  grows the window by a few pixels every frame
+//  page    pages forward through the album and back again at the 30 Hz
+//          of a held key
+//
+//Any other name is read as a file of recorded steps, one JSON object per
+//line, with "at" the time in milliseconds and one of:
+//
+//  {"at":0,"slot":"on_actionBrightness_triggered"}  invokes a slot of the window
+//  {"at":16,"slider":-99}                           moves the balance slider
+//  {"at":32,"resize":[1280,800]}                    resizes the window
+//
+//Every scenario starts on the album's first photo.
+//
+//A step's latency runs from the time it was due, so time spent waiting
+//behind a slow step counts too, to the end of the first frame after it
+//that paints a PhotoView. Steps that come due before that frame share it.
+//A step that takes longer than a refresh interval of the screen drops one
+//frame for every interval it missed.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef LATENCY_REPLAY_H
+#define LATENCY_REPLAY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSize>
+#include <QVector>
+
+class PhotoAlbum;
+class QTimer;
+
+class LatencyReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Step
+    {
+        qint64 at_ms;
+        QString slot;  //Slot to invoke, if not empty
+        int slider;    //Value to move the balance slider to, if slot is empty
+        QSize size;    //Size to resize the window to, if valid
+
+        Step() : at_ms(0), slider(0) {}
+    };
+
+    struct Scenario
+    {
+        QString name;
+        QList<Step> steps;
+    };
+
+    //Latency of one scenario
+    struct Result
+    {
+        QString name;
+        int steps;
+        int unpainted;  //Steps still not on screen when the scenario gave up
+        qint64 p50_us;
+        qint64 p95_us;
+        qint64 p99_us;
+        qint64 worst_us;
+        int dropped;    //Frames missed
+
+        Result() : steps(0), unpainted(0), p50_us(0), p95_us(0), p99_us(0), worst_us(0),
+                   dropped(0) {}
+        QString text() const;
+    };
+
+    //Limits a replay fails on. Negative limits are not checked.
+    struct Budget
+    {
+        qint64 p95_ms;
+        qint64 p99_ms;
+        int dropped;
+
+        Budget() : p95_ms(-1), p99_ms(-1), dropped(-1) {}
+    };
+
+    explicit LatencyReplay(PhotoAlbum *album, QObject *parent = 0);
+
+    //Makes the scenario called name, a built-in one or a file of recorded
+    //steps, for an album of photo_count photos. Returns false and sets
+    //*error if it cannot.
+    static bool scenario(const QString &name, int photo_count, Scenario *result,
+                         QString *error);
+
+    //Starts replaying scenarios one after another. finished() is emitted
+    //once the last is done.
+    void run(const QList<Scenario> &scenarios);
+
+    const QList<Result> &results() const { return finished_results; }
+
+    //Returns the text of every way the results exceed budget, or an empty
+    //string if they are within it
+    QString check(const Budget &budget) const;
+
+signals:
+    void finished();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private slots:
+    void start_scenario();
+    void next_step();
+    void give_up();
+
+private:
+    void inject(const Step &step);
+    void frame_painted();
+    void finish_scenario();
+
+    PhotoAlbum *album;
+    QList<Scenario> scenarios;
+    QList<Result> finished_results;
+    int current;                //Scenario being replayed
+    int next;                   //Its next step
+    bool replaying;             //A scenario is being replayed
+    QElapsedTimer clock;        //Started with the scenario
+    QList<qint64> pending_us;   //Times steps not yet on screen were due
+    QVector<qint64> latencies_us;
+    int unpainted;
+    bool view_painted;          //A PhotoView painted in the frame being drawn
+    bool in_frame;
+    qint64 frame_us;            //Refresh interval of the screen
+    QTimer *step_timer;
+    QTimer *settle_timer;
+};
+
+#endif // LATENCY_REPLAY_H
@@ -7,26 +7,290 @@
 //Description: The main function which simply sets up the application window
 //and begins application execution. If the user supplied a command line
 //argument, it opens that album when the application window is shown.
+//
+//Options:
+//  --trace <file>  record a trace for the whole session and write it to
+//                  <file> as Chrome trace-event JSON when the application exits
+//  --memory-budget <MB>  limit on decoded image memory before caches are
+//                  evicted and huge photos are shown as proxies (default 1024)
+//  --pixel-cache <MB>  limit on the screen sized pixels cached on disk so
+//                  photos show again without decoding; 0 turns it off
+//                  (default 1024)
+//  --check <album>  check the album's photos without opening a window, print
+//                  the problems found and exit with 0 if there were none, 1 if
+//                  there were and 2 if the album could not be read
+//  --repair        with --check, also write the repaired album back to <album>
+//  --serve         render photos for other programs on this machine without
+//                  opening a window, until killed. The photos of the album
+//                  argument, if any, can be asked for by position. See
+//                  render_service.h.
+//  --replay <scenarios>  replay input against the album argument in an
+//                  offscreen window and print the latency of every
+//                  scenario. <scenarios> is a comma separated list of
+//                  slider, resize, page or files of recorded steps (see
+//                  latency_replay.h). Exits with 1 if a budget below is
+//                  exceeded or a step never reaches the screen.
+//  --budget-p95 <ms>, --budget-p99 <ms>  latency budgets for --replay
+//  --budget-dropped <frames>  budget of frames dropped per scenario
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "photoalbum.h"
 #include "crop.h"
+#include "trace.h"
+#include "image_buffers.h"
+#include "image_writer.h"
+#include "album_checker.h"
+#include "album_shards.h"
+#include "pixel_cache.h"
+#include "render_service.h"
+#include "latency_replay.h"
 #include <QApplication>
+#include <QDomDocument>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QScopedPointer>
+#include <cstring>
+
+//Checks the album at album_filename without a window for --check, and
+//repairs it if asked to. Returns the exit status.
+static int check_album(const QString &album_filename, bool repair)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QFile file(album_filename);
+    QDomDocument album_xml;
+    QString error;
+    int line = 0;
+    if(!file.open(QIODevice::ReadOnly) || !album_xml.setContent(&file, &error, &line))
+    {
+        err << "Cannot read album " << album_filename;
+        if(!error.isEmpty())
+            err << ": " << error << " at line " << line;
+        err << endl;
+        return 2;
+    }
+    file.close();
+
+    //Every shard is checked along with the album
+    AlbumShards shards;
+    shards.set_album(album_filename, &album_xml);
+    shards.load_all();
+
+    AlbumChecker checker(album_xml.documentElement());
+    checker.check();
+    out << checker.report();
+
+    AlbumChecker::Summary summary = checker.summary();
+    if(repair && summary.problems() > 0)
+    {
+        int dropped = checker.repair(album_xml.documentElement());
+        shards.mark_all_dirty();
+
+        //Written to a temporary file first, so a failed write keeps the album
+        QSaveFile output(album_filename);
+        QString write_error;
+        bool saved = output.open(QIODevice::WriteOnly)
+                     && shards.save(&output, album_filename, 4, &write_error)
+                     && shards.commit(&write_error);
+        if(saved && !output.commit())
+        {
+            shards.roll_back();
+            saved = false;
+        }
+        if(!saved)
+        {
+            if(write_error.isEmpty())
+                write_error = "Cannot write album " + album_filename + ": " + output.errorString();
+            err << write_error << endl;
+            return 2;
+        }
+        shards.finish();
+        out << "Repaired album: " << summary.relinked << " photos relinked, "
+            << dropped << " removed" << endl;
+    }
+
+    return summary.problems() > 0 ? 1 : 0;
+}
+
+//Serves renders of the album at album_filename, which may be empty, for
+//--serve. Returns the exit status.
+static int serve_renders(const QString &album_filename)
+{
+    RenderService service;
+    if(!service.listen(RenderService::DefaultName, album_filename))
+    {
+        QTextStream(stderr) << "Cannot start render service: " << service.error_string() << endl;
+        return 2;
+    }
+    QTextStream(stdout) << "Serving renders at " << RenderService::DefaultName << endl;
+    return QCoreApplication::exec();
+}
+
+//Replays the comma separated scenarios against window for --replay and
+//prints their latency. Returns the exit status.
+static int replay_latency(PhotoAlbum &window, const QString &names,
+                          const LatencyReplay::Budget &budget)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QList<LatencyReplay::Scenario> scenarios;
+    QStringList list = names.split(',', QString::SkipEmptyParts);
+    for(int i = 0; i < list.size(); i++)
+    {
+        LatencyReplay::Scenario scenario;
+        QString error;
+        if(!LatencyReplay::scenario(list[i], window.photo_count(), &scenario, &error))
+        {
+            err << error << endl;
+            return 2;
+        }
+        scenarios.append(scenario);
+    }
+
+    window.resize(800, 600);
+    window.show();
+
+    LatencyReplay replay(&window);
+    QObject::connect(&replay, SIGNAL(finished()), qApp, SLOT(quit()));
+    replay.run(scenarios);
+    QCoreApplication::exec();
+
+    for(int i = 0; i < replay.results().size(); i++)
+    {
+        out << replay.results()[i].text() << endl;
+    }
+    QString failures = replay.check(budget);
+    if(failures.isEmpty())
+        return 0;
+    err << failures << endl;
+    return 1;
+}
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    //--check and --serve run without a display, so they must be known
+    //before the application object is created
+    bool headless = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::strcmp(argv[i], "--check") == 0 || std::strcmp(argv[i], "--serve") == 0)
+            headless = true;
+
+        //--replay needs widgets but no display
+        if(std::strcmp(argv[i], "--replay") == 0 && qgetenv("QT_QPA_PLATFORM").isEmpty())
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QScopedPointer<QCoreApplication> a(headless ? new QCoreApplication(argc, argv)
+                                                : new QApplication(argc, argv));
+
+    //Separate the options from the album argument
+    QString album_argument;
+    QString trace_filename;
+    QString check_filename;
+    bool repair = false;
+    bool serve = false;
+    QString replay_scenarios;
+    LatencyReplay::Budget budget;
+    QStringList args = a->arguments();
+    for(int i = 1; i < args.size(); i++)
+    {
+        if(args[i] == "--trace" && i + 1 < args.size())
+        {
+            trace_filename = args[++i];
+        }
+        else if(args[i] == "--check" && i + 1 < args.size())
+        {
+            check_filename = args[++i];
+        }
+        else if(args[i] == "--repair")
+        {
+            repair = true;
+        }
+        else if(args[i] == "--serve")
+        {
+            serve = true;
+        }
+        else if(args[i] == "--replay" && i + 1 < args.size())
+        {
+            replay_scenarios = args[++i];
+        }
+        else if(args[i] == "--budget-p95" && i + 1 < args.size())
+        {
+            budget.p95_ms = args[++i].toLongLong();
+        }
+        else if(args[i] == "--budget-p99" && i + 1 < args.size())
+        {
+            budget.p99_ms = args[++i].toLongLong();
+        }
+        else if(args[i] == "--budget-dropped" && i + 1 < args.size())
+        {
+            budget.dropped = args[++i].toInt();
+        }
+        else if(args[i] == "--pixel-cache" && i + 1 < args.size())
+        {
+            PixelCache::instance()->set_limit(args[++i].toLongLong() * 1024 * 1024);
+        }
+        else if(args[i] == "--memory-budget" && i + 1 < args.size())
+        {
+            qint64 megabytes = args[++i].toLongLong();
+            if(megabytes > 0)
+                ImageBufferManager::instance()->set_budget(megabytes * 1024 * 1024);
+        }
+        else
+        {
+            album_argument = args[i];
+        }
+    }
+
+    if(!trace_filename.isEmpty())
+    {
+        Tracer::set_thread_name("GUI");
+        Tracer::set_enabled(true);
+    }
+
+    if(headless)
+    {
+        int status = 2;
+        if(serve)
+            status = serve_renders(album_argument);
+        else if(!check_filename.isEmpty())
+            status = check_album(check_filename, repair);
+        if(!trace_filename.isEmpty())
+            Tracer::dump(trace_filename);
+        return status;
+    }
+
     PhotoAlbum w;
 
-    if(argc == 2)
+    if(!album_argument.isEmpty())
     {
-        w.album_filename = argv[1]; //Set album_filename to be passed file
+        w.album_filename = album_argument; //Set album_filename to be passed file
         QFile file(w.album_filename); //Create a file with the selected path
         //Extracts the xml into a QDomDocument object
         w.process_xml(&file, w.album_filename);
     }
 
-    w.showMaximized();
+    int status;
+    if(!replay_scenarios.isEmpty())
+    {
+        status = replay_latency(w, replay_scenarios, budget);
+    }
+    else
+    {
+        w.showMaximized();
+        status = a->exec();
+    }
+
+    //Let queued photo saves finish before exiting
+    ImageWriteQueue::instance()->wait_for_done();
+
+    //Write out everything recorded during the session
+    if(!trace_filename.isEmpty())
+    {
+        Tracer::dump(trace_filename);
+    }
 
-    return a.exec();
+    return status;
 }
@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the PhotoHash and HashCache classes
+//declared in photo_hash.h. The pHash follows the usual recipe: the 32x32
+//grayscale decode is transformed with a DCT, the 8x8 lowest frequencies
+//after the DC term are kept, and each bit says whether a coefficient is
+//above their median. Only those 64 coefficients of the DCT are computed.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "photo_hash.h"
+#include "trace.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const quint32 CacheMagic = 0x50485348; //"PHSH"
+const qint32 CacheVersion = 1;
+
+//Side of the block of DCT coefficients the pHash is taken from
+const int PhashBlock = 8;
+
+//Brightness of every pixel of a DecodeSize square image
+void grayscale(const QImage &image, float gray[PhotoHash::DecodeSize][PhotoHash::DecodeSize])
+{
+    for(int y = 0; y < PhotoHash::DecodeSize; y++)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for(int x = 0; x < PhotoHash::DecodeSize; x++)
+        {
+            gray[y][x] = float(qGray(line[x]));
+        }
+    }
+}
+
+//Cosines of the DCT-II basis for the frequencies used by the pHash
+struct CosineTable
+{
+    float values[PhashBlock + 1][PhotoHash::DecodeSize];
+
+    CosineTable()
+    {
+        const double Pi = 3.14159265358979323846;
+        for(int u = 0; u <= PhashBlock; u++)
+        {
+            for(int x = 0; x < PhotoHash::DecodeSize; x++)
+            {
+                values[u][x] = float(std::cos((2 * x + 1) * u * Pi / (2 * PhotoHash::DecodeSize)));
+            }
+        }
+    }
+};
+
+QImage as_rgb32(const QImage &image)
+{
+    return image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32
+           ? image : image.convertToFormat(QImage::Format_RGB32);
+}
+}
+
+int PhotoHash::distance(quint64 a, quint64 b)
+{
+    quint64 bits = a ^ b;
+    int count = 0;
+    while(bits)
+    {
+        bits &= bits - 1; //Clears the lowest set bit
+        count++;
+    }
+    return count;
+}
+
+//Each bit says whether a pixel is brighter than its right neighbour in a
+//9x8 reduction of the image
+quint64 PhotoHash::dhash(const QImage &image)
+{
+    QImage small = as_rgb32(image.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+
+    quint64 hash = 0;
+    for(int y = 0; y < 8; y++)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(small.constScanLine(y));
+        for(int x = 0; x < 8; x++)
+        {
+            hash <<= 1;
+            if(qGray(line[x]) > qGray(line[x + 1]))
+                hash |= 1;
+        }
+    }
+    return hash;
+}
+
+quint64 PhotoHash::phash(const QImage &image)
+{
+    static const CosineTable cosines;
+
+    QImage square = image;
+    if(square.size() != QSize(DecodeSize, DecodeSize))
+        square = image.scaled(DecodeSize, DecodeSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    square = as_rgb32(square);
+
+    float gray[DecodeSize][DecodeSize];
+    grayscale(square, gray);
+
+    //Separable DCT of the rows, then the columns, for frequencies 1-8 only
+    float rows[DecodeSize][PhashBlock];
+    for(int y = 0; y < DecodeSize; y++)
+    {
+        for(int u = 0; u < PhashBlock; u++)
+        {
+            float sum = 0;
+            for(int x = 0; x < DecodeSize; x++)
+            {
+                sum += gray[y][x] * cosines.values[u + 1][x];
+            }
+            rows[y][u] = sum;
+        }
+    }
+
+    float coefficients[PhashBlock * PhashBlock];
+    for(int v = 0; v < PhashBlock; v++)
+    {
+        for(int u = 0; u < PhashBlock; u++)
+        {
+            float sum = 0;
+            for(int y = 0; y < DecodeSize; y++)
+            {
+                sum += rows[y][u] * cosines.values[v + 1][y];
+            }
+            coefficients[v * PhashBlock + u] = sum;
+        }
+    }
+
+    float sorted[PhashBlock * PhashBlock];
+    std::copy(coefficients, coefficients + PhashBlock * PhashBlock, sorted);
+    std::nth_element(sorted, sorted + PhashBlock * PhashBlock / 2, sorted + PhashBlock * PhashBlock);
+    float median = sorted[PhashBlock * PhashBlock / 2];
+
+    quint64 hash = 0;
+    for(int i = 0; i < PhashBlock * PhashBlock; i++)
+    {
+        hash <<= 1;
+        if(coefficients[i] > median)
+            hash |= 1;
+    }
+    return hash;
+}
+
+bool PhotoHash::compute(const QString &path, Hashes *hashes)
+{
+    if(HashCache::instance()->find(path, hashes))
+        return true;
+
+    TRACE_SCOPE("photo_hash", "hash");
+
+    //Formats that support it (JPEG) decode straight to the reduced size
+    QImageReader reader(path);
+    if(reader.size().isValid())
+        reader.setScaledSize(QSize(DecodeSize, DecodeSize));
+
+    QImage image = reader.read();
+    if(image.isNull())
+        return false;
+
+    hashes->dhash = dhash(image);
+    hashes->phash = phash(image);
+    HashCache::instance()->insert(path, *hashes);
+    return true;
+}
+
+HashCache::HashCache() :
+    dirty(false)
+{
+    load();
+}
+
+HashCache *HashCache::instance()
+{
+    static HashCache cache;
+    return &cache;
+}
+
+QString HashCache::file_name() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/photo_hashes";
+}
+
+bool HashCache::find(const QString &path, PhotoHash::Hashes *hashes)
+{
+    QFileInfo info(path);
+
+    QMutexLocker lock(&mutex);
+    QHash<QString, Entry>::const_iterator it = entries.constFind(info.absoluteFilePath());
+    if(it == entries.constEnd() || it->size != info.size()
+       || it->modified != info.lastModified().toMSecsSinceEpoch())
+    {
+        return false;
+    }
+
+    *hashes = it->hashes;
+    return true;
+}
+
+bool HashCache::recorded(const QString &path, PhotoHash::Hashes *hashes, qint64 *size)
+{
+    QMutexLocker lock(&mutex);
+    QHash<QString, Entry>::const_iterator it = entries.constFind(QFileInfo(path).absoluteFilePath());
+    if(it == entries.constEnd())
+        return false;
+
+    *hashes = it->hashes;
+    *size = it->size;
+    return true;
+}
+
+void HashCache::insert(const QString &path, const PhotoHash::Hashes &hashes)
+{
+    QFileInfo info(path);
+    Entry entry = {info.size(), info.lastModified().toMSecsSinceEpoch(), hashes};
+
+    QMutexLocker lock(&mutex);
+    entries.insert(info.absoluteFilePath(), entry);
+    dirty = true;
+}
+
+void HashCache::remove(const QString &path)
+{
+    QMutexLocker lock(&mutex);
+    if(entries.remove(QFileInfo(path).absoluteFilePath()) > 0)
+        dirty = true;
+}
+
+void HashCache::load()
+{
+    QFile file(file_name());
+    if(!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 version;
+    quint32 count;
+    in >> magic >> version >> count;
+    if(magic != CacheMagic || version != CacheVersion)
+        return;
+
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        QString path;
+        Entry entry;
+        in >> path >> entry.size >> entry.modified >> entry.hashes.dhash >> entry.hashes.phash;
+        entries.insert(path, entry);
+    }
+}
+
+bool HashCache::save()
+{
+    QMutexLocker lock(&mutex);
+    if(!dirty)
+        return true;
+
+    QDir().mkpath(QFileInfo(file_name()).path());
+    QSaveFile file(file_name());
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion << quint32(entries.size());
+    for(QHash<QString, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        out << it.key() << it->size << it->modified << it->hashes.dhash << it->hashes.phash;
+    }
+
+    if(!file.commit())
+        return false;
+
+    dirty = false;
+    return true;
+}
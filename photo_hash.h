@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The PhotoHash class, which computes perceptual hashes of
+//photos, and the HashCache class, which remembers them between runs.
+//
+//A perceptual hash is a 64 bit fingerprint that changes little when a photo
+//is resized, recompressed or slightly edited, so near duplicate photos have
+//hashes that differ in only a few bits. Two hashes are kept per photo:
+//dHash compares the brightness of neighbouring pixels, and pHash the low
+//frequencies of a DCT. Both only need a 32x32 decode, which JPEGs provide
+//without decoding the full photo.
+//
+//The cache is keyed by path and only trusted while the file's size and
+//modification time are unchanged.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PHOTO_HASH_H
+#define PHOTO_HASH_H
+
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+class PhotoHash
+{
+public:
+    struct Hashes
+    {
+        quint64 dhash;
+        quint64 phash;
+    };
+
+    //Side of the reduced size decode the hashes are computed from
+    static const int DecodeSize = 32;
+
+    //Hashes the photo at path, from the HashCache when it is current.
+    //Returns false if the file cannot be decoded.
+    static bool compute(const QString &path, Hashes *hashes);
+
+    static quint64 dhash(const QImage &image);
+    static quint64 phash(const QImage &image);
+
+    //Number of differing bits
+    static int distance(quint64 a, quint64 b);
+};
+
+class HashCache
+{
+public:
+    static HashCache *instance();
+
+    bool find(const QString &path, PhotoHash::Hashes *hashes);
+
+    //The hashes last recorded for path and the file size they were
+    //computed at, even if the file has changed or gone since. Used to
+    //recognize a moved photo.
+    bool recorded(const QString &path, PhotoHash::Hashes *hashes, qint64 *size);
+    void insert(const QString &path, const PhotoHash::Hashes &hashes);
+    void remove(const QString &path);
+
+    //Writes the cache to disk if anything was added since it was loaded
+    bool save();
+
+private:
+    HashCache();
+
+    struct Entry
+    {
+        qint64 size;
+        qint64 modified; //Milliseconds since the epoch
+        PhotoHash::Hashes hashes;
+    };
+
+    QString file_name() const;
+    void load();
+
+    QMutex mutex;
+    QHash<QString, Entry> entries;
+    bool dirty;
+};
+
+#endif // PHOTO_HASH_H
@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the PhotoImporter class declared in
+//photo_importer.h. The directory walk runs on one thread, since it is bound
+//by the file system's directory reads; the probes run on the global thread
+//pool, each writing only its own slot of the results.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "photo_importer.h"
+#include "exif_reader.h"
+#include "trace.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QtConcurrent>
+#include <algorithm>
+
+PhotoImporter::PhotoImporter(const QStringList &roots, const QSet<QString> &exclude,
+                             QObject *parent) :
+    QObject(parent),
+    roots(roots),
+    exclude(exclude),
+    skipped_count(0),
+    cancelled(false)
+{
+}
+
+PhotoImporter::~PhotoImporter()
+{
+    cancel();
+    future.waitForFinished();
+}
+
+void PhotoImporter::start()
+{
+    if(future.isRunning())
+        return;
+
+    cancelled = false;
+    future = QtConcurrent::run(this, &PhotoImporter::run);
+}
+
+void PhotoImporter::cancel()
+{
+    cancelled = true;
+}
+
+//Returns every image file under the roots, without duplicates or files
+//already in the album, sorted by path
+QStringList PhotoImporter::find_files() const
+{
+    TRACE_SCOPE("find_import_files", "load");
+
+    QStringList filters;
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for(int i = 0; i < formats.size(); i++)
+    {
+        filters.append("*." + QString::fromLatin1(formats[i]));
+    }
+
+    QSet<QString> seen = exclude;
+    QStringList files;
+    for(int i = 0; i < roots.size() && !cancelled; i++)
+    {
+        QFileInfo root(roots[i]);
+        if(!root.isDir())
+        {
+            QString path = root.absoluteFilePath();
+            if(root.isFile() && !seen.contains(path))
+            {
+                seen.insert(path);
+                files.append(path);
+            }
+            continue;
+        }
+
+        QDirIterator it(root.absoluteFilePath(), filters,
+                        QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while(it.hasNext() && !cancelled)
+        {
+            QString path = it.next();
+            if(!seen.contains(path))
+            {
+                seen.insert(path);
+                files.append(path);
+            }
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+//Runs on a worker thread
+void PhotoImporter::run()
+{
+    TRACE_SCOPE("import_photos", "load");
+
+    result.clear();
+    skipped_count = 0;
+
+    QStringList files = find_files();
+    int count = files.size();
+    emit progress(0, count);
+
+    QVector<Record> records(count);
+    QVector<char> readable(count, 0);
+    QVector<int> indices(count);
+    for(int i = 0; i < count; i++)
+    {
+        indices[i] = i;
+    }
+
+    //Probe every file in parallel. Each task only writes its own elements.
+    Record *record_data = records.data();
+    char *readable_data = readable.data();
+    std::atomic<int> done(0);
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        if(cancelled)
+            return;
+
+        //Only the header is read; the size comes from it too
+        QImageReader reader(files[i]);
+        if(reader.canRead())
+        {
+            Record &record = record_data[i];
+            record.path = files[i];
+            record.format = reader.format();
+            record.size = reader.size();
+
+            ExifReader::Data exif = ExifReader::read(files[i]);
+            record.date = exif.date_text();
+            record.location = exif.location_text();
+            readable_data[i] = 1;
+        }
+
+        int finished_count = ++done;
+        if(finished_count % 64 == 0 || finished_count == count)
+            emit progress(finished_count, count);
+    });
+
+    if(cancelled)
+    {
+        emit finished();
+        return;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        if(readable[i])
+            result.append(records[i]);
+        else
+            skipped_count++;
+    }
+    emit finished();
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The PhotoImporter class, which gathers the photos for a bulk
+//import on a background thread. Directories are searched recursively for
+//files with an image suffix Qt can read, and every file found is probed in
+//parallel: QImageReader reads only the header for the format and size, and
+//ExifReader the capture date and position. No pixels are decoded, so the
+//photos of a whole shoot are ready to be added to the album in one step.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PHOTO_IMPORTER_H
+#define PHOTO_IMPORTER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QSet>
+#include <QSize>
+#include <QStringList>
+#include <atomic>
+
+class PhotoImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    //What the probe found out about one photo
+    struct Record
+    {
+        QString path;
+        QByteArray format;
+        QSize size;
+        QString date;     //From the EXIF, formatted for <date>
+        QString location; //From the EXIF, formatted for <location>
+    };
+
+    //roots are files and directories to import. Files already in the album
+    //(exclude) are left out.
+    PhotoImporter(const QStringList &roots, const QSet<QString> &exclude, QObject *parent = 0);
+    ~PhotoImporter();
+
+    //Starts the import in the background. finished() is emitted when it is
+    //done or cancelled; a cancelled import has no records.
+    void start();
+    void cancel();
+    bool is_cancelled() const { return cancelled.load(); }
+
+    //The readable photos found, sorted by path
+    const QList<Record> &records() const { return result; }
+
+    //Files with an image suffix that could not be read
+    int skipped() const { return skipped_count; }
+
+signals:
+    void progress(int done, int total);
+    void finished();
+
+private:
+    void run();
+    QStringList find_files() const;
+
+    QStringList roots;
+    QSet<QString> exclude;
+    QList<Record> result;
+    int skipped_count;
+    std::atomic<bool> cancelled;
+    QFuture<void> future;
+};
+
+#endif // PHOTO_IMPORTER_H
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the PhotoView class declared in
+//photo_view.h. The photo is scaled and turned in a single drawImage() from
+//the stored pixels, so no copy of the full size photo is ever made. A photo
+//more than twice the view's size is first area averaged down to it, since
+//drawImage() samples bilinearly and would alias.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "photo_view.h"
+#include "exif_reader.h"
+#include "trace.h"
+#include "image_buffers.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QtMath>
+
+PhotoView::PhotoView(QWidget *parent) :
+    QWidget(parent),
+    orientation(1),
+    scaled_key(0),
+    backing_ratio(1),
+    backing_stale(true)
+{
+    //Every pixel is painted, so Qt need not clear the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+}
+
+void PhotoView::set_image(const QImage &image, int orientation, const QSize &box)
+{
+    QSize upright = ExifReader::upright_size(image.size(), orientation);
+    QSize fitted = upright.scaled(box, Qt::KeepAspectRatio);
+
+    //The same pixels at the same size, e.g. the photo shown again, keep the
+    //backing image. cacheKey() changes whenever the pixels do.
+    if(image.cacheKey() == source.cacheKey() && orientation == this->orientation &&
+       fitted == size())
+        return;
+
+    source = image;
+    this->orientation = orientation;
+    backing_stale = true;
+    resize(fitted);
+    update();
+}
+
+void PhotoView::clear()
+{
+    source = QImage();
+    scaled_source = QImage();
+    backing = QImage();
+    ImageBufferManager::instance()->release("PhotoView::" + objectName());
+    ImageBufferManager::instance()->release("PhotoView::" + objectName() + "#scaled");
+    backing_stale = true;
+    update();
+}
+
+void PhotoView::resizeEvent(QResizeEvent *)
+{
+    backing_stale = true;
+}
+
+//Draws source into backing at ratio device pixels per pixel, scaled to fill
+//the view and turned upright. The backing image is painted in device pixels,
+//so it is given no device pixel ratio of its own.
+void PhotoView::render_backing(qreal ratio)
+{
+    TRACE_SCOPE("render_photo_view", "scale");
+
+    QSize device_size(qCeil(width() * ratio), qCeil(height() * ratio));
+    if(backing.size() != device_size)
+    {
+        backing = QImage(device_size, QImage::Format_ARGB32_Premultiplied);
+        ImageBufferManager::instance()->track("PhotoView::" + objectName(), backing);
+    }
+    backing_ratio = ratio;
+    backing_stale = false;
+
+    if(device_size.isEmpty())
+        return;
+    if(source.isNull())
+    {
+        backing.fill(palette().window().color());
+        return;
+    }
+
+    //Scaling down by more than half is done by area averaging first. The
+    //result is kept for drawing the same photo at the same size again.
+    const QImage *pixels = &source;
+    QSize stored_size = ExifReader::swaps_dimensions(orientation) ? device_size.transposed()
+                                                                  : device_size;
+    QString scaled_owner = "PhotoView::" + objectName() + "#scaled";
+    if(stored_size.width() * 2 < source.width() || stored_size.height() * 2 < source.height())
+    {
+        if(scaled_source.size() != stored_size || scaled_key != source.cacheKey())
+        {
+            TRACE_SCOPE("prescale_photo_view", "scale");
+            scaled_source = source.scaled(stored_size, Qt::IgnoreAspectRatio,
+                                          Qt::SmoothTransformation);
+            scaled_key = source.cacheKey();
+            ImageBufferManager::instance()->track(scaled_owner, scaled_source);
+        }
+        pixels = &scaled_source;
+    }
+    else if(!scaled_source.isNull())
+    {
+        scaled_source = QImage();
+        ImageBufferManager::instance()->release(scaled_owner);
+    }
+
+    //Turn the stored pixels upright around the origin, move them back to
+    //the origin and scale them to the view
+    QTransform turn = ExifReader::transform(orientation);
+    QRectF turned = turn.mapRect(QRectF(pixels->rect()));
+    QTransform transform = turn *
+                           QTransform::fromTranslate(-turned.left(), -turned.top()) *
+                           QTransform::fromScale(device_size.width() / turned.width(),
+                                                 device_size.height() / turned.height());
+
+    //Photos with transparency are shown over the window's background
+    backing.fill(palette().window().color());
+    QPainter painter(&backing);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.setTransform(transform);
+    painter.drawImage(0, 0, *pixels);
+}
+
+void PhotoView::paintEvent(QPaintEvent *event)
+{
+    qreal ratio = devicePixelRatioF();
+    if(backing_stale || backing_ratio != ratio)
+        render_backing(ratio);
+
+    //Copy only the damaged rectangles out of the backing image
+    QPainter painter(this);
+    const QVector<QRect> rects = event->region().rects();
+    for(int i = 0; i < rects.size(); i++)
+    {
+        const QRect &rect = rects[i];
+        QRectF device_rect(rect.x() * ratio, rect.y() * ratio,
+                           rect.width() * ratio, rect.height() * ratio);
+        painter.drawImage(QRectF(rect), backing, device_rect);
+    }
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The PhotoView class, which shows a photo scaled to fit and
+//turned upright for its EXIF orientation. It replaces a QLabel showing a
+//pixmap, which needed a full size QPixmap copy of the photo, a scaled copy
+//of that, and a turned copy of the scaled one before the label scaled it
+//once more to paint it.
+//
+//PhotoView keeps a shallow copy of the QImage it is given, normally the
+//decode held by the ImageCache, and draws it through one transform into a
+//backing image at the screen's device pixel ratio. The backing image is
+//only redrawn when the photo, its orientation, the widget's size or the
+//pixel ratio change; painting copies just the damaged region out of it.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PHOTO_VIEW_H
+#define PHOTO_VIEW_H
+
+#include <QWidget>
+#include <QImage>
+
+class PhotoView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PhotoView(QWidget *parent = 0);
+
+    //Shows image, turned upright for orientation, and resizes the view to
+    //the largest size of the upright photo's aspect ratio that fits in box
+    void set_image(const QImage &image, int orientation, const QSize &box);
+
+    //Stops showing the photo and drops the reference to its pixels
+    void clear();
+
+    const QImage &image() const { return source; }
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    void render_backing(qreal ratio);
+
+    QImage source;   //Shares the pixels of the image shown
+    int orientation;
+    QImage scaled_source; //source area averaged down to the view, when much larger
+    qint64 scaled_key;    //cacheKey() of the source scaled_source was made from
+    QImage backing;  //source drawn at the view's size in device pixels
+    qreal backing_ratio; //Device pixels per pixel backing was drawn for
+    bool backing_stale;
+};
+
+#endif // PHOTO_VIEW_H
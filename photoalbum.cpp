@@ -16,6 +16,24 @@
 #include "photoalbum.h"
 #include "ui_photoalbum.h"
 #include "crop.h"
+#include "trace.h"
+#include "image_buffers.h"
+#include "image_cache.h"
+#include "image_writer.h"
+#include "tile_viewer.h"
+#include "album_commands.h"
+#include "duplicates_dialog.h"
+#include "tile_pyramid.h"
+#include "photo_hash.h"
+#include "pixel_cache.h"
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QInputDialog>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+//Number of steps kept in the undo history
+static const int UndoLimit = 100;
 
 //Constructor - initial set up of the application window
 PhotoAlbum::PhotoAlbum(QWidget *parent) :
@@ -24,10 +42,8 @@ PhotoAlbum::PhotoAlbum(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    //Configure image, date, location, and description labels and hide
-    //them from view, since there will be no information to display initially.
-    ui->image->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-    ui->image->setScaledContents(true);
+    //Hide the image view and the date, location, and description labels,
+    //since there will be no information to display initially.
     ui->image->hide();
     ui->date->hide();
     ui->location->hide();
@@ -38,9 +54,80 @@ PhotoAlbum::PhotoAlbum(QWidget *parent) :
     ui->edit_description->hide();
     ui->balance_widget->setParent(NULL);
     ui->balance_widget->hide();
+
+    //The balance widget shows the histogram of the preview as it changes
+    histogram_view = new HistogramWidget(ui->balance_widget);
+
+    //Sharpen also takes a radius and threshold, below the amount slider
+    unsharp_options = new QWidget(ui->balance_widget);
+    QHBoxLayout *unsharp_layout = new QHBoxLayout(unsharp_options);
+    unsharp_layout->setContentsMargins(0, 0, 0, 0);
+    unsharp_radius = new QDoubleSpinBox(unsharp_options);
+    unsharp_radius->setRange(0.5, 20.0);
+    unsharp_radius->setSingleStep(0.5);
+    unsharp_radius->setValue(1.5);
+    unsharp_threshold = new QSpinBox(unsharp_options);
+    unsharp_threshold->setRange(0, 64);
+    unsharp_threshold->setValue(3);
+    unsharp_layout->addWidget(new QLabel("Radius", unsharp_options));
+    unsharp_layout->addWidget(unsharp_radius);
+    unsharp_layout->addWidget(new QLabel("Threshold", unsharp_options));
+    unsharp_layout->addWidget(unsharp_threshold);
+    unsharp_options->hide();
+    connect(unsharp_radius, SIGNAL(valueChanged(double)), this, SLOT(unsharp_options_changed()));
+    connect(unsharp_threshold, SIGNAL(valueChanged(int)), this, SLOT(unsharp_options_changed()));
     ui->confirm_save->setParent(NULL);
     ui->confirm_save->hide();
 
+    //Show the image memory usage permanently on the right of the status bar
+    memory_label = new QLabel(this);
+    ui->statusBar->addPermanentWidget(memory_label);
+    ImageBufferManager *buffers = ImageBufferManager::instance();
+    connect(buffers, SIGNAL(usage_changed(qint64,qint64)),
+            this, SLOT(update_memory_status(qint64,qint64)));
+    update_memory_status(buffers->total_bytes(), buffers->budget());
+
+    //Report background image saves in the status bar
+    ImageWriteQueue *writer = ImageWriteQueue::instance();
+    connect(writer, SIGNAL(written(QString)), this, SLOT(image_written(QString)));
+    connect(writer, SIGNAL(failed(QString,QString)),
+            this, SLOT(image_write_failed(QString,QString)));
+
+    //Undo and redo go at the top of the Edit menu
+    undo_stack = new QUndoStack(this);
+    undo_stack->setUndoLimit(UndoLimit);
+    QAction *undo_action = undo_stack->createUndoAction(this, tr("&Undo"));
+    undo_action->setShortcuts(QKeySequence::Undo);
+    QAction *redo_action = undo_stack->createRedoAction(this, tr("&Redo"));
+    redo_action->setShortcuts(QKeySequence::Redo);
+    QAction *first_edit_action = ui->menuEdit->actions().value(0);
+    ui->menuEdit->insertAction(first_edit_action, undo_action);
+    ui->menuEdit->insertAction(first_edit_action, redo_action);
+    ui->menuEdit->insertSeparator(first_edit_action);
+    connect(undo_stack, SIGNAL(indexChanged(int)), this, SLOT(update_history_memory()));
+
+    //Drop cached copies of photos that other programs change
+    watcher = new AlbumWatcher(this);
+    connect(watcher, SIGNAL(files_changed(QStringList)),
+            this, SLOT(photos_changed_on_disk(QStringList)));
+    connect(watcher, SIGNAL(album_changed()), this, SLOT(album_changed_on_disk()));
+
+    //Keep unsaved changes to the album where a crash cannot lose them
+    journal = new AlbumJournal(this);
+    connect(journal, SIGNAL(failed(QString,QString)), this, SLOT(journal_failed(QString,QString)));
+
+    //Shards are read in the middle of album edits, so what reading one
+    //changes is handled once the edit is done
+    shards = new AlbumShards(this);
+    shards->set_album(QString(), &album_xml);
+    connect(shards, SIGNAL(loaded(QString,QStringList,bool)),
+            this, SLOT(shard_loaded(QString,QStringList,bool)), Qt::QueuedConnection);
+    connect(shards, SIGNAL(load_failed(QString,QString)),
+            this, SLOT(shard_load_failed(QString,QString)), Qt::QueuedConnection);
+
+    //Reflect tracing that was already enabled from the command line
+    ui->actionRecord_Trace->setChecked(Tracer::is_enabled());
+
     //Disable menu actions that require an open album
     album_not_open();
 }
@@ -48,6 +135,8 @@ PhotoAlbum::PhotoAlbum(QWidget *parent) :
 //Deconstructor - deletes the Ui
 PhotoAlbum::~PhotoAlbum()
 {
+    //Quitting without saving leaves nothing to recover
+    journal->close();
     delete ui;
 }
 
@@ -67,6 +156,7 @@ void PhotoAlbum::on_actionNew_triggered()
     QDomElement album_tag = blank_album.createElement("album");
     blank_album.appendChild(album_tag); //Append the album tag
     album_xml = blank_album; //Replace album_xml
+    shards->set_album(QString(), &album_xml);
 
     on_actionClose_triggered(); //Close previous album
     on_actionSave_As_triggered(); //Prompt the user to save the new album
@@ -83,14 +173,17 @@ void PhotoAlbum::on_actionNew_triggered()
 //This function saves the album to the path already stored in album_filename
 void PhotoAlbum::on_actionSave_triggered()
 {
-    //Create a file with the selected path
-    QFile file(album_filename);
-    if(!file.open(QFile::WriteOnly))
+    //Written to a temporary file first, so a shard that cannot be written
+    //keeps the album as it was
+    QSaveFile file(album_filename);
+    QString error;
+    if(!file.open(QFile::WriteOnly) || !save_xml(&file, album_filename, &error))
     {
-        qDebug() << "Error opening file.\n";
+        QMessageBox::warning(this, tr("Save Album"),
+                             error.isEmpty() ? file.errorString() : error);
+        return;
     }
-
-    save_xml(&file); //Save the file to the selected location
+    watcher->note_written(album_filename);
 
     //Display confirmation status
     QString message = "Saved album to " + album_filename;
@@ -115,7 +208,7 @@ void PhotoAlbum::on_actionSave_As_triggered()
             fileName.append(".xml");
         }
 
-        QFile file(fileName);
+        QSaveFile file(fileName);
         if (!file.open(QFile::WriteOnly | QFile::Text)) {
             QMessageBox::warning(this, tr("SAX Bookmarks"),
                                  tr("Cannot write file %1:\n%2.")
@@ -124,8 +217,16 @@ void PhotoAlbum::on_actionSave_As_triggered()
             return;
         }
 
-        save_xml(&file);
+        //Shards stay where they are, and the new album includes them from
+        //there
+        QString error;
+        if (!save_xml(&file, fileName, &error)) {
+            QMessageBox::warning(this, tr("Save Album"),
+                                 error.isEmpty() ? file.errorString() : error);
+            return;
+        }
         album_filename = fileName; //Update album to newly saved file
+        watcher->set_album(album_filename, photo_files());
 
         //Display confirmation status
         QString message = "Saved album to " + album_filename;
@@ -165,11 +266,12 @@ void PhotoAlbum::on_actionOpen_triggered()
 //Called when the user selects Page Forward
 void PhotoAlbum::on_actionPage_Forward_triggered()
 {
-    //If not already on the last photo
-    if(!current_photo.nextSiblingElement("photo").isNull())
+    //If not already on the last photo. Paging into a shard reads it.
+    QDomElement next = shards->next_photo(current_photo);
+    if(!next.isNull())
     {
         //Increment current_photo to the next photo and redisplay the UI
-        current_photo = current_photo.nextSiblingElement("photo");
+        current_photo = next;
         display_photo();
 
         //Display confirmation status
@@ -183,10 +285,11 @@ void PhotoAlbum::on_actionPage_Forward_triggered()
 void PhotoAlbum::on_actionPage_Backward_triggered()
 {
     //If not already on the first photo
-    if(!current_photo.previousSiblingElement("photo").isNull())
+    QDomElement previous = shards->previous_photo(current_photo);
+    if(!previous.isNull())
     {
         //Decrement current_photo to the previous photo and redisplay the UI
-        current_photo = current_photo.previousSiblingElement("photo");
+        current_photo = previous;
         display_photo();
 
         //Display confirmation status
@@ -204,16 +307,31 @@ void PhotoAlbum::on_actionQuit_triggered()
 //Called when the user selects Close from the menu
 void PhotoAlbum::on_actionClose_triggered()
 {
-    //Hide the information labels in the UI
-    QLabel* labels[4] = {ui->image, ui->date, ui->location, ui->description};
+    //Hide the information labels in the UI, letting go of the photo's pixels
+    QWidget* labels[4] = {ui->image, ui->date, ui->location, ui->description};
     for(int i = 0; i < 4; i++)
     {
         labels[i]->hide();
     }
+    ui->image->clear();
 
     //Disable menu actions that require an open album
     album_not_open();
 
+    //The history refers to photos of the closed album
+    undo_stack->clear();
+    if(duplicate_finder != NULL)
+        duplicate_finder->cancel();
+    if(metadata_watcher != NULL)
+        metadata_watcher->cancel();
+    if(photo_importer != NULL)
+        photo_importer->cancel();
+    if(album_checker != NULL)
+        album_checker->cancel();
+    last_snapshot = TiledImage();
+    watcher->clear();
+    journal->close();
+
     //Display confirmation status
     QString message = "Closed album " + album_filename;
     ui->statusBar->showMessage(message, 3000);
@@ -223,15 +341,13 @@ void PhotoAlbum::on_actionClose_triggered()
 void PhotoAlbum::on_actionEdit_Description_triggered()
 {
     QLineEdit* inputs[3]= {ui->date_input, ui->location_input, ui->description_input};
-    QDomNode child = current_photo.firstChild();
+    QString tags[3] = {"date", "location", "description"};
 
-    //Loop through the tags below <file> and populate the interface
-    int i = 0;
-    for(child = child.nextSibling(); !child.isNull(); child = child.nextSibling())
+    //Populate the interface from the tags below <file>. They are looked up
+    //by name, so a record missing one leaves its field empty.
+    for(int i = 0; i < 3; i++)
     {
-        QDomElement photo_information = child.toElement();
-        inputs[i]->setText(photo_information.text());
-        i++;
+        inputs[i]->setText(current_photo.firstChildElement(tags[i]).text());
     }
 
     //Show the window on top of the main application window
@@ -244,26 +360,33 @@ void PhotoAlbum::on_edit_buttons_accepted()
 {
     QLineEdit* inputs[3]= {ui->date_input, ui->location_input, ui->description_input};
     QLabel* labels[3] = {ui->date, ui->location, ui->description};
-    QDomNode child = current_photo.firstChild();
     QString tags[3] = {"date", "location", "description"};
 
     //Put the input from the fields in edit_description in current_photo
-    int i = 0;
-    for(child = child.nextSibling(); !child.isNull(); child = child.nextSibling())
+    for(int i = 0; i < 3; i++)
     {
         //Create a node for the tag
         QDomElement new_node = album_xml.createElement(tags[i]);
         //Create a text node for the information
         QDomText node_text = album_xml.createTextNode(inputs[i]->text());
         new_node.appendChild(node_text); //Put the text in the new node
-        //Replace the tag in current_photo
-        current_photo.replaceChild(new_node, child);
-        child = new_node; //Reset child, since the old child was overwritten
+        //Replace the tag in current_photo, or add it if the record lacks it
+        QDomElement child = current_photo.firstChildElement(tags[i]);
+        if(child.isNull())
+            current_photo.appendChild(new_node);
+        else
+            current_photo.replaceChild(new_node, child);
 
         //Update the UI labels with the new information
         labels[i]->setText(inputs[i]->text());
         labels[i]->adjustSize();
-        i++;
+    }
+
+    shards->mark_dirty(current_photo);
+    int index = photo_index(current_photo);
+    for(int i = 0; i < 3; i++)
+    {
+        journal->record_tag(index, tags[i], current_photo.firstChildElement(tags[i]));
     }
 
     ui->edit_description->hide();
@@ -279,93 +402,56 @@ void PhotoAlbum::on_edit_buttons_rejected()
     ui->edit_description->hide();
 }
 
-// This function moves an image ahead in the album. A copy of the
-// image is created and then appended after the next image. The
-// original image is then deleted.
+// This function moves an image ahead in the album, swapping it with the
+// next image. The move is recorded in the undo history.
 void PhotoAlbum::on_actionMove_Forward_triggered()
 {
     //If this isn't already the last photo
-    if(!current_photo.nextSiblingElement("photo").isNull())
+    int index = photo_index(current_photo);
+    if(index + 1 < photo_count())
     {
-        //Create a new photo tag
-        QDomElement new_photo = album_xml.createElement("photo");
-        QString tags[4]= {"file", "date", "location", "description"};
+        undo_stack->push(new MovePhotoCommand(this, index, index + 1));
 
-        int i = 0;
-        //Fill new photo nodes with information from current photo nodes
-        for(QDomNode child = current_photo.firstChild(); !child.isNull(); child = child.nextSibling())
-        {
-            QDomNode new_node = album_xml.createElement(tags[i]);
-            QDomText node_text = album_xml.createTextNode(child.toElement().text());
-            new_node.appendChild(node_text); //Append information in tag
-            new_photo.appendChild(new_node); //Append tag to new photo node
-            i++;
-        }
-
-        QDomNode previous_photo = current_photo; //Previous = photo to be deleted
-        current_photo = current_photo.nextSiblingElement("photo"); //Go one photo ahead
-
-        album_xml.documentElement().insertAfter(new_photo, current_photo); //Insert new after one photo ahead
-        album_xml.documentElement().removeChild(previous_photo); //Remove the original photo
-
-        //Increment current_photo to be new photo and display confirmation status
-        current_photo = current_photo.nextSiblingElement("photo");
+        //Display confirmation status
         QString message = "Moved picture forward in the album 1 spot.";
         ui->statusBar->showMessage(message, 3000);
-
-        display_photo();
-
     }
 }
 
-// This function moves an image backwards in the album. A copy of the
-// image is created and then appended before the previous image. The
-// original image is then deleted.
+// This function moves an image backwards in the album, swapping it with the
+// previous image. The move is recorded in the undo history.
 void PhotoAlbum::on_actionMove_Backward_triggered()
 {
     //If this isn't already the first photo
-    if(!current_photo.previousSiblingElement("photo").isNull())
+    int index = photo_index(current_photo);
+    if(index > 0)
     {
-        //Create a new photo tag
-        QDomElement new_photo = album_xml.createElement("photo");
-        QString tags[4]= {"file", "date", "location", "description"};
-
-        int i = 0;
-        //Fill new photo nodes with information from current photo nodes
-        for(QDomNode child = current_photo.firstChild(); !child.isNull(); child = child.nextSibling())
-        {
-            QDomNode new_node = album_xml.createElement(tags[i]);
-            QDomText node_text = album_xml.createTextNode(child.toElement().text());
-            new_node.appendChild(node_text); //Append information in tag
-            new_photo.appendChild(new_node); //Append tag to new photo node
-            i++;
-        }
-
-        QDomNode previous_photo = current_photo; //Previous = photo to be deleted
-        current_photo = current_photo.previousSiblingElement("photo"); //Go one photo back
-
-        album_xml.documentElement().insertBefore(new_photo, current_photo); //Insert new before one photo back
-        album_xml.documentElement().removeChild(previous_photo); //Remove the original photo
+        undo_stack->push(new MovePhotoCommand(this, index, index - 1));
 
-        //Increment current_photo to be new photo and display confirmation status
-        current_photo = current_photo.previousSiblingElement("photo");
+        //Display confirmation status
         QString message = "Moved picture backward in the album 1 spot.";
         ui->statusBar->showMessage(message, 3000);
-
-        display_photo();
     }
 }
 
 // This function pops up the crop window and fills it with the current image
-// that is being viewed.
+// that is being viewed. Cropping also works on photos shown as a proxy.
 void PhotoAlbum::on_actionCrop_triggered()
 {
     //Connect the crop_release signal from the Cropper to the confirm_crop slot in PhotoAlbum
-    QObject::connect(crop_window, SIGNAL(crop_release(QRect)), this, SLOT(confirm_crop(QRect)));
+    QObject::connect(crop_window, SIGNAL(crop_release(QRect)), this, SLOT(confirm_crop(QRect)),
+                     Qt::UniqueConnection);
+
+    //Crops are chosen on the image already in memory, even when that is only
+    //a proxy, but are always reported in full resolution coordinates
+    QSize full_size = current_image.size();
+    if(current_image_is_proxy)
+    {
+        QImageReader reader(current_photo.firstChild().toElement().text());
+        full_size = EditRecipe(current_photo).result_size(reader.size());
+    }
 
-    //Get path to current image
-    QString image_path = current_photo.firstChild().toElement().text();
-    crop_window->change_image(image_path); //Change image in crop window
+    crop_window->change_image(current_image, full_size, current_orientation); //Change image in crop window
     crop_window->show();
 
 }
@@ -375,6 +461,9 @@ void PhotoAlbum::on_actionCrop_triggered()
 // %resize from a slider or spinbox.
 void PhotoAlbum::on_actionResize_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
     is_resize = true;                       // set the is_resize flag so resize_image() will be called later
 
@@ -385,7 +474,7 @@ void PhotoAlbum::on_actionResize_triggered()
     ui->balance_slider->setRange(1, 500);
     ui->balance_spinbox->setRange(1, 500);
 
-    preview_image = current_image.copy();   // copy the current_image into preview_image
+    preview_image = current_image;          // share current_image until the preview is modified
     display_preview_image();                // call function to display preview_image which will call resize_image()
 }
 
@@ -394,6 +483,9 @@ void PhotoAlbum::on_actionResize_triggered()
 // degrees rotated from a slider or spinbox.
 void PhotoAlbum::on_actionRotate_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
     is_rotate = true;                       // set the is_rotate flag so rotate() will be called later
 
@@ -404,7 +496,7 @@ void PhotoAlbum::on_actionRotate_triggered()
     ui->balance_slider->setRange(-180, 180);
     ui->balance_spinbox->setRange(-180, 180);
 
-    preview_image = current_image.copy();    // copy the current_image into preview_image
+    preview_image = current_image;           // share current_image until the preview is modified
     display_preview_image();                 // call function to display preview_image which will call rotate_image()
 }
 
@@ -413,6 +505,9 @@ void PhotoAlbum::on_actionRotate_triggered()
 // contrast value from a slider or spinbox.
 void PhotoAlbum::on_actionContrast_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
     is_contrast = true;                    // set the is_contrast flag so contrast() will be called later
 
@@ -423,7 +518,7 @@ void PhotoAlbum::on_actionContrast_triggered()
     ui->balance_slider->setRange(-127, 127);
     ui->balance_spinbox->setRange(-127, 127);
 
-    preview_image = current_image.copy();      // copy the current_image into preview_image
+    preview_image = current_image;             // share current_image until the preview is modified
     display_preview_image();                   // call function to display preview_image which will call contrast_image()
 }
 
@@ -433,6 +528,9 @@ void PhotoAlbum::on_actionContrast_triggered()
 // brighten value from a slider or spinbox.
 void PhotoAlbum::on_actionBrightness_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
     is_brighten = true;                     // set the is_brighten flag so brighten() will be called later
 
@@ -442,20 +540,24 @@ void PhotoAlbum::on_actionBrightness_triggered()
     ui->balance_slider->setRange(-255, 255);
     ui->balance_spinbox->setRange(-255, 255);
 
-    preview_image = current_image.copy();      // copy the current_image into preview_image
+    preview_image = current_image;             // share current_image until the preview is modified
     display_preview_image();                   // call function to display preview_image which will call brighten_image()
 }
 
 // If the user hits accept on any image processing done in the balance_buttons widget,
-// then pop up a dialog telling the user that changes are permanent. If the user accepts or declines
-// then all the image processing flags are set back to false.
+// the operation is added to the photo's edits in the album, and the photo is shown with
+// it. The original image file is left alone. All the image processing flags are then
+// set back to false.
 void PhotoAlbum::on_balance_buttons_accepted()
 {
-    //Show dialog asking the user to confirm saving back to file
-    QString message = "Are you sure you want to overwrite the original image at " + current_photo.firstChild().toElement().text();
-    ui->confirm_label->setText(message);
-    ui->confirm_save->show();
-    ui->confirm_save->adjustSize();
+    QDomElement step = balance_step(ui->balance_slider->value());
+
+    ui->balance_widget->hide();     // hide the balance_widget
+
+    // drop the preview so its buffer is freed
+    preview_image = QImage();
+    preview_filters = FilterPipeline();
+    track_images();
 
     // set image processing flags to false
     is_brighten = false;
@@ -464,7 +566,15 @@ void PhotoAlbum::on_balance_buttons_accepted()
     is_rotate = false;
     is_smooth = false;
     is_sharpen = false;
-
+    is_auto_levels = false;
+    is_auto_contrast = false;
+    is_median = false;
+    is_bilateral = false;
+    is_blur = false;
+    unsharp_options->hide();
+
+    if(!step.isNull())
+        apply_edit(step);
 }
 
 // when the user exits or cancels the balance_widget, the widget is hidden and
@@ -473,6 +583,13 @@ void PhotoAlbum::on_balance_buttons_rejected()
 {
     ui->balance_widget->hide();     // hide the balance_widget
 
+    // drop the preview so its buffer is freed
+    preview_image = QImage();
+    preview_filters = FilterPipeline();
+    pending_rotation = 0;
+    pending_crop = QRect();
+    track_images();
+
     // set image processing flags to false
     is_brighten = false;
     is_contrast = false;
@@ -480,6 +597,12 @@ void PhotoAlbum::on_balance_buttons_rejected()
     is_rotate = false;
     is_smooth = false;
     is_sharpen = false;
+    is_auto_levels = false;
+    is_auto_contrast = false;
+    is_median = false;
+    is_bilateral = false;
+    is_blur = false;
+    unsharp_options->hide();
 }
 
 // This function is called whenever the spinbox or slider is changed in the
@@ -517,6 +640,26 @@ void PhotoAlbum::on_balance_slider_valueChanged(int value)
     {
         sharpen(value);
     }
+    else if(is_auto_levels)
+    {
+        auto_levels(value);
+    }
+    else if(is_auto_contrast)
+    {
+        auto_contrast(value);
+    }
+    else if(is_median)
+    {
+        median(value);
+    }
+    else if(is_bilateral)
+    {
+        bilateral(value);
+    }
+    else if(is_blur)
+    {
+        gaussian_blur(value);
+    }
 
     // update the preview_image since its been changed by one of the above functions
     display_preview_image();
@@ -531,15 +674,40 @@ void PhotoAlbum::on_confirm_buttons_rejected()
     ui->confirm_save->hide();
     crop_window->hide();
     ui->balance_widget->hide();
+
+    // drop the preview so its buffer is freed
+    preview_image = QImage();
+    pending_rotation = 0;
+    pending_crop = QRect();
+    track_images();
 }
 
-// When the user accepts at the confirm_save dialog, the preview image is saved
-// over the current image in the original file. The save, balance_widget, and
-// crop window are then hidden.
+// When the user accepts at the confirm_save dialog, the photo with its edits
+// (preview_image) is queued to be saved over the original file, and the
+// photo's edits are cleared, as one step of the undo history. The step is
+// undone again if the write fails, see image_write_failed(). The save,
+// balance_widget, and crop window are then hidden.
 void PhotoAlbum::on_confirm_buttons_accepted()
 {
-    //Save processed image to overwrite original file
-    preview_image.save(current_photo.firstChild().toElement().text());
+    //Clearing the edits first shows the photo as its file still is, which is
+    //the version the undo history keeps. The write queue then makes the
+    //edited pixels the cached decode, so display_photo() below does not read
+    //the file back from disk.
+    QString path = current_photo.firstChild().toElement().text();
+    QDomElement edits = current_photo.firstChildElement(EditRecipe::TagName);
+    undo_stack->beginMacro("Apply Edits");
+    undo_stack->push(new EditRecipeCommand(this, photo_index(current_photo),
+                                           edits.cloneNode().toElement(), QDomElement(),
+                                           "Apply Edits"));
+    record_photo_edit(path);
+    last_snapshot_key = preview_image.cacheKey();
+    save_preview_image(path);
+    undo_stack->endMacro();
+    preview_image = QImage();
+
+    PendingApply apply = {current_photo, edits.cloneNode().toElement(),
+                          undo_stack->command(undo_stack->index() - 1), undo_stack->index()};
+    applying.insert(path, apply);
 
     //Hide balance windows and redisplay image
     ui->confirm_save->hide();
@@ -548,50 +716,21 @@ void PhotoAlbum::on_confirm_buttons_accepted()
     display_photo();      // redisplay to update view of current image in album
 
 
-    QString message = "Processed image saved to " + current_photo.firstChild().toElement().text();
+    QString message = "Saving edited image to " + path;
     ui->statusBar->showMessage(message, 3000);
 }
 
 // This function is called when the user chooses to delete a photo form
-// the album. The function will return if no image is present. If the
-// photo isn't last in album, set next as current and delete previous.
-// If last in album, set previous as current and delete last. If
-// image is only image in album, dete and set image to null.
+// the album. The function will return if no image is present. The next
+// photo is shown afterwards, or the previous one if the last photo was
+// deleted. The deletion is recorded in the undo history.
 void PhotoAlbum::on_Delete_Photo_triggered()
 {
-    QDomNode to_be_deleted = current_photo;
-
     // don't attempt to delete if no image is present
     if( current_photo.isNull())
         return;
 
-    // if photo isn't last in album, set next photo as current, previous
-    // will be deleted
-    if( !current_photo.nextSibling().isNull() )
-    {
-        current_photo = current_photo.nextSiblingElement("photo");
-    }
-    // if photo is last in album, set previous photo as the current, last
-    // photo will be deleted
-    else if ( !current_photo.previousSibling().isNull() )
-    {
-        current_photo = current_photo.previousSiblingElement("photo");
-    }
-    // if photo is last in album, delete it and set image to null
-    else
-    {
-        current_photo.clear();
-        album_xml.documentElement().removeChild(to_be_deleted);
-        display_photo();
-
-        //Enable only menu actions for an album with no photos
-        album_no_photos();
-        return;
-    }
-
-    // delete the photo user was viewing when they selected delete option
-    album_xml.documentElement().removeChild(to_be_deleted);
-    display_photo();        // display_photo() to update user album view
+    undo_stack->push(new RemovePhotoCommand(this, photo_index(current_photo)));
 }
 
 
@@ -600,7 +739,8 @@ void PhotoAlbum::on_Delete_Photo_triggered()
 // and a QDomElement is created for the new photo. The following tags are
 // then added as new nodes to this QDomElement; file, date, location,
 // description.  The file tag is filled with the filepath saved from the
-// file dialog, and the other tags are made as blank but will be prompted
+// file dialog. The date and location are read from the photo's EXIF when it
+// has them, and the other tags are made as blank but will be prompted
 // to be filled in by the user. The new photo is appended after the photo
 // currently being viewed if album contains image(s).
 void PhotoAlbum::on_actionAdd_Photo_triggered()
@@ -624,33 +764,23 @@ void PhotoAlbum::on_actionAdd_Photo_triggered()
     new_node.appendChild(node_text);
     new_photo.appendChild(new_node);
 
-    // create date, location, description tags and set as blank
+    // create date, location, description tags, blank unless the camera
+    // recorded them
+    ExifReader::Data exif = ExifReader::read(filename);
+    QString values[4] = {filename, exif.date_text(), exif.location_text(), ""};
     int i;
     for(i = 1; i < 4; i++)
     {
         QDomNode new_node = album_xml.createElement(tags[i]);
-        QDomText node_text = album_xml.createTextNode("");
+        QDomText node_text = album_xml.createTextNode(values[i]);
         new_node.appendChild(node_text);
         new_photo.appendChild(new_node);
     }
 
-    // if no other images exist in album
-    if(album_xml.documentElement().firstChildElement("photo").isNull())
-    {
-        // add the QDomElement new_photo to the xml file
-        album_xml.documentElement().appendChild(new_photo);
-        // set current photo as the one just appended to xml file
-        current_photo = album_xml.documentElement().firstChildElement("photo");
-        enable_all_menu_actions();      // turn on menu actions since an image exists in album now
-    }
-    else
-    {
-        // insert the new_photo after the photo currently being viewed
-        album_xml.documentElement().insertAfter(new_photo, current_photo);
-        current_photo = new_photo;  // set new_photo as photo being viewed and display it
-    }
-
-    display_photo();        // display_photo() to update the user view of album
+    // insert the new_photo after the photo currently being viewed, or as the
+    // first photo of an empty album, and display it
+    int index = current_photo.isNull() ? photo_count() : photo_index(current_photo) + 1;
+    undo_stack->push(new InsertPhotoCommand(this, index, new_photo));
 
     // open up the edit description dialog so user can change date, loc, description
     on_actionEdit_Description_triggered();
@@ -681,25 +811,50 @@ void PhotoAlbum::on_actionUsage_triggered()
                 "to the xml album structure like adding/deleting a photo "
                 "or moving an image forward or backward in the album are "
                 "not saved to the xml file until you choose Save or Save As. "
-                "Changes to an image like brighten or crop will prompt you "
-                "to either confirm or cancel overwriting the original "
-                "image file.\n"));
+                "Changes to an image like brighten or crop are kept as "
+                "<edits> of its <photo> in the xml album as well; the "
+                "original image file is only overwritten if you choose "
+                "Image>Apply Edits to File. All of these changes can be "
+                "reverted with Edit>Undo.\n"));
 }
 
-// this function pops up a widget asking the user if they want to negate
-// the image and save it and negates image if say ok.
+// Adds a negate to the photo's edits, which inverts every color channel
 void PhotoAlbum::on_actionNegate_triggered()
 {
-    preview_image = current_image.copy();
-    preview_image.invertPixels();
+    apply_edit(album_xml.createElement("negate"));
+}
+
+// Writes the edits of the current photo into its file, after asking. This is
+// the only image operation that changes the file, and it can be undone like
+// the others.
+void PhotoAlbum::on_actionApply_Edits_triggered()
+{
+    EditRecipe edits(current_photo);
+    if(edits.is_empty())
+    {
+        ui->statusBar->showMessage("This photo has no edits to apply", 3000);
+        return;
+    }
+    if(!image_editable())
+        return;
+
+    preview_image = current_image;   // the photo with its edits rendered
+    track_images();
+
+    // a lone right angle rotation or crop of a JPEG can still be written losslessly
+    if(edits.size() == 1 && edits.step_name(0) == "rotate")
+        pending_rotation = int(edits.value(0, "angle"));
+    else if(edits.size() == 1 && edits.step_name(0) == "crop")
+        pending_crop = QRect(int(edits.value(0, "x")), int(edits.value(0, "y")),
+                             int(edits.value(0, "width")), int(edits.value(0, "height")));
 
     //Set the message in confirm_save and show it
-    QString message = "Do you want to negate the image and overwrite the original image at "
-                        + current_photo.firstChild().toElement().text();
+    QString message = "Do you want to write the edits into the original image at "
+                        + current_photo.firstChild().toElement().text()
+                        + "? This overwrites the original.";
     ui->confirm_label->setText(message);
     ui->confirm_save->show();
-
-    display_photo();
+    ui->confirm_save->adjustSize();
 }
 
 
@@ -708,6 +863,9 @@ void PhotoAlbum::on_actionNegate_triggered()
 // how many times an image is smoothed (0-3)
 void PhotoAlbum::on_actionSmooth_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
     is_smooth = true;                     // set the is_smooth flag so smooth() will be called later
 
@@ -717,22 +875,800 @@ void PhotoAlbum::on_actionSmooth_triggered()
     ui->balance_slider->setRange(0, 3);
     ui->balance_spinbox->setRange(0, 3);
 
-    preview_image = current_image.copy();      // copy the current_image into preview_image
+    preview_image = current_image;             // share current_image until the preview is modified
     display_preview_image();                   // call function to display preview_image which will call smooth()
 }
 
 
+// If the sharpen option from the photo editor is selected, this function is
+// called. It pops up the balance_widget for an unsharp mask: the slider sets
+// the amount in percent, and the radius and threshold are set below it.
 void PhotoAlbum::on_actionSharpen_triggered()
 {
+    if(!image_editable())
+        return;
+
     ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    unsharp_options->show();
     is_sharpen = true;                     // set the is_smooth flag so sharpen() will be called later
 
-    ui->balance_label->setText("Sharpness");
+    ui->balance_label->setText("Amount %");
     ui->balance_slider->setValue(0);
     ui->balance_spinbox->setValue(0);
-    ui->balance_slider->setRange(0, 3);
-    ui->balance_spinbox->setRange(0, 3);
+    ui->balance_slider->setRange(0, 300);
+    ui->balance_spinbox->setRange(0, 300);
 
-    preview_image = current_image.copy();      // copy the current_image into preview_image
+    preview_image = current_image;             // share current_image until the preview is modified
     display_preview_image();                   // call function to display preview_image which will call sharpen()
 }
+
+// Redoes the sharpen preview when its radius or threshold changes
+void PhotoAlbum::unsharp_options_changed()
+{
+    if(is_sharpen)
+        on_balance_slider_valueChanged(ui->balance_slider->value());
+}
+
+// If Gaussian blur is selected from the Image menu, this function is called.
+// The slider sets the blur's sigma in tenths of a pixel.
+void PhotoAlbum::on_actionGaussian_Blur_triggered()
+{
+    if(!image_editable())
+        return;
+
+    ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    is_blur = true;                         // set the is_blur flag so gaussian_blur() will be called later
+
+    ui->balance_label->setText("Sigma px/10");
+    ui->balance_slider->setValue(0);
+    ui->balance_spinbox->setValue(0);
+    ui->balance_slider->setRange(0, 500);
+    ui->balance_spinbox->setRange(0, 500);
+
+    preview_image = current_image;             // share current_image until the preview is modified
+    display_preview_image();
+}
+
+
+// If median is selected from the Image menu, this function is called. The
+// slider sets the radius of the square each pixel takes the median of,
+// which removes speckle noise without blurring edges.
+void PhotoAlbum::on_actionMedian_triggered()
+{
+    if(!image_editable())
+        return;
+
+    ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    is_median = true;                       // set the is_median flag so median() will be called later
+
+    ui->balance_label->setText("Radius");
+    ui->balance_slider->setValue(0);
+    ui->balance_spinbox->setValue(0);
+    ui->balance_slider->setRange(0, 30);
+    ui->balance_spinbox->setRange(0, 30);
+
+    preview_image = current_image;             // share current_image until the preview is modified
+    display_preview_image();
+}
+
+// If bilateral is selected from the Image menu, this function is called. The
+// slider sets the radius of the smoothing, which stops at edges.
+void PhotoAlbum::on_actionBilateral_triggered()
+{
+    if(!image_editable())
+        return;
+
+    ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    is_bilateral = true;                    // set the is_bilateral flag so bilateral() will be called later
+
+    ui->balance_label->setText("Radius");
+    ui->balance_slider->setValue(0);
+    ui->balance_spinbox->setValue(0);
+    ui->balance_slider->setRange(0, 64);
+    ui->balance_spinbox->setRange(0, 64);
+
+    preview_image = current_image;             // share current_image until the preview is modified
+    display_preview_image();
+}
+
+//Called when the user toggles Record Trace from the Tools menu
+//Turning tracing on starts a fresh recording. Turning it off asks where to
+//write the recorded spans as Chrome trace-event JSON.
+void PhotoAlbum::on_actionRecord_Trace_triggered(bool checked)
+{
+    if(checked)
+    {
+        Tracer::clear();
+        Tracer::set_enabled(true);
+        ui->statusBar->showMessage("Recording trace", 3000);
+        return;
+    }
+
+    Tracer::set_enabled(false);
+
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save Trace"),
+                                                    QDir::currentPath(),
+                                                    tr("Trace Files (*.json)"));
+    if (filename.isEmpty())
+        return;
+
+    if(!filename.endsWith(".json"))
+    {
+        filename.append(".json");
+    }
+
+    if(!Tracer::dump(filename))
+    {
+        QMessageBox::warning(this, tr("Record Trace"),
+                             tr("Cannot write trace file %1.").arg(filename));
+        return;
+    }
+
+    QString message = "Saved trace to " + filename;
+    ui->statusBar->showMessage(message, 3000);
+}
+
+// If auto levels is selected from the Balance menu, this function is called.
+// Each color channel is stretched to the full range in the preview right
+// away; the slider sets how much of each end, in tenths of a percent of the
+// pixels, may be clipped to pure black or white.
+void PhotoAlbum::on_actionAuto_Levels_triggered()
+{
+    if(!image_editable())
+        return;
+
+    ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    is_auto_levels = true;                  // set the is_auto_levels flag so auto_levels() will be called later
+
+    ui->balance_label->setText("Clip %/10");
+    ui->balance_slider->setRange(0, 50);
+    ui->balance_spinbox->setRange(0, 50);
+    ui->balance_slider->setValue(5);
+    ui->balance_spinbox->setValue(5);
+
+    auto_levels(ui->balance_slider->value());
+    display_preview_image();
+}
+
+// If auto contrast is selected from the Balance menu, this function is
+// called. Works like auto levels, but stretches all channels together so
+// the colors are kept.
+void PhotoAlbum::on_actionAuto_Contrast_triggered()
+{
+    if(!image_editable())
+        return;
+
+    ui->balance_widget->show();             // pop up slider,scrollbar, and preview image
+    is_auto_contrast = true;                // set the is_auto_contrast flag so auto_contrast() will be called later
+
+    ui->balance_label->setText("Clip %/10");
+    ui->balance_slider->setRange(0, 50);
+    ui->balance_spinbox->setRange(0, 50);
+    ui->balance_slider->setValue(5);
+    ui->balance_spinbox->setValue(5);
+
+    auto_contrast(ui->balance_slider->value());
+    display_preview_image();
+}
+
+//Opens the current photo in its own window for zooming and panning at full
+//resolution. The window deletes itself when closed.
+void PhotoAlbum::on_actionZoom_Viewer_triggered()
+{
+    QString path = current_photo.firstChild().toElement().text();
+
+    TileViewer *viewer = new TileViewer(path, EditRecipe(current_photo));
+    viewer->setAttribute(Qt::WA_DeleteOnClose);
+    viewer->show();
+}
+
+//Called when the user selects Slideshow from the Tools menu
+//Shows the album full screen from the current photo on, after asking how
+//long to show each photo and how long to crossfade
+void PhotoAlbum::on_actionSlideshow_triggered()
+{
+    bool ok;
+    double interval = QInputDialog::getDouble(this, tr("Slideshow"), tr("Seconds per photo:"),
+                                              slideshow_settings.interval_ms / 1000.0,
+                                              1, 3600, 1, &ok);
+    if(!ok)
+        return;
+    double fade = QInputDialog::getDouble(this, tr("Slideshow"),
+                                          tr("Crossfade seconds (0 for none):"),
+                                          qMin(slideshow_settings.fade_ms / 1000.0, interval),
+                                          0, interval, 1, &ok);
+    if(!ok)
+        return;
+
+    slideshow_settings.interval_ms = qRound(interval * 1000);
+    slideshow_settings.fade_ms = qRound(fade * 1000);
+
+    shards->load_all();
+    QList<EditRecipe> edits;
+    QDomElement photo = album_xml.documentElement().firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        edits.append(EditRecipe(photo));
+    }
+
+    Slideshow *slideshow = new Slideshow(photo_files(), edits, qMax(photo_index(current_photo), 0),
+                                         slideshow_settings);
+    slideshow->setAttribute(Qt::WA_DeleteOnClose);
+    connect(slideshow, SIGNAL(finished(int,QString)), this, SLOT(slideshow_finished(int,QString)));
+    slideshow->showFullScreen();
+}
+
+//Returns to the photo the slideshow ended on and reports how smoothly it ran
+void PhotoAlbum::slideshow_finished(int index, QString stats)
+{
+    if(index < photo_count())
+        show_photo(index);
+    ui->statusBar->showMessage("Slideshow: " + stats, 10000);
+}
+
+//Reports the memory held by the undo history to the ImageBufferManager.
+//Tiles shared by several steps are only counted once.
+void PhotoAlbum::update_history_memory()
+{
+    QSet<qint64> keys;
+    qint64 bytes = last_snapshot.count_unique_bytes(&keys);
+    for(int i = 0; i < undo_stack->count(); i++)
+    {
+        const EditPhotoCommand *edit = dynamic_cast<const EditPhotoCommand *>(undo_stack->command(i));
+        if(edit != NULL)
+        {
+            bytes += edit->before_image().count_unique_bytes(&keys);
+            bytes += edit->after_image().count_unique_bytes(&keys);
+        }
+    }
+    ImageBufferManager::instance()->track_bytes("PhotoAlbum::undo_history", bytes);
+}
+
+//Called when the user selects Find Duplicates from the Tools menu
+//Starts hashing every photo of the album in the background. Selecting it
+//again while a search runs cancels the search.
+void PhotoAlbum::on_actionFind_Duplicates_triggered()
+{
+    if(duplicate_finder != NULL)
+    {
+        duplicate_finder->cancel();
+        return;
+    }
+
+    shards->load_all();
+    duplicate_finder = new DuplicateFinder(photo_files(), DuplicateFinder::DefaultThreshold, this);
+    connect(duplicate_finder, SIGNAL(progress(int,int)), this, SLOT(duplicates_progress(int,int)));
+    connect(duplicate_finder, SIGNAL(finished()), this, SLOT(duplicates_found()));
+    duplicate_finder->start();
+
+    ui->actionFind_Duplicates->setText("Cancel Find Duplicates");
+    ui->statusBar->showMessage("Looking for duplicate photos...");
+}
+
+//Shows how many photos the duplicate search has hashed so far
+void PhotoAlbum::duplicates_progress(int done, int total)
+{
+    QString message = QString("Hashing photos for duplicates: %1 of %2").arg(done).arg(total);
+    ui->statusBar->showMessage(message);
+}
+
+//Called when the duplicate search is done or cancelled. Shows the clusters
+//it found in a dialog.
+void PhotoAlbum::duplicates_found()
+{
+    DuplicateFinder *finder = duplicate_finder;
+    duplicate_finder = NULL;
+    finder->deleteLater();
+    ui->actionFind_Duplicates->setText("Find Duplicates...");
+
+    if(finder->is_cancelled())
+    {
+        ui->statusBar->showMessage("Duplicate search cancelled", 3000);
+        return;
+    }
+
+    ui->statusBar->showMessage(QString("Found %1 groups of duplicate photos")
+                               .arg(finder->clusters().size()), 3000);
+
+    DuplicatesDialog *dialog = new DuplicatesDialog(finder->paths(), finder->clusters(), this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, SIGNAL(photo_selected(QString)), this, SLOT(duplicate_selected(QString)));
+    dialog->show();
+}
+
+//Shows a photo picked in the duplicates dialog
+void PhotoAlbum::duplicate_selected(QString path)
+{
+    int index = find_photo(path);
+    if(index >= 0)
+        show_photo(index);
+}
+
+//Called when the user selects Export Gallery from the File menu
+//Publishes the album as a static web gallery in a directory the user picks.
+//Exporting to the same directory again only redoes the photos that
+//changed. Selecting it again while an export runs cancels the export.
+void PhotoAlbum::on_actionExport_Gallery_triggered()
+{
+    if(gallery_exporter != NULL)
+    {
+        gallery_exporter->cancel();
+        return;
+    }
+
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Export Gallery To"),
+                                                          QDir::currentPath());
+    if(directory.isEmpty())
+        return;
+
+    shards->load_all();
+    QList<GalleryExporter::Photo> photos;
+    QDomElement photo = album_xml.documentElement().firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        GalleryExporter::Photo information;
+        information.path = photo.firstChildElement("file").text();
+        information.date = photo.firstChildElement("date").text();
+        information.location = photo.firstChildElement("location").text();
+        information.description = photo.firstChildElement("description").text();
+        information.edits = EditRecipe(photo);
+        photos.append(information);
+    }
+
+    GalleryExporter::Settings settings;
+    settings.title = album_filename.isEmpty() ? QString("Photo Album")
+                                              : QFileInfo(album_filename).completeBaseName();
+
+    gallery_exporter = new GalleryExporter(photos, directory, settings, this);
+    connect(gallery_exporter, SIGNAL(progress(int,int)), this, SLOT(gallery_progress(int,int)));
+    connect(gallery_exporter, SIGNAL(finished()), this, SLOT(gallery_exported()));
+    gallery_exporter->start();
+
+    ui->actionExport_Gallery->setText("Cancel Gallery Export");
+    ui->statusBar->showMessage("Exporting gallery to " + directory);
+}
+
+//Shows how many photos the gallery export has processed so far
+void PhotoAlbum::gallery_progress(int done, int total)
+{
+    QString message = QString("Exporting gallery: %1 of %2 photos").arg(done).arg(total);
+    ui->statusBar->showMessage(message);
+}
+
+//Called when the gallery export is done, failed or was cancelled
+void PhotoAlbum::gallery_exported()
+{
+    GalleryExporter *exporter = gallery_exporter;
+    gallery_exporter = NULL;
+    exporter->deleteLater();
+    ui->actionExport_Gallery->setText("Export Gallery...");
+
+    QStringList errors = exporter->errors();
+    if(!errors.isEmpty())
+    {
+        QMessageBox::warning(this, tr("Export Gallery"),
+                             tr("Some photos could not be exported:\n%1")
+                             .arg(QStringList(errors.mid(0, 10)).join("\n")));
+    }
+
+    QString message = QString("Exported gallery to %1 (%2 photos updated)")
+                      .arg(exporter->directory()).arg(exporter->rendered());
+    ui->statusBar->showMessage(message, 5000);
+}
+
+//Shows the image memory usage reported by the ImageBufferManager
+void PhotoAlbum::update_memory_status(qint64, qint64)
+{
+    memory_label->setText(ImageBufferManager::instance()->summary());
+}
+
+//Called by the ImageWriteQueue when a processed image is safely on disk
+void PhotoAlbum::image_written(QString path)
+{
+    applying.remove(path);
+    watcher->note_written(path);
+
+    //The screen sized pixels cached for the old file are no use any more
+    QtConcurrent::run([path]() { PixelCache::instance()->remove(path); });
+
+    QString message = "Processed image saved to " + path;
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Called by the ImageWriteQueue when a processed image could not be saved.
+//The original file is left untouched in that case, and the write queue has
+//already dropped the decode of the unsaved pixels. An Apply Edits that wrote
+//the image is undone if it is still the last step of the history, otherwise
+//the photo just gets its edits back.
+void PhotoAlbum::image_write_failed(QString path, QString error)
+{
+    QString message = "Could not save processed image to " + path + ": " + error;
+
+    //The file keeps its EXIF orientation
+    ExifReader::forget_orientation(path);
+
+    if(applying.contains(path))
+    {
+        PendingApply apply = applying.take(path);
+        QtConcurrent::run([path]() { PixelCache::instance()->remove(path); });
+        if(last_snapshot_path == path)
+            last_snapshot = TiledImage();
+
+        int index = photo_index(apply.photo);
+        if(undo_stack->index() == apply.history_index && undo_stack->index() > 0
+           && undo_stack->command(apply.history_index - 1) == apply.command)
+        {
+            //The file never changed, so there is nothing to write back
+            unwritten_path = path;
+            undo_stack->undo();
+            unwritten_path.clear();
+        }
+        else if(index >= 0 && apply.photo.firstChildElement(EditRecipe::TagName).isNull())
+            set_photo_edits(index, apply.edits);
+        else if(current_photo.firstChild().toElement().text() == path)
+            display_photo();
+
+        message += ". The photo's edits were kept.";
+    }
+
+    ui->statusBar->showMessage(message, 5000);
+}
+
+//Called when the album's journal cannot be written. Changes made since the
+//album was saved may then be lost in a crash.
+void PhotoAlbum::journal_failed(QString path, QString error)
+{
+    QString message = "Could not write the album journal " + path + ": " + error
+                      + ". Save the album to keep your changes.";
+    ui->statusBar->showMessage(message, 5000);
+}
+
+//Called by the AlbumWatcher when photos of the album were changed, replaced
+//or deleted by another program. Every cached copy of them is dropped, and
+//the photo on screen is loaded again.
+void PhotoAlbum::photos_changed_on_disk(QStringList paths)
+{
+    TRACE_SCOPE("photos_changed_on_disk", "load");
+
+    ImageWriteQueue *writer = ImageWriteQueue::instance();
+    QString shown = current_photo.firstChildElement("file").text();
+    bool reload = false;
+    QStringList dropped;
+
+    for(int i = 0; i < paths.size(); i++)
+    {
+        //Our own save of the photo is still landing
+        if(writer->is_pending(paths[i]))
+            continue;
+
+        ImageCache::instance()->remove(paths[i]);
+        //The hashes of a photo moved away are kept, so Check Album can
+        //recognize it where it went
+        if(QFileInfo::exists(paths[i]))
+            HashCache::instance()->remove(paths[i]);
+        QtConcurrent::run(&TilePyramid::remove_cached, paths[i]);
+        QString path = paths[i];
+        QtConcurrent::run([path]() { PixelCache::instance()->remove(path); });
+        if(last_snapshot_path == paths[i])
+            last_snapshot = TiledImage();
+        if(paths[i] == shown)
+            reload = true;
+        dropped.append(paths[i]);
+    }
+
+    if(dropped.isEmpty())
+        return;
+
+    if(reload)
+        display_photo();
+
+    QString message = dropped.size() == 1 ? "Photo " + dropped[0] + " changed on disk"
+                                          : QString("%1 photos changed on disk").arg(dropped.size());
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Called by the AlbumWatcher when the album file was changed by another
+//program. The open album is left as it is rather than losing any changes.
+void PhotoAlbum::album_changed_on_disk()
+{
+    QString message = "The album file was changed by another program. "
+                      "Reopen it to see the changes.";
+    ui->statusBar->showMessage(message, 5000);
+}
+
+//Called when the user selects Read Photo Metadata from the Tools menu
+//Reads the EXIF of every photo in parallel in the background and fills in
+//the dates and locations that are still empty. Selecting it again while it
+//runs cancels it.
+void PhotoAlbum::on_actionRead_Metadata_triggered()
+{
+    if(metadata_watcher != NULL)
+    {
+        metadata_watcher->cancel();
+        return;
+    }
+
+    shards->load_all();
+    metadata_photos.clear();
+    QDomElement photo = album_xml.documentElement().firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        metadata_photos.append(photo);
+    }
+
+    metadata_watcher = new QFutureWatcher<ExifReader::Data>(this);
+    connect(metadata_watcher, SIGNAL(progressValueChanged(int)), this, SLOT(metadata_progress(int)));
+    connect(metadata_watcher, SIGNAL(finished()), this, SLOT(metadata_read()));
+    metadata_watcher->setFuture(QtConcurrent::mapped(photo_files(), &ExifReader::read));
+
+    ui->actionRead_Metadata->setText("Cancel Read Photo Metadata");
+    ui->statusBar->showMessage("Reading photo metadata...");
+}
+
+//Shows how many photos the EXIF read has done so far
+void PhotoAlbum::metadata_progress(int done)
+{
+    QString message = QString("Reading photo metadata: %1 of %2")
+                      .arg(done).arg(metadata_watcher->progressMaximum());
+    ui->statusBar->showMessage(message);
+}
+
+//Called when the EXIF read is done or cancelled. Fills in the empty dates
+//and locations of the photos it was started for; photos removed from the
+//album since are updated harmlessly, since they are only kept by the undo
+//history.
+void PhotoAlbum::metadata_read()
+{
+    QFutureWatcher<ExifReader::Data> *reader = metadata_watcher;
+    metadata_watcher = NULL;
+    reader->deleteLater();
+    ui->actionRead_Metadata->setText("Read Photo Metadata");
+
+    QList<QDomElement> photos = metadata_photos;
+    metadata_photos.clear();
+
+    if(reader->isCanceled())
+    {
+        ui->statusBar->showMessage("Reading photo metadata cancelled", 3000);
+        return;
+    }
+
+    TRACE_SCOPE("fill_photo_metadata", "load");
+
+    QFuture<ExifReader::Data> results = reader->future();
+    int dates = 0;
+    int locations = 0;
+    for(int i = 0; i < photos.size() && i < results.resultCount(); i++)
+    {
+        ExifReader::Data exif = results.resultAt(i);
+        QString file = photos[i].firstChildElement("file").text();
+        bool in_album = photos[i].parentNode() == album_xml.documentElement();
+        bool filled = false;
+        if(fill_photo_tag(photos[i], "date", exif.date_text()))
+        {
+            dates++;
+            filled = true;
+            if(in_album)
+                journal->record_fill(file, "date", exif.date_text());
+        }
+        if(fill_photo_tag(photos[i], "location", exif.location_text()))
+        {
+            locations++;
+            filled = true;
+            if(in_album)
+                journal->record_fill(file, "location", exif.location_text());
+        }
+        if(filled && in_album)
+            shards->mark_dirty(photos[i]);
+    }
+
+    if(!current_photo.isNull())
+        display_photo();
+
+    QString message = QString("Filled in %1 dates and %2 locations").arg(dates).arg(locations);
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Called when the user selects Import Photos from the Edit menu
+//Adds any number of photos picked at once
+void PhotoAlbum::on_actionImport_Photos_triggered()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this,
+        tr("Import Photos"), QDir::currentPath(),
+        tr("Image Files (*.png *.jpg *.jpeg *.bmp *.ppm *.gif *.tif *.tiff)"));
+    if(!files.isEmpty())
+        import_photos(files);
+}
+
+//Called when the user selects Import Folder from the Edit menu
+//Adds every photo in a directory and the directories below it
+void PhotoAlbum::on_actionImport_Folder_triggered()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Import Folder"),
+                                                          QDir::currentPath());
+    if(!directory.isEmpty())
+        import_photos(QStringList() << directory);
+}
+
+//Starts probing the photos under roots in the background. Importing again
+//while an import runs cancels it.
+void PhotoAlbum::import_photos(const QStringList &roots)
+{
+    if(photo_importer != NULL)
+    {
+        photo_importer->cancel();
+        return;
+    }
+
+    //Photos already in a shard are not imported again
+    shards->load_all();
+    QStringList files = photo_files();
+    QSet<QString> in_album;
+    for(int i = 0; i < files.size(); i++)
+    {
+        in_album.insert(QFileInfo(files[i]).absoluteFilePath());
+    }
+
+    photo_importer = new PhotoImporter(roots, in_album, this);
+    connect(photo_importer, SIGNAL(progress(int,int)), this, SLOT(import_progress(int,int)));
+    connect(photo_importer, SIGNAL(finished()), this, SLOT(photos_imported()));
+    photo_importer->start();
+
+    ui->actionImport_Photos->setText("Cancel Import");
+    ui->actionImport_Folder->setText("Cancel Import");
+    ui->statusBar->showMessage("Looking for photos to import...");
+}
+
+//Shows how many photos the import has probed so far
+void PhotoAlbum::import_progress(int done, int total)
+{
+    QString message = QString("Importing photos: %1 of %2").arg(done).arg(total);
+    ui->statusBar->showMessage(message);
+}
+
+//Called when the import is done or cancelled. All the photos found are
+//added after the current photo as one step of the undo history, which also
+//displays the first of them.
+void PhotoAlbum::photos_imported()
+{
+    PhotoImporter *importer = photo_importer;
+    photo_importer = NULL;
+    importer->deleteLater();
+    ui->actionImport_Photos->setText("Import Photos...");
+    ui->actionImport_Folder->setText("Import Folder...");
+
+    if(importer->is_cancelled() || album_xml.documentElement().isNull())
+    {
+        ui->statusBar->showMessage("Import cancelled", 3000);
+        return;
+    }
+
+    const QList<PhotoImporter::Record> &records = importer->records();
+    if(records.isEmpty())
+    {
+        ui->statusBar->showMessage(QString("No new photos found (%1 unreadable)")
+                                   .arg(importer->skipped()), 3000);
+        return;
+    }
+
+    QList<QDomElement> photos;
+    for(int i = 0; i < records.size(); i++)
+    {
+        photos.append(create_photo(records[i].path, records[i].date, records[i].location));
+    }
+
+    int index = current_photo.isNull() ? photo_count() : photo_index(current_photo) + 1;
+    undo_stack->push(new ImportPhotosCommand(this, index, photos));
+
+    QString message = QString("Imported %1 photos").arg(records.size());
+    if(importer->skipped() > 0)
+        message += QString(" (%1 unreadable files skipped)").arg(importer->skipped());
+    ui->statusBar->showMessage(message, 5000);
+}
+
+//Called when the user selects Check Album from the Tools menu
+//Checks every photo of the album in the background for a missing or
+//unreadable file and a malformed record. Selecting it again while a check
+//runs cancels the check.
+void PhotoAlbum::on_actionCheck_Album_triggered()
+{
+    if(album_checker != NULL)
+    {
+        album_checker->cancel();
+        return;
+    }
+
+    shards->load_all();
+    album_checker = new AlbumChecker(album_xml.documentElement(), this);
+    connect(album_checker, SIGNAL(progress(int,int)), this, SLOT(check_progress(int,int)));
+    connect(album_checker, SIGNAL(finished()), this, SLOT(album_checked()));
+    album_checker->start();
+
+    ui->actionCheck_Album->setText("Cancel Check Album");
+    ui->statusBar->showMessage("Checking album...");
+}
+
+//Shows how many photos the check has done so far
+void PhotoAlbum::check_progress(int done, int total)
+{
+    QString message = QString("Checking album: %1 of %2").arg(done).arg(total);
+    ui->statusBar->showMessage(message);
+}
+
+//Called when the check is done or cancelled. Reports the problems found and
+//offers to repair them as one step of the undo history.
+void PhotoAlbum::album_checked()
+{
+    AlbumChecker *checker = album_checker;
+    album_checker = NULL;
+    checker->deleteLater();
+    ui->actionCheck_Album->setText("Check Album...");
+
+    if(checker->is_cancelled() || album_xml.documentElement().isNull())
+    {
+        ui->statusBar->showMessage("Album check cancelled", 3000);
+        return;
+    }
+
+    AlbumChecker::Summary summary = checker->summary();
+    if(summary.problems() == 0)
+    {
+        ui->statusBar->showMessage(QString("Checked %1 photos, no problems found")
+                                   .arg(summary.records), 5000);
+        return;
+    }
+    ui->statusBar->showMessage(QString("Found %1 problems in the album")
+                               .arg(summary.problems()), 5000);
+
+    //Photos added, removed or moved during the check make the results stale
+    if(!checker->matches(album_xml.documentElement()))
+    {
+        QMessageBox::information(this, tr("Check Album"), checker->report(20) +
+                                 tr("\nThe album changed during the check; check it again to repair it."));
+        return;
+    }
+
+    QMessageBox box(QMessageBox::Warning, tr("Check Album"), checker->report(20),
+                    QMessageBox::Close, this);
+    QPushButton *repair_button = box.addButton(tr("Repair"), QMessageBox::AcceptRole);
+    box.setInformativeText(tr("Repair relinks moved photos, rebuilds malformed records and "
+                              "removes photos whose file is missing. Unreadable files are "
+                              "left for you to replace."));
+    box.exec();
+    if(box.clickedButton() != repair_button)
+        return;
+
+    QDomElement before = album_xml.documentElement().cloneNode(true).toElement();
+    QDomElement after = album_xml.documentElement().cloneNode(true).toElement();
+    int dropped = checker->repair(after);
+    undo_stack->push(new RepairAlbumCommand(this, before, after));
+
+    ui->statusBar->showMessage(QString("Repaired album: %1 photos relinked, %2 removed")
+                               .arg(summary.relinked).arg(dropped), 5000);
+}
+
+//Called once a shard of the album has been read, when a photo in it was
+//first reached. A shard that no longer holds as many photos as the album
+//said moves the photos after it, so the history's positions are stale.
+void PhotoAlbum::shard_loaded(QString path, QStringList files, bool count_changed)
+{
+    for(int i = 0; i < files.size(); i++)
+    {
+        watcher->add_file(files[i]);
+    }
+    if(count_changed)
+        undo_stack->clear();
+
+    QString message = QString("Read %1 photos from %2").arg(files.size())
+                      .arg(QFileInfo(path).fileName());
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Called when a shard of the album cannot be read. Its photos are left out
+//of the album, and its file is kept as it is when the album is saved.
+void PhotoAlbum::shard_load_failed(QString path, QString error)
+{
+    undo_stack->clear();
+    QString message = "Cannot read album shard " + path + ": " + error;
+    ui->statusBar->showMessage(message, 5000);
+}
@@ -18,7 +18,25 @@
 #include <QtGui>
 #include <QDomDocument>
 #include <QDebug>
+#include <QUndoStack>
+#include <QFutureWatcher>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QSaveFile>
 #include "crop.h"
+#include "histogram_widget.h"
+#include "tiled_image.h"
+#include "duplicate_finder.h"
+#include "gallery_exporter.h"
+#include "album_watcher.h"
+#include "album_journal.h"
+#include "album_shards.h"
+#include "exif_reader.h"
+#include "photo_importer.h"
+#include "album_checker.h"
+#include "slideshow.h"
+#include "filter_pipeline.h"
+#include "edit_recipe.h"
 
 namespace Ui {
 class PhotoAlbum;
@@ -38,6 +56,11 @@ public:
     bool is_rotate = false;
     bool is_smooth = false;
     bool is_sharpen = false;
+    bool is_auto_levels = false;
+    bool is_auto_contrast = false;
+    bool is_median = false;
+    bool is_bilateral = false;
+    bool is_blur = false;
 
     void process_xml(QIODevice *device, QString filename);
     QString album_filename; //Path to the location of the album's xml file
@@ -47,6 +70,26 @@ public:
 
     ~PhotoAlbum();
 
+    //Index based album editing, used by the undoable commands in
+    //album_commands.h. Indices count <photo> elements only, including
+    //those of shards not read yet (see album_shards.h).
+    int photo_count();
+    int photo_index(const QDomElement &photo);
+    QDomElement photo_at(int index);
+    int find_photo(const QString &path); //Index of the first photo of path
+    void insert_photo(int index, const QDomElement &photo);
+    QDomElement remove_photo(int index);
+    void insert_photos(int index, const QList<QDomElement> &photos);
+    void remove_photos(int index, int count);
+    QStringList photo_files(); //Paths of every photo read, in album order
+    void replace_album(const QDomElement &album); //Replaces every photo
+    void set_photo_edits(int index, const QDomElement &edits); //Replaces <edits>
+    void show_photo(int index); //-1 shows an empty album
+
+    //Overwrite the file at path with an earlier or later version of it
+    void restore_photo(const QString &path, const TiledImage &image);
+    void restore_photo_file(const QString &path, const QByteArray &contents);
+
 public slots:
     void confirm_crop(QRect);
 
@@ -109,16 +152,127 @@ private slots:
 
     void on_actionNegate_triggered();
 
+    void on_actionApply_Edits_triggered();
+
     void on_actionSmooth_triggered();
 
     void on_actionSharpen_triggered();
 
+    void on_actionMedian_triggered();
+
+    void on_actionBilateral_triggered();
+
+    void on_actionGaussian_Blur_triggered();
+
+    void unsharp_options_changed();
+
+    void on_actionRecord_Trace_triggered(bool checked);
+
+    void on_actionZoom_Viewer_triggered();
+
+    void on_actionSlideshow_triggered();
+
+    void slideshow_finished(int index, QString stats);
+
+    void on_actionAuto_Levels_triggered();
+
+    void on_actionAuto_Contrast_triggered();
+
+    void update_memory_status(qint64 total, qint64 budget);
+
+    void image_written(QString path);
+
+    void image_write_failed(QString path, QString error);
+
+    void journal_failed(QString path, QString error);
+
+    void update_history_memory();
+
+    void on_actionFind_Duplicates_triggered();
+
+    void duplicates_progress(int done, int total);
+
+    void duplicates_found();
+
+    void duplicate_selected(QString path);
+
+    void on_actionExport_Gallery_triggered();
+
+    void gallery_progress(int done, int total);
+
+    void gallery_exported();
+
+    void photos_changed_on_disk(QStringList paths);
+
+    void album_changed_on_disk();
+
+    void on_actionRead_Metadata_triggered();
+
+    void metadata_progress(int done);
+
+    void metadata_read();
+
+    void on_actionImport_Photos_triggered();
+
+    void on_actionImport_Folder_triggered();
+
+    void import_progress(int done, int total);
+
+    void photos_imported();
+
+    void on_actionCheck_Album_triggered();
+
+    void check_progress(int done, int total);
+
+    void album_checked();
+
+    void shard_loaded(QString path, QStringList files, bool count_changed);
+
+    void shard_load_failed(QString path, QString error);
+
 private:
     Ui::PhotoAlbum *ui;
     QDomDocument album_xml; //Holds the album xml
     QDomElement current_photo; //Node for the currently displayed photo
     QImage current_image; //QImage of the current_photo
     QImage preview_image; //QImage of current_photo + pending image processing
+    bool current_image_is_proxy = false; //current_image is a reduced size proxy
+    int pending_rotation = 0; //Angle of the rotation shown in preview_image
+    QRect pending_crop; //Full resolution rectangle of the crop in preview_image
+    FilterPipeline preview_filters; //Filter previewed, rendered at the preview's
+                                    //size until it is accepted
+    QLabel *memory_label; //Permanent status bar label showing image memory use
+    HistogramWidget *histogram_view; //Live histogram of preview_image
+    QWidget *unsharp_options; //Radius and threshold of Sharpen, in balance_widget
+    QDoubleSpinBox *unsharp_radius;
+    QSpinBox *unsharp_threshold;
+    QUndoStack *undo_stack; //Album structure and photo edits, newest last
+    DuplicateFinder *duplicate_finder = NULL; //Running duplicate search, if any
+    GalleryExporter *gallery_exporter = NULL; //Running gallery export, if any
+    AlbumWatcher *watcher; //Notices changes made to the album by other programs
+    AlbumJournal *journal; //Keeps the changes made since the album was saved
+    AlbumShards *shards; //Reads and writes the album's photos kept in other files
+    QFutureWatcher<ExifReader::Data> *metadata_watcher = NULL; //Running EXIF read, if any
+    QList<QDomElement> metadata_photos; //Photos the EXIF read is for, in order
+    int current_orientation = 1; //EXIF orientation of current_image
+    PhotoImporter *photo_importer = NULL; //Running bulk import, if any
+    AlbumChecker *album_checker = NULL; //Running integrity check, if any
+    Slideshow::Settings slideshow_settings; //Last interval and crossfade chosen
+    TiledImage last_snapshot; //Tiles of the last photo saved or restored,
+    QString last_snapshot_path; //shared with the next edit's history if
+    qint64 last_snapshot_key = 0; //that photo's pixels are still this cacheKey()
+
+    //An Apply Edits whose write has not landed yet, so that a failed write
+    //can give the photo its edits back
+    struct PendingApply
+    {
+        QDomElement photo;
+        QDomElement edits; //Recipe being written into the file
+        const QUndoCommand *command; //Apply Edits step of the undo history,
+        int history_index;           //and undo_stack->index() just after it
+    };
+    QHash<QString, PendingApply> applying; //By path of the photo's file
+    QString unwritten_path; //File left as it was by the Apply Edits being undone
 
     //Helper, non-slot functions
     void contrast(int value);
@@ -133,17 +287,53 @@ private:
 
     void brighten(int value);
 
-    void save_xml(QIODevice *device);
+    bool save_xml(QSaveFile *file, const QString &path, QString *error);
 
     void display_photo();
 
     void resize_image(int value);
 
     void rotate(int value);
+    int stored_angle(int angle) const;
 
     void smooth(int value);
 
     void sharpen(int value);
+
+    void median(int value);
+
+    void bilateral(int value);
+
+    void gaussian_blur(int value);
+
+    void preview_filter(FilterOp *op);
+
+    void auto_levels(int value);
+
+    void auto_contrast(int value);
+
+    void track_images();
+
+    void save_preview_image(QString path);
+
+    bool image_editable();
+
+    QImage load_photo(const QString &path, const EditRecipe &edits, bool *is_proxy);
+
+    void cache_display_pixels(const QString &path, const QSize &box, const QImage &image,
+                              const EditRecipe &edits);
+
+    void apply_edit(const QDomElement &step);
+
+    QDomElement balance_step(int value);
+
+    void record_photo_edit(const QString &path);
+
+    void import_photos(const QStringList &roots);
+
+    QDomElement create_photo(const QString &file, const QString &date, const QString &location);
+
+    bool fill_photo_tag(QDomElement photo, const QString &tag, const QString &text);
 };
 
 #endif // PHOTOALBUM_H
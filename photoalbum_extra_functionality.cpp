@@ -16,20 +16,39 @@
 #include "photoalbum.h"
 #include "ui_photoalbum.h"
 #include "crop.h"
+#include "trace.h"
+#include "image_buffers.h"
+#include "image_cache.h"
+#include "image_writer.h"
+#include "jpeg_transform.h"
+#include "histogram.h"
+#include "album_commands.h"
+#include "exif_reader.h"
+#include "image_filters.h"
+#include "pixel_cache.h"
+#include "edit_recipe.h"
+#include <QSaveFile>
+#include <QtConcurrent>
 
 //Custom slot that is called when the user finishes cropping an image
-//Receives QRect crop_area as an argument, which is the portion of
-//that will overwrite the original image if the user so chooses
+//Receives QRect crop_area as an argument, which is the portion of the
+//photo to keep. crop_area is in full resolution coordinates of the photo
+//as shown, with its earlier edits, and is added to the photo's edits.
 void PhotoAlbum::confirm_crop(QRect crop_area)
 {
-    //Set preview image to be cropped image
-    preview_image = current_image.copy(crop_area);
+    TRACE_SCOPE("crop", "filter");
 
-    //Set the message in confirm_save and show it
-    QString message = "Do you want the cropped image to overwrite the original image at "
-                        + current_photo.firstChild().toElement().text();
-    ui->confirm_label->setText(message);
-    ui->confirm_save->show();
+    if(crop_area.isEmpty())
+        return;
+
+    crop_window->hide();
+
+    QDomElement step = album_xml.createElement("crop");
+    step.setAttribute("x", crop_area.x());
+    step.setAttribute("y", crop_area.y());
+    step.setAttribute("width", crop_area.width());
+    step.setAttribute("height", crop_area.height());
+    apply_edit(step);
 }
 
 //Called after a user opens an xml album
@@ -37,13 +56,24 @@ void PhotoAlbum::confirm_crop(QRect crop_area)
 //member QDomDocument.
 void PhotoAlbum::process_xml(QIODevice *device, QString filename)
 {
+    TRACE_SCOPE("process_xml", "load");
+
     //Parse the xml file and store it into nodes of a QDomDocument
     album_xml.setContent(device, true, NULL, NULL, NULL);
 
-    //Save a reference to the root
-    QDomElement album = album_xml.documentElement();
+    //Photos kept in shards are only read once they are reached
+    shards->set_album(filename, &album_xml);
+
+    //Make the changes a crash kept from being saved
+    int recovered = journal->open(filename, album_xml, shards);
+
+    //The history of a previous album does not apply to this one
+    undo_stack->clear();
+    last_snapshot = TiledImage();
+    watcher->set_album(filename, photo_files());
+
     //Set current_photo to the first photo in the album
-    current_photo = album.firstChildElement("photo");
+    current_photo = shards->photo_at(0);
 
     //If the ablum has no photo tags
     if(current_photo.isNull())
@@ -57,7 +87,7 @@ void PhotoAlbum::process_xml(QIODevice *device, QString filename)
     enable_all_menu_actions();
 
     //Show all the UI labels that will display current_photo's information
-    QLabel* labels[4] = {ui->image, ui->date, ui->location, ui->description};
+    QWidget* labels[4] = {ui->image, ui->date, ui->location, ui->description};
     for(int i = 0; i < 4; i++)
     {
         labels[i]->show();
@@ -65,35 +95,82 @@ void PhotoAlbum::process_xml(QIODevice *device, QString filename)
 
     //Display confirmation status
     QString message = "Loaded album " + filename;
+    if(recovered > 0)
+        message += QString(", recovering %1 unsaved changes").arg(recovered);
     ui->statusBar->showMessage(message, 3000);
 
     display_photo(); //display_photo() populates the UI labels
 }
 
-//This function saves the QDomDocument album_xml to an xml file
-void PhotoAlbum::save_xml(QIODevice *device)
+//This function saves the QDomDocument album_xml through file, which is
+//committed to path, and any of its shards that changed to their own files,
+//then starts the journal over. Returns false and sets *error if the album
+//or a shard cannot be written, leaving every file and the journal as they
+//were.
+bool PhotoAlbum::save_xml(QSaveFile *file, const QString &path, QString *error)
 {
+    TRACE_SCOPE("save_xml", "save");
+
     const int IndentSize = 4;
 
-    QTextStream out(device);
-    album_xml.save(out, IndentSize); //Save album_xml to the specified file
+    //Every file is written in full before the shards replace theirs, and
+    //the album goes last. Until it is in place the shards can be put back,
+    //by the journal if the program does not get that far.
+    if(!shards->save(file, path, IndentSize, error))
+        return false;
+    journal->record_save(shards->prepared_paths());
+    if(!shards->commit(error))
+        return false;
+    if(!file->commit())
+    {
+        shards->roll_back();
+        return false;
+    }
+    shards->finish();
+
+    //The saved album holds every change the journal did
+    journal->restart(path);
+    return true;
 }
 
 //This function takes the information stored in the current_photo node
 //and displays it in the approriate UI labels at the approriate window size.
 void PhotoAlbum::display_photo()
 {
-    QLabel* labels[4] = {ui->image, ui->date, ui->location, ui->description};
-
-    //child will iterate through the tags in current_photo
-    QDomNode child = current_photo.firstChild();
-    QDomElement photo_information = child.toElement();
-
-    //Create a pixmap from the image at the path in the <file> tag
-    QImage image_pixmap(photo_information.text());
-    image_pixmap.convertToFormat(QImage::Format_RGB888);
+    TRACE_SCOPE("display_photo", "load");
+
+    QWidget* labels[4] = {ui->image, ui->date, ui->location, ui->description};
+
+    QDomElement photo_information = current_photo.firstChildElement("file");
+
+    //Get the image at the path in the <file> tag, with the edits in the
+    //photo's <edits> rendered over it. The decode cache only decodes the
+    //file (and renders the edits) the first time it is shown, and falls back
+    //to a screen sized proxy if the photo is over the budget. A photo that
+    //is not in memory is shown from its screen sized pixels cached on disk
+    //by an earlier display, without decoding it; image_editable() loads the
+    //full photo once it is edited.
+    QString path = photo_information.text();
+    EditRecipe edits(current_photo);
+    QSize screen_size = QGuiApplication::primaryScreen()->size();
+    QImage image_pixmap = edits.is_empty() ? ImageCache::instance()->find(path)
+                                           : ImageCache::instance()->find_render(path, edits.key());
+    current_image_is_proxy = false;
+    if(image_pixmap.isNull())
+    {
+        QSize full_size;
+        image_pixmap = PixelCache::instance()->load(path, screen_size, &full_size, edits.key());
+        current_image_is_proxy = !image_pixmap.isNull() && image_pixmap.size() != full_size;
+    }
+    if(image_pixmap.isNull())
+    {
+        image_pixmap = load_photo(path, edits, &current_image_is_proxy);
+        cache_display_pixels(path, screen_size, image_pixmap, edits);
+    }
     current_image = image_pixmap;
-    QPixmap p = (QPixmap::fromImage(image_pixmap));
+    current_orientation = ExifReader::orientation(photo_information.text());
+    watcher->watch(photo_information.text());
+    track_images();
 
     //Hide the info labels and return if no image is present
     if(current_image.isNull())
@@ -102,41 +179,43 @@ void PhotoAlbum::display_photo()
         {
             labels[i]->hide();
         }
+        ui->image->clear();
+
+        if(!current_photo.isNull())
+        {
+            QString message = "Cannot open " + photo_information.text() +
+                              "; Tools > Check Album can find or remove broken photos";
+            ui->statusBar->showMessage(message);
+        }
         return;
     }
 
-    labels[0]->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-    labels[0]->setScaledContents(true);
-
     //If the application window height is greater than the height of the iamge,
-    //display the image at full size
-    if(this->height() - 150 > current_image.height())
-    {
-        labels[0]->setPixmap(p.scaled(this->width(),current_image.height(),Qt::KeepAspectRatio));
-    }
-    else //Scale the image to fit the application window
+    //display the image at full size. Otherwise scale the image to fit the
+    //application window. The view shares current_image's pixels and applies
+    //the camera's orientation when it paints.
+    QSize upright = ExifReader::upright_size(current_image.size(), current_orientation);
+    if(this->height() - 150 > upright.height())
+        ui->image->set_image(current_image, current_orientation,
+                             QSize(this->width(), upright.height()));
+    else
+        ui->image->set_image(current_image, current_orientation,
+                             QSize(this->width(), this->height() - 155));
+    ui->image->show();
+
+    //Populate the labels in the UI from the tags in current_photo. They are
+    //looked up by name, so a record missing one shows it empty.
+    QLabel* info_labels[3] = {ui->date, ui->location, ui->description};
+    QString tags[3] = {"date", "location", "description"};
+    for(int i = 0; i < 3; i++)
     {
-        labels[0]->setPixmap(p.scaled(this->width(),this->height()-155,Qt::KeepAspectRatio));
-    }
-
-    labels[0]->show();
-    labels[0]->adjustSize();
-
-
-
-    //Loop through the tags in current_photo and populate that label in the UI
-    int i = 1;
-    for(child = child.nextSibling(); !child.isNull(); child = child.nextSibling())
-    {
-        QDomElement photo_information = child.toElement();
-        labels[i]->setText(photo_information.text());
-        labels[i]->adjustSize();
-        labels[i]->show();
-        i++;
+        info_labels[i]->setText(current_photo.firstChildElement(tags[i]).text());
+        info_labels[i]->adjustSize();
+        info_labels[i]->show();
     }
 
     //Display date, location, and description right below the image
-    ui->image_info_widget->move(0, labels[0]->height() + 10 );
+    ui->image_info_widget->move(0, ui->image->height() + 10 );
 }
 
 //Disables menu actions that require an open album
@@ -145,6 +224,8 @@ void PhotoAlbum::album_not_open()
     ui->actionSave->setEnabled(false);
     ui->actionSave_As->setEnabled(false);
     ui->actionAdd_Photo->setEnabled(false);
+    ui->actionImport_Photos->setEnabled(false);
+    ui->actionImport_Folder->setEnabled(false);
     ui->Delete_Photo->setEnabled(false);
     ui->actionEdit_Description->setEnabled(false);
     ui->actionPage_Forward->setEnabled(false);
@@ -157,8 +238,20 @@ void PhotoAlbum::album_not_open()
     ui->actionBrightness->setEnabled(false);
     ui->actionContrast->setEnabled(false);
     ui->actionNegate->setEnabled(false);
+    ui->actionApply_Edits->setEnabled(false);
     ui->actionSmooth->setEnabled(false);
     ui->actionSharpen->setEnabled(false);
+    ui->actionMedian->setEnabled(false);
+    ui->actionBilateral->setEnabled(false);
+    ui->actionGaussian_Blur->setEnabled(false);
+    ui->actionZoom_Viewer->setEnabled(false);
+    ui->actionSlideshow->setEnabled(false);
+    ui->actionFind_Duplicates->setEnabled(false);
+    ui->actionRead_Metadata->setEnabled(false);
+    ui->actionCheck_Album->setEnabled(false);
+    ui->actionExport_Gallery->setEnabled(false);
+    ui->actionAuto_Levels->setEnabled(false);
+    ui->actionAuto_Contrast->setEnabled(false);
 }
 
 //Disables menu actions for an open album that has no photos
@@ -167,6 +260,8 @@ void PhotoAlbum::album_no_photos()
     ui->actionSave->setEnabled(true);
     ui->actionSave_As->setEnabled(true);
     ui->actionAdd_Photo->setEnabled(true);
+    ui->actionImport_Photos->setEnabled(true);
+    ui->actionImport_Folder->setEnabled(true);
     ui->Delete_Photo->setEnabled(false);
     ui->actionEdit_Description->setEnabled(false);
     ui->actionPage_Forward->setEnabled(false);
@@ -179,8 +274,20 @@ void PhotoAlbum::album_no_photos()
     ui->actionBrightness->setEnabled(false);
     ui->actionContrast->setEnabled(false);
     ui->actionNegate->setEnabled(false);
+    ui->actionApply_Edits->setEnabled(false);
     ui->actionSmooth->setEnabled(false);
     ui->actionSharpen->setEnabled(false);
+    ui->actionMedian->setEnabled(false);
+    ui->actionBilateral->setEnabled(false);
+    ui->actionGaussian_Blur->setEnabled(false);
+    ui->actionZoom_Viewer->setEnabled(false);
+    ui->actionSlideshow->setEnabled(false);
+    ui->actionFind_Duplicates->setEnabled(false);
+    ui->actionRead_Metadata->setEnabled(false);
+    ui->actionCheck_Album->setEnabled(false);
+    ui->actionExport_Gallery->setEnabled(false);
+    ui->actionAuto_Levels->setEnabled(false);
+    ui->actionAuto_Contrast->setEnabled(false);
 }
 
 //Enables all the menu actions for an open album with at least one photo
@@ -189,6 +296,8 @@ void PhotoAlbum::enable_all_menu_actions()
     ui->actionSave->setEnabled(true);
     ui->actionSave_As->setEnabled(true);
     ui->actionAdd_Photo->setEnabled(true);
+    ui->actionImport_Photos->setEnabled(true);
+    ui->actionImport_Folder->setEnabled(true);
     ui->Delete_Photo->setEnabled(true);
     ui->actionEdit_Description->setEnabled(true);
     ui->actionPage_Forward->setEnabled(true);
@@ -201,8 +310,20 @@ void PhotoAlbum::enable_all_menu_actions()
     ui->actionBrightness->setEnabled(true);
     ui->actionContrast->setEnabled(true);
     ui->actionNegate->setEnabled(true);
+    ui->actionApply_Edits->setEnabled(true);
     ui->actionSmooth->setEnabled(true);
     ui->actionSharpen->setEnabled(true);
+    ui->actionMedian->setEnabled(true);
+    ui->actionBilateral->setEnabled(true);
+    ui->actionGaussian_Blur->setEnabled(true);
+    ui->actionZoom_Viewer->setEnabled(true);
+    ui->actionSlideshow->setEnabled(true);
+    ui->actionFind_Duplicates->setEnabled(true);
+    ui->actionRead_Metadata->setEnabled(true);
+    ui->actionCheck_Album->setEnabled(true);
+    ui->actionExport_Gallery->setEnabled(true);
+    ui->actionAuto_Levels->setEnabled(true);
+    ui->actionAuto_Contrast->setEnabled(true);
 }
 
 // This function receives its input (int value = 1-500), from the balance
@@ -210,6 +331,8 @@ void PhotoAlbum::enable_all_menu_actions()
 // then resized according to this percentage.
 void PhotoAlbum::resize_image(int value)
 {
+    TRACE_SCOPE("resize", "filter");
+
     double percent_resize = double(double(value)/100);  // get the input value as percent
     int h = current_image.height() * percent_resize;    // scale height
     int w = current_image.width() * percent_resize;     // scale width
@@ -220,15 +343,26 @@ void PhotoAlbum::resize_image(int value)
 }
 
 // The current image is simply rotated by the given input value in degrees
-// from -180 to 180 using a QTransform.
+// from -180 to 180 using a QTransform. value is clockwise as the photo is
+// shown, so it is turned the other way for a mirrored photo's stored pixels.
 void PhotoAlbum::rotate(int value)
 {
+    TRACE_SCOPE("rotate", "filter");
+
       // create a Qtransform for rotation
       QTransform *t = new QTransform;
       // rotate the transform by (value) degrees
-      t->rotate(value);
+      t->rotate(stored_angle(value));
       // set preview_image to the current_image rotated by (int value) degrees
       preview_image = current_image.transformed(*t);
+      delete t;
+}
+
+//The angle that turns current_image's stored pixels so the photo turns by
+//angle clockwise as it is shown. A mirroring orientation reverses the turn.
+int PhotoAlbum::stored_angle(int angle) const
+{
+    return ExifReader::mirrors(current_orientation) ? -angle : angle;
 }
 
 // This code displays the preview_image in a Qlabel in the balance widget.
@@ -236,170 +370,614 @@ void PhotoAlbum::rotate(int value)
 // the image via slider/spinbox
 void PhotoAlbum::display_preview_image()
 {
-    QPixmap preview = (QPixmap::fromImage(preview_image));      // convert preview_image to a pixmap
+    const int HistogramHeight = 80;
+    const int OptionsHeight = unsharp_options->isHidden() ? 0 : 30;
+
+    TRACE_SCOPE("display_preview_image", "scale");
+
+    track_images();
+
+    // a pending filter has the size of current_image, whatever size it was
+    // last rendered at
+    QSize size = preview_filters.is_empty() ? preview_image.size() : preview_filters.size();
+    QSize upright = ExifReader::upright_size(size, current_orientation);
+    ui->balance_widget->resize(upright.width() / 2,
+                               upright.height() / 2 + OptionsHeight + HistogramHeight);
+    QSize box(ui->balance_widget->width() - 100,
+              ui->balance_widget->height() - 100 - OptionsHeight - HistogramHeight);
 
-    // set the label so the pixmap expands to label size and is scaled
-    ui->balance_preview->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-    ui->balance_preview->setScaledContents(true);
-    ui->balance_widget->resize(preview_image.width() / 2, preview_image.height() / 2);
-    ui->balance_preview->setPixmap(preview.scaled(ui->balance_widget->width() - 100, ui->balance_widget->height() - 100, Qt::KeepAspectRatio));
-    ui->balance_preview->adjustSize();
+    // render a pending filter at the resolution the preview shows it, so the
+    // work follows the preview's size rather than the photo's
+    if(!preview_filters.is_empty() && !upright.isEmpty())
+    {
+        QSize shown = upright.scaled(box, Qt::KeepAspectRatio);
+        double scale = double(shown.width()) / upright.width()
+                       * ui->balance_preview->devicePixelRatioF();
+        preview_image = preview_filters.render(scale);
+    }
+
+    // show preview_image itself in the preview, which scales and turns it
+    // as it paints
+    ui->balance_preview->set_image(preview_image, current_orientation, box);
+
+    // show any extra options, then the histogram of the preview, between the
+    // controls and the preview
+    unsharp_options->setGeometry(10, 90, ui->balance_widget->width() - 20, OptionsHeight);
+    histogram_view->setGeometry(10, 90 + OptionsHeight, ui->balance_widget->width() - 20,
+                                HistogramHeight - 10);
+    ui->balance_preview->move(10, 90 + OptionsHeight + HistogramHeight);
+    histogram_view->set_histogram(Histogram::of(preview_image));
+    histogram_view->show();
 }
 
-// This is a brighten function for QImages. Most of the code is Dr. Weiss'
-// from examples/ip/bright.cpp
+// Makes op the filter shown in the balance widget. The preview renders it
+// for just the pixels it shows; the full photo is only filtered once the
+// user accepts.
+void PhotoAlbum::preview_filter(FilterOp *op)
+{
+    preview_filters.set_source(current_image);
+    preview_filters.clear();
+    preview_filters.append(op);
+}
+
+// This is a brighten function for QImages. The arithmetic is Dr. Weiss'
+// from examples/ip/bright.cpp, now done through a lookup table by
+// BrightnessOp.
 // This function receives its user entered input value from the slider/spinbox
 // in the balance_widget
 void PhotoAlbum::brighten(int value)
 {
-    // red, green, and blue pixels
-    int r, g, b;
+    TRACE_SCOPE("brighten", "filter");
 
-    //Dr. Weiss' code from examples/ip/bright.cpp
-    // Using the current_image's width and height and pixel values, loop
-    // through every pixel and increment by user entered value.
-    for ( int x = 0; x < current_image.width(); x++ )
-    {
-        for ( int y = 0; y < current_image.height(); y++ )
-        {
-            QRgb p = current_image.pixel( x, y );
-            r = qRed( p ) + value;
-            if ( r > 255 ) r = 255;
-            else if ( r < 0 ) r = 0;
-            g = qGreen( p ) + value;
-            if ( g > 255 ) g = 255;
-            else if ( g < 0 ) g = 0;
-            b = qBlue( p ) + value;
-            if ( b > 255 ) b = 255;
-            else if ( b < 0 ) b = 0;
-            // set the new brightened pixel in the preview_image
-            preview_image.setPixel( x, y, qRgb( r, g, b ) );
-        }
-    }
+    preview_filter(new BrightnessOp(value));
 }
 
-// This is a contrast function for QImages. Most of the code is Dr. Weiss'
-// from examples/ip/contrast.cpp
+// This is a contrast function for QImages. The arithmetic is Dr. Weiss'
+// from examples/ip/contrast.cpp, now done through a lookup table by
+// ContrastOp.
 // This function receives its user entered input value from the slider/spinbox
 // in the balance_widget
 void PhotoAlbum::contrast(int value)
 {
-    // red, green, and blue pixel values
-    int r, g, b;
+    TRACE_SCOPE("contrast", "filter");
 
-    //Dr. Weiss' code from examples/ip/contrast.cpp
-    // Using the current_image's width and height and pixel values, loop
-    // through every pixel and increment by user entered value.
-    for ( int x = 0; x < preview_image.width(); x++ )
-    {
-        for ( int y = 0; y < preview_image.height(); y++ )
-        {
-            QRgb p = current_image.pixel( x, y );
-            r = ( qRed( p ) - value) * 2;
-            if ( r < 0 ) r = 0;
-            else if ( r > 255 ) r = 255;
-            g = ( qGreen( p ) - value ) * 2;
-            if ( g < 0 ) g = 0;
-            else if ( g > 255 ) g = 255;
-            b = ( qBlue( p ) - value ) * 2;
-            if ( b < 0 ) b = 0;
-            else if ( b > 255 ) b = 255;
-            // set the new contrasted pixel in the preview_image
-            preview_image.setPixel( x, y, qRgb( r, g, b ) );
-        }
-    }
+    preview_filter(new ContrastOp(value));
 }
 
 
-// This is a smooth function for QImages. Most of the code is Dr. Weiss'
-// from examples/ip/smooth.cpp
+// This is a smooth function for QImages. The 3x3 average is Dr. Weiss'
+// from examples/ip/smooth.cpp, now run by SmoothOp.
 // This function receives its user entered input value from the slider/spinbox
 // in the balance_widget. If the user selects x, the image will be smoothed
 // x times.
 void PhotoAlbum::smooth(int value)
 {
-  // red, green, and blue pixel values
-  int r, g, b;
-
-  preview_image = current_image;
-
-  int i;
-  for(i = 0; i < value; i++)
-  {
-  QImage smooth_image(preview_image);
-
-  for ( int x = 1; x < current_image.width() - 1; x++ )
-      {
-          for ( int y = 1; y < current_image.height() - 1; y++ )
-          {
-              r = 0, g = 0, b = 0;
-              for ( int m = -1; m <= 1; m++ )
-              {
-                  for ( int n = -1; n <= 1; n++ )
-                  {
-                      QRgb p = smooth_image.pixel( x + m, y + n );
-                      r += qRed( p );
-                      g += qGreen( p );
-                      b += qBlue( p );
-                  }
-              }
-              preview_image.setPixel( x, y, qRgb( r / 9, g / 9, b / 9 ) );
-          }
-      }
-  }
-}
-
-
-// This is a sharpen function for QImages. Most of the code is Dr. Weiss'
-// from examples/ip/sharpen.cpp
-// This function receives its user entered input value from the slider/spinbox
-// in the balance_widget.
+    TRACE_SCOPE("smooth", "filter");
+
+    preview_filter(new SmoothOp(value));
+}
+
+
+// Sharpens current_image with an unsharp mask. The value from the
+// slider/spinbox in the balance_widget is the amount in percent; the radius
+// and threshold come from the spin boxes below it. Replaces the repeated
+// 5 point Laplacian this used to be, which had no control over the radius
+// and copied the whole image on every pass.
 void PhotoAlbum::sharpen(int value)
 {
-  // red, green, and blue pixel values
-  int r, g, b;
-
-  preview_image = current_image;
-
-  //loop through sharpening the image for whatever user picks on slider/spinbox
-  int i;
-  for(i = 0; i < value; i++)
-  {
-  QImage smooth_image(preview_image);
-
-  for ( int x = 1; x < current_image.width() - 1; x++ )
-  {
-      for ( int y = 1; y < current_image.height() - 1; y++ )
-      {
-          QRgb p = smooth_image.pixel( x, y );
-          r = 5 * qRed( p );
-          g = 5 * qGreen( p );
-          b = 5 * qBlue( p );
-          p = smooth_image.pixel( x - 1, y );
-          r -= qRed( p );
-          g -= qGreen( p );
-          b -= qBlue( p );
-          p = smooth_image.pixel( x + 1, y );
-          r -= qRed( p );
-          g -= qGreen( p );
-          b -= qBlue( p );
-          p = smooth_image.pixel( x, y - 1 );
-          r -= qRed( p );
-          g -= qGreen( p );
-          b -= qBlue( p );
-          p = smooth_image.pixel( x, y + 1 );
-          r -= qRed( p );
-          g -= qGreen( p );
-          b -= qBlue( p );
-
-          if ( r < 0 ) r = 0; else if ( r > 255 ) r = 255;
-          if ( g < 0 ) g = 0; else if ( g > 255 ) g = 255;
-          if ( b < 0 ) b = 0; else if ( b > 255 ) b = 255;
-
-          preview_image.setPixel( x, y, qRgb( r, g, b ) );
-      }
-  }
-
-  }
+    preview_filter(new UnsharpMaskOp(value / 100.0, unsharp_radius->value(),
+                                     unsharp_threshold->value()));
+}
+
+// Blurs current_image with a Gaussian whose sigma is value tenths of a
+// pixel. The cost does not depend on sigma.
+void PhotoAlbum::gaussian_blur(int value)
+{
+    preview_filter(new GaussianBlurOp(value / 10.0));
+}
+
+
+// Replaces each pixel of current_image by the median of the square of
+// radius value around it. The cost per pixel does not depend on the radius.
+void PhotoAlbum::median(int value)
+{
+    preview_filter(new MedianOp(value));
+}
+
+// Smooths current_image over about value pixels without smoothing across
+// edges. The cost per pixel does not depend on the radius.
+void PhotoAlbum::bilateral(int value)
+{
+    preview_image = ImageFilters::bilateral(current_image, value);
+}
+
+// Stretches each color channel of current_image to the full 0-255 range.
+// The value from the slider/spinbox in the balance_widget is how many tenths
+// of a percent of the pixels may be clipped at either end.
+void PhotoAlbum::auto_levels(int value)
+{
+    TRACE_SCOPE("auto_levels", "filter");
+
+    ToneCurve curve = ToneCurve::auto_levels(Histogram::of(current_image), value / 1000.0);
+    preview_image = curve.apply(current_image);
+}
+
+// Stretches all color channels of current_image together, so contrast is
+// maximized without shifting the colors. The slider value is the clip as in
+// auto_levels().
+void PhotoAlbum::auto_contrast(int value)
+{
+    TRACE_SCOPE("auto_contrast", "filter");
+
+    ToneCurve curve = ToneCurve::auto_contrast(Histogram::of(current_image), value / 1000.0);
+    preview_image = curve.apply(current_image);
+}
+
+
+//Reports the images held by the main window to the ImageBufferManager.
+//Called whenever current_image or preview_image is replaced.
+void PhotoAlbum::track_images()
+{
+    ImageBufferManager::instance()->track("PhotoAlbum::current_image", current_image);
+    ImageBufferManager::instance()->track("PhotoAlbum::preview_image", preview_image);
+}
+
+//Image operations need the full resolution pixels. A photo shown from the
+//PixelCache is decoded in full here. Returns false, and tells the user why,
+//when current_image is only a proxy because the photo does not fit in the
+//image memory budget.
+bool PhotoAlbum::image_editable()
+{
+    if(current_image_is_proxy)
+    {
+        QString path = current_photo.firstChildElement("file").text();
+        bool is_proxy;
+        QImage full = load_photo(path, EditRecipe(current_photo), &is_proxy);
+        if(!is_proxy && !full.isNull())
+        {
+            current_image = full;
+            current_image_is_proxy = false;
+            track_images();
+            return true;
+        }
+
+        ui->statusBar->showMessage("This photo is too large to edit within the "
+                                   "image memory budget", 3000);
+        return false;
+    }
+    return true;
+}
+
+//Returns the photo at path with edits made, from the cache when possible.
+//Renders are cached next to the decode they were made from. A photo that
+//does not fit in the memory budget is edited as a proxy, which is not
+//cached, and *is_proxy is set to true.
+QImage PhotoAlbum::load_photo(const QString &path, const EditRecipe &edits, bool *is_proxy)
+{
+    QSize screen_size = QGuiApplication::primaryScreen()->size();
+    return ImageCache::instance()->load_render(path, edits, screen_size, is_proxy);
+}
+
+//Stores the screen sized pixels of a freshly decoded or rendered photo in
+//the PixelCache in the background, so the next session can show it without
+//decoding or editing it again
+void PhotoAlbum::cache_display_pixels(const QString &path, const QSize &box, const QImage &image,
+                                      const EditRecipe &edits)
+{
+    if(image.isNull() || PixelCache::instance()->limit() == 0)
+        return;
+
+    QtConcurrent::run([path, box, image, edits]()
+    {
+        QSize full_size = edits.result_size(QImageReader(path).size());
+        QImage pixels = image;
+        if(image.width() > box.width() || image.height() > box.height())
+            pixels = image.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        PixelCache::instance()->insert(path, box, pixels, full_size, edits.key());
+    });
+}
+
+//Queues preview_image to overwrite the current photo's file. Right angle
+//rotations and block aligned crops of a JPEG that is unchanged on disk are
+//done losslessly on the DCT coefficients instead of re-encoding the pixels.
+//Anything queued for the same file first has to be re-encoded, since the
+//lossless transforms work from the file as it is on disk.
+void PhotoAlbum::save_preview_image(QString path)
+{
+    ImageWriteQueue *writer = ImageWriteQueue::instance();
+    bool file_current = !writer->is_pending(path);
+    int rotation = pending_rotation;
+    QRect crop_area = pending_crop;
+
+    if(file_current && rotation != 0 && JpegTransform::can_rotate(path, rotation))
+    {
+        writer->enqueue_encoded(path, preview_image,
+            [path, rotation](QByteArray *output, QString *error)
+            { return JpegTransform::rotate(path, rotation, output, error); });
+    }
+    else if(file_current && !crop_area.isNull() && JpegTransform::can_crop(path, crop_area))
+    {
+        writer->enqueue_encoded(path, preview_image,
+            [path, crop_area](QByteArray *output, QString *error)
+            { return JpegTransform::crop(path, crop_area, output, error); });
+    }
+    else if(current_orientation != 1)
+    {
+        //The saved file has no EXIF, so its pixels have to be upright
+        ExifReader::set_upright(path);
+        writer->enqueue(path, preview_image.transformed(ExifReader::transform(current_orientation)));
+    }
+    else
+    {
+        writer->enqueue(path, preview_image);
+    }
+
+    pending_rotation = 0;
+    pending_crop = QRect();
+}
+
+//Returns the number of photos in the album
+int PhotoAlbum::photo_count()
+{
+    return shards->photo_count();
+}
+
+//Returns the position of photo in the album, or -1 if it is not in it
+int PhotoAlbum::photo_index(const QDomElement &photo)
+{
+    return shards->photo_index(photo);
+}
+
+//Returns the photo at index, or a null element past the last photo. The
+//shard holding it is read if it has not been yet.
+QDomElement PhotoAlbum::photo_at(int index)
+{
+    return shards->photo_at(index);
+}
+
+//Returns the index of the first photo read whose file is path, or -1
+int PhotoAlbum::find_photo(const QString &path)
+{
+    return shards->find_photo(path);
+}
+
+//Inserts photo so that it becomes the photo at index
+void PhotoAlbum::insert_photo(int index, const QDomElement &photo)
+{
+    QDomElement album = album_xml.documentElement();
+    QDomElement next = shards->insertion_point(index);
+    if(next.isNull())
+        album.appendChild(photo);
+    else
+        album.insertBefore(photo, next);
+    shards->mark_dirty(photo);
+    watcher->add_file(photo.firstChildElement("file").text());
+    journal->record_insert(index, QList<QDomElement>() << photo);
+}
+
+//Inserts photos in order so that the first becomes the photo at index.
+//The position is only looked up once, however many photos there are.
+void PhotoAlbum::insert_photos(int index, const QList<QDomElement> &photos)
+{
+    TRACE_SCOPE("insert_photos", "load");
 
+    QDomElement album = album_xml.documentElement();
+    QDomElement next = shards->insertion_point(index);
+    for(int i = 0; i < photos.size(); i++)
+    {
+        if(next.isNull())
+            album.appendChild(photos[i]);
+        else
+            album.insertBefore(photos[i], next);
+        shards->mark_dirty(photos[i]);
+        watcher->add_file(photos[i].firstChildElement("file").text());
+    }
+    journal->record_insert(index, photos);
+}
+
+//Takes count photos starting at index out of the album
+void PhotoAlbum::remove_photos(int index, int count)
+{
+    QDomElement album = album_xml.documentElement();
+    QDomElement photo = photo_at(index);
+    for(int i = 0; i < count && !photo.isNull(); i++)
+    {
+        QDomElement next = shards->next_photo(photo);
+        shards->mark_dirty(photo);
+        album.removeChild(photo);
+        photo = next;
+    }
+    journal->record_remove(index, count);
+}
+
+//Returns a new <photo> element with the given information and an empty
+//description
+QDomElement PhotoAlbum::create_photo(const QString &file, const QString &date,
+                                     const QString &location)
+{
+    QDomElement photo = album_xml.createElement("photo");
+    QString tags[4] = {"file", "date", "location", "description"};
+    QString values[4] = {file, date, location, ""};
+    for(int i = 0; i < 4; i++)
+    {
+        QDomElement tag = album_xml.createElement(tags[i]);
+        tag.appendChild(album_xml.createTextNode(values[i]));
+        photo.appendChild(tag);
+    }
+    return photo;
+}
+
+//Paths in the <file> tags of every photo in the album, in album order
+QStringList PhotoAlbum::photo_files()
+{
+    QStringList files;
+    QDomElement photo = album_xml.documentElement().firstChildElement("photo");
+    for(; !photo.isNull(); photo = photo.nextSiblingElement("photo"))
+    {
+        files.append(photo.firstChildElement("file").text());
+    }
+    return files;
+}
+
+//Replaces the whole album with a copy of the <album> element album, staying
+//at the same position in it
+void PhotoAlbum::replace_album(const QDomElement &album)
+{
+    int index = photo_index(current_photo);
+    album_xml.replaceChild(album.cloneNode(true), album_xml.documentElement());
+    shards->mark_all_dirty();
+    watcher->set_album(album_filename, photo_files());
+    journal->record_album(album_xml.documentElement());
+    show_photo(qMin(qMax(index, 0), photo_count() - 1));
+}
+
+//Takes the photo at index out of the album and returns it
+QDomElement PhotoAlbum::remove_photo(int index)
+{
+    QDomElement photo = photo_at(index);
+    shards->mark_dirty(photo);
+    album_xml.documentElement().removeChild(photo);
+    journal->record_remove(index, 1);
+    return photo;
+}
+
+//Replaces the <edits> of the photo at index with a copy of edits, or
+//removes them if edits is null or empty, and shows the photo
+void PhotoAlbum::set_photo_edits(int index, const QDomElement &edits)
+{
+    QDomElement photo = photo_at(index);
+    QDomElement old = photo.firstChildElement(EditRecipe::TagName);
+    if(!old.isNull())
+        photo.removeChild(old);
+    if(!edits.isNull() && edits.hasChildNodes())
+        photo.appendChild(edits.cloneNode());
+    shards->mark_dirty(photo);
+    journal->record_tag(index, EditRecipe::TagName, photo.firstChildElement(EditRecipe::TagName));
+    show_photo(index);
+}
+
+//Adds step to the end of the current photo's edits as one step of the
+//undo history. The photo's file is left as it is.
+void PhotoAlbum::apply_edit(const QDomElement &step)
+{
+    QDomElement before = current_photo.firstChildElement(EditRecipe::TagName);
+    QDomElement after = before.isNull() ? album_xml.createElement(EditRecipe::TagName)
+                                        : before.cloneNode().toElement();
+    after.appendChild(step);
+
+    QString tag = step.tagName();
+    undo_stack->push(new EditRecipeCommand(this, photo_index(current_photo),
+                                           before.cloneNode().toElement(), after,
+                                           tag.left(1).toUpper() + tag.mid(1)));
+}
+
+//Returns the recipe step of the balance widget's operation at value, or a
+//null element if none is selected. Auto levels and auto contrast keep the
+//stretch they chose, since the histogram it came from changes with any
+//edit before them.
+QDomElement PhotoAlbum::balance_step(int value)
+{
+    QDomElement step;
+    if(is_brighten)
+    {
+        step = album_xml.createElement("brighten");
+        step.setAttribute("value", value);
+    }
+    else if(is_contrast)
+    {
+        step = album_xml.createElement("contrast");
+        step.setAttribute("value", value);
+    }
+    else if(is_rotate)
+    {
+        step = album_xml.createElement("rotate");
+        step.setAttribute("angle", stored_angle(value));
+    }
+    else if(is_resize)
+    {
+        step = album_xml.createElement("resize");
+        step.setAttribute("percent", value);
+    }
+    else if(is_smooth)
+    {
+        step = album_xml.createElement("smooth");
+        step.setAttribute("passes", value);
+    }
+    else if(is_sharpen)
+    {
+        step = album_xml.createElement("sharpen");
+        step.setAttribute("amount", value / 100.0);
+        step.setAttribute("radius", unsharp_radius->value());
+        step.setAttribute("threshold", unsharp_threshold->value());
+    }
+    else if(is_auto_levels || is_auto_contrast)
+    {
+        Histogram histogram = Histogram::of(current_image);
+        ToneCurve curve = is_auto_levels ? ToneCurve::auto_levels(histogram, value / 1000.0)
+                                         : ToneCurve::auto_contrast(histogram, value / 1000.0);
+        const char *channels[3] = {"red", "green", "blue"};
+        step = album_xml.createElement("levels");
+        for(int channel = 0; channel < 3; channel++)
+        {
+            step.setAttribute(QString(channels[channel]) + "_low", curve.low(channel));
+            step.setAttribute(QString(channels[channel]) + "_high", curve.high(channel));
+        }
+    }
+    else if(is_median)
+    {
+        step = album_xml.createElement("median");
+        step.setAttribute("radius", value);
+    }
+    else if(is_bilateral)
+    {
+        step = album_xml.createElement("bilateral");
+        step.setAttribute("radius", value);
+    }
+    else if(is_blur)
+    {
+        step = album_xml.createElement("blur");
+        step.setAttribute("sigma", value / 10.0);
+    }
+    return step;
+}
+
+//Makes the photo at index the current photo and displays it, enabling the
+//menu actions that need a photo. An index of -1 shows the empty album.
+void PhotoAlbum::show_photo(int index)
+{
+    if(index < 0)
+    {
+        current_photo = QDomElement();
+        display_photo();
+
+        //Enable only menu actions for an album with no photos
+        album_no_photos();
+        return;
+    }
+
+    current_photo = photo_at(index);
+    enable_all_menu_actions();
+    display_photo();
+}
+
+//Adds the edit of the photo at path shown in preview_image to the undo
+//history. Called before the edit is saved, while current_image still holds
+//the photo as it was.
+void PhotoAlbum::record_photo_edit(const QString &path)
+{
+    TRACE_SCOPE("record_photo_edit", "history");
+
+    QString name = "Edit Photo";
+    if(!pending_crop.isNull())
+        name = "Crop";
+    else if(pending_rotation != 0)
+        name = "Rotate";
+
+    if(current_image_is_proxy || current_orientation != 1)
+    {
+        //The photo is too large to keep as tiles, or its orientation is
+        //only in its EXIF, so keep the file instead. Any earlier write to it
+        //has to land first.
+        ImageWriteQueue::instance()->wait_for(path);
+
+        QFile file(path);
+        if(!file.open(QFile::ReadOnly))
+        {
+            ui->statusBar->showMessage("Cannot keep " + path + " for undo: "
+                                       + file.errorString(), 3000);
+            return;
+        }
+
+        //Tiles are written back without EXIF, so they are kept upright
+        if(current_orientation == 1)
+            last_snapshot = TiledImage::from_image(preview_image);
+        else
+            last_snapshot = TiledImage::from_image(preview_image.transformed(
+                                ExifReader::transform(current_orientation)));
+        last_snapshot_path = path;
+        undo_stack->push(new EditPhotoCommand(this, path, name, TiledImage(),
+                                              last_snapshot, file.readAll()));
+        return;
+    }
+
+    //Reuse the tiles of the last saved version when current_image is still
+    //exactly that version
+    TiledImage before = last_snapshot;
+    if(last_snapshot_path != path || current_image.cacheKey() != last_snapshot_key
+       || before.size() != current_image.size())
+    {
+        before = TiledImage::from_image(current_image);
+    }
+
+    TiledImage after = TiledImage::from_image(preview_image, before);
+
+    last_snapshot = after;
+    last_snapshot_path = path;
+    undo_stack->push(new EditPhotoCommand(this, path, name, before, after));
+}
+
+//Queues image to overwrite the file at path, as an undo or redo of an
+//earlier edit
+void PhotoAlbum::restore_photo(const QString &path, const TiledImage &image)
+{
+    if(path == unwritten_path)
+        return;
+
+    QImage pixels = image.to_image();
+    ExifReader::set_upright(path);
+    ImageWriteQueue::instance()->enqueue(path, pixels);
+
+    last_snapshot = image;
+    last_snapshot_path = path;
+    last_snapshot_key = pixels.cacheKey();
+
+    if(current_photo.firstChild().toElement().text() == path)
+        display_photo();
+
+    QString message = "Restoring image " + path;
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Writes the earlier contents of a photo too large to keep as tiles back to
+//path. Done right away, after any queued write to path has landed.
+void PhotoAlbum::restore_photo_file(const QString &path, const QByteArray &contents)
+{
+    if(path == unwritten_path)
+        return;
+
+    ImageWriteQueue::instance()->wait_for(path);
+
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size()
+       || !file.commit())
+    {
+        image_write_failed(path, file.errorString());
+        return;
+    }
+
+    ImageCache::instance()->remove(path);
+    watcher->note_written(path);
+    last_snapshot = TiledImage();
+
+    if(current_photo.firstChild().toElement().text() == path)
+        display_photo();
+
+    QString message = "Restored image " + path;
+    ui->statusBar->showMessage(message, 3000);
+}
+
+//Puts text in the tag of photo if that tag is still empty. Returns true if
+//it did.
+bool PhotoAlbum::fill_photo_tag(QDomElement photo, const QString &tag, const QString &text)
+{
+    QDomElement element = photo.firstChildElement(tag);
+    if(text.isEmpty() || element.isNull() || !element.text().trimmed().isEmpty())
+        return false;
+
+    while(element.hasChildNodes())
+    {
+        element.removeChild(element.firstChild());
+    }
+    element.appendChild(photo.ownerDocument().createTextNode(text));
+    return true;
 }
@@ -0,0 +1,287 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the PixelCache class declared in
+//pixel_cache.h. Entries are written through QSaveFile, so a reader never
+//maps a half written file. The index of entries and their last use is
+//rebuilt from the directory the first time the cache is used; a hit sets
+//the file's modification time, which carries the use over to the next
+//session.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "pixel_cache.h"
+#include "trace.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+const char Magic[4] = {'P', 'A', 'P', 'X'};
+const quint32 Version = 1;
+
+//The pixels start this far into the file, on a row boundary
+const int HeaderSize = PixelCache::RowAlignment;
+
+struct Header
+{
+    char magic[4];
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 bytes_per_line;
+    qint32 format;      //QImage::Format of the pixels
+    qint32 full_width;  //Size of the photo they were scaled from
+    qint32 full_height;
+};
+
+QString hash(const QString &text)
+{
+    return QString(QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+//Prefix of the file names of every entry of the photo at path
+QString path_prefix(const QString &path)
+{
+    return hash(QFileInfo(path).absoluteFilePath()) + "-";
+}
+
+//Unmaps a cached image's pixels once the last QImage using them is gone
+void release_mapping(void *file)
+{
+    delete static_cast<QFile *>(file);
+}
+}
+
+PixelCache::PixelCache() :
+    directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/pixels"),
+    total_bytes(0),
+    max_bytes(DefaultLimit),
+    index_loaded(false)
+{
+}
+
+PixelCache *PixelCache::instance()
+{
+    static PixelCache cache;
+    return &cache;
+}
+
+void PixelCache::set_limit(qint64 bytes)
+{
+    QMutexLocker lock(&mutex);
+    max_bytes = qMax(qint64(0), bytes);
+    if(index_loaded)
+        evict();
+}
+
+qint64 PixelCache::limit() const
+{
+    return max_bytes;
+}
+
+//Returns the file of the entry of path for box and edits, or an empty
+//string if path does not exist
+QString PixelCache::file_name(const QString &path, const QSize &box, const QString &edits) const
+{
+    QFileInfo info(path);
+    if(!info.exists())
+        return QString();
+
+    QString version = QString("%1:%2:%3x%4").arg(info.size())
+                      .arg(info.lastModified().toMSecsSinceEpoch())
+                      .arg(box.width()).arg(box.height());
+    if(!edits.isEmpty())
+        version += ":" + edits;
+    return path_prefix(path) + hash(version) + ".raw";
+}
+
+//Reads the entries left by earlier sessions. Called with the mutex held.
+void PixelCache::load_index()
+{
+    if(index_loaded)
+        return;
+    index_loaded = true;
+
+    TRACE_SCOPE("load_pixel_cache_index", "load");
+
+    QFileInfoList files = QDir(directory).entryInfoList(QStringList("*.raw"), QDir::Files);
+    for(int i = 0; i < files.size(); i++)
+    {
+        Entry entry = {files[i].size(), files[i].lastModified().toMSecsSinceEpoch()};
+        entries.insert(files[i].fileName(), entry);
+        total_bytes += entry.bytes;
+    }
+    evict();
+}
+
+//Deletes the least recently used entries until the cache fits its limit.
+//Called with the mutex held.
+void PixelCache::evict()
+{
+    if(total_bytes <= max_bytes)
+        return;
+
+    QVector<QPair<qint64, QString> > by_use;
+    by_use.reserve(entries.size());
+    for(QHash<QString, Entry>::const_iterator it = entries.constBegin();
+        it != entries.constEnd(); ++it)
+    {
+        by_use.append(qMakePair(it->used, it.key()));
+    }
+    std::sort(by_use.begin(), by_use.end());
+
+    //A mapped entry can still be deleted; its pixels stay readable until
+    //they are unmapped
+    for(int i = 0; i < by_use.size() && total_bytes > max_bytes; i++)
+    {
+        QFile::remove(directory + "/" + by_use[i].second);
+        total_bytes -= entries.take(by_use[i].second).bytes;
+    }
+}
+
+QImage PixelCache::load(const QString &path, const QSize &box, QSize *full_size,
+                        const QString &edits)
+{
+    TRACE_SCOPE("load_cached_pixels", "load");
+
+    QString name = file_name(path, box, edits);
+    {
+        QMutexLocker lock(&mutex);
+        if(max_bytes == 0 || name.isEmpty())
+            return QImage();
+
+        load_index();
+        QHash<QString, Entry>::iterator it = entries.find(name);
+        if(it == entries.end())
+            return QImage();
+        it->used = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    QFile *file = new QFile(directory + "/" + name);
+    if(!file->open(QIODevice::ReadOnly))
+    {
+        delete file;
+        return QImage();
+    }
+    file->setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    //Check the header before trusting the size of the pixels
+    Header header;
+    qint64 file_size = file->size();
+    uchar *data = file_size >= HeaderSize ? file->map(0, file_size) : NULL;
+    if(data != NULL)
+        std::memcpy(&header, data, sizeof(header));
+    if(data == NULL || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+       header.version != Version || header.width <= 0 || header.height <= 0 ||
+       header.bytes_per_line < header.width * 4 ||
+       file_size != HeaderSize + qint64(header.bytes_per_line) * header.height ||
+       (header.format != QImage::Format_RGB32 &&
+        header.format != QImage::Format_ARGB32_Premultiplied))
+    {
+        delete file;
+        remove(path);
+        return QImage();
+    }
+
+    if(full_size)
+        *full_size = QSize(header.full_width, header.full_height);
+
+    //The const data constructor makes the image read-only, so nothing ever
+    //writes through the mapping
+    const uchar *pixels = data + HeaderSize;
+    return QImage(pixels, header.width, header.height, header.bytes_per_line,
+                  QImage::Format(header.format), release_mapping, file);
+}
+
+void PixelCache::insert(const QString &path, const QSize &box, const QImage &image,
+                        const QSize &full_size, const QString &edits)
+{
+    TRACE_SCOPE("store_cached_pixels", "save");
+
+    QString name = file_name(path, box, edits);
+    if(image.isNull() || name.isEmpty())
+        return;
+
+    QImage pixels = image.convertToFormat(image.hasAlphaChannel()
+                                          ? QImage::Format_ARGB32_Premultiplied
+                                          : QImage::Format_RGB32);
+    int row_bytes = pixels.width() * 4;
+    int bytes_per_line = (row_bytes + RowAlignment - 1) / RowAlignment * RowAlignment;
+    qint64 bytes = HeaderSize + qint64(bytes_per_line) * pixels.height();
+    {
+        QMutexLocker lock(&mutex);
+        load_index();
+        if(bytes > max_bytes || entries.contains(name))
+            return;
+    }
+
+    QDir().mkpath(directory);
+    QSaveFile file(directory + "/" + name);
+    if(!file.open(QIODevice::WriteOnly))
+        return;
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.width = pixels.width();
+    header.height = pixels.height();
+    header.bytes_per_line = bytes_per_line;
+    header.format = pixels.format();
+    header.full_width = full_size.width();
+    header.full_height = full_size.height();
+
+    QByteArray head(HeaderSize, 0);
+    std::memcpy(head.data(), &header, sizeof(header));
+    file.write(head);
+
+    QByteArray padding(bytes_per_line - row_bytes, 0);
+    for(int y = 0; y < pixels.height(); y++)
+    {
+        file.write(reinterpret_cast<const char *>(pixels.constScanLine(y)), row_bytes);
+        if(!padding.isEmpty())
+            file.write(padding);
+    }
+    if(!file.commit())
+        return;
+
+    QMutexLocker lock(&mutex);
+    if(!entries.contains(name))
+    {
+        Entry entry = {bytes, QDateTime::currentMSecsSinceEpoch()};
+        entries.insert(name, entry);
+        total_bytes += bytes;
+        evict();
+    }
+}
+
+void PixelCache::remove(const QString &path)
+{
+    QString prefix = path_prefix(path);
+
+    QMutexLocker lock(&mutex);
+    load_index();
+    QHash<QString, Entry>::iterator it = entries.begin();
+    while(it != entries.end())
+    {
+        if(it.key().startsWith(prefix))
+        {
+            QFile::remove(directory + "/" + it.key());
+            total_bytes -= it->bytes;
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
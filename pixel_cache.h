@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The PixelCache class, an on-disk cache of photos decoded and
+//scaled down to display size, kept across sessions. Showing a photo again
+//maps its cached pixels instead of decoding the JPEG or PNG.
+//
+//Each entry is one file of raw 32 bit pixels behind a small header, with
+//every row padded to RowAlignment bytes. load() memory-maps the file and
+//wraps the mapping in a read-only QImage without copying it; the mapping
+//is released when the last copy of that QImage goes away, and writing to
+//the image detaches it into memory as usual. Mapped pixels live in the
+//operating system's page cache, so they are not counted against the image
+//memory budget.
+//
+//Entries are keyed by the photo's path, size, modification time, the box
+//the pixels were scaled to fit and the edits rendered over the photo, so a
+//changed photo is never shown from a stale entry. The least recently used entries are deleted once the cache
+//grows past its limit.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PIXEL_CACHE_H
+#define PIXEL_CACHE_H
+
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+
+class PixelCache
+{
+public:
+    static const qint64 DefaultLimit = qint64(1024) * 1024 * 1024;
+
+    //Rows of a cached image start on multiples of this many bytes
+    static const int RowAlignment = 64;
+
+    static PixelCache *instance();
+
+    //Largest total size of the cache files. 0 disables the cache.
+    void set_limit(qint64 bytes);
+    qint64 limit() const;
+
+    //Returns the pixels of path cached for box, mapped from disk, or a null
+    //image. *full_size is set to the size of the photo itself. edits is the
+    //EditRecipe::key() of the edits shown, empty for the photo as it is.
+    QImage load(const QString &path, const QSize &box, QSize *full_size = 0,
+                const QString &edits = QString());
+
+    //Caches image, the photo at path (full_size pixels) with edits, scaled
+    //to fit box. Safe to call from any thread; meant for a background thread.
+    void insert(const QString &path, const QSize &box, const QImage &image,
+                const QSize &full_size, const QString &edits = QString());
+
+    //Deletes every cached entry of path, for any version of the file
+    void remove(const QString &path);
+
+private:
+    struct Entry
+    {
+        qint64 bytes;
+        qint64 used; //Last use, in milliseconds since the epoch
+    };
+
+    PixelCache();
+
+    QString file_name(const QString &path, const QSize &box, const QString &edits) const;
+    void load_index();
+    void evict();
+
+    QString directory;
+    QMutex mutex;
+    QHash<QString, Entry> entries; //By file name
+    qint64 total_bytes;
+    qint64 max_bytes;
+    bool index_loaded;
+};
+
+#endif // PIXEL_CACHE_H
@@ -0,0 +1,459 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the RenderService class declared in
+//render_service.h. Requests are gathered into a queue while a batch is
+//being rendered, and the queue becomes the next batch as soon as it is
+//done, so a busy service renders larger batches rather than falling
+//behind. Segment keys include the process id, so a segment left behind by
+//a service that crashed is never handed out as a new one.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "render_service.h"
+#include "album_shards.h"
+#include "image_cache.h"
+#include "trace.h"
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QTimer>
+#include <QtConcurrent>
+#include <cstring>
+
+const char *const RenderService::DefaultName = "PhotoAlbumRender";
+
+namespace
+{
+//Time requests are gathered for before an idle service starts a batch
+const int BatchDelayMs = 2;
+
+//Photos too large for the memory budget are decoded to fit this instead.
+//It does not depend on the request, since the proxy is cached for all of
+//them.
+const QSize ProxySize(4096, 4096);
+
+//Time to wait for another service to answer at the same name
+const int ConnectTimeoutMs = 100;
+}
+
+RenderService::RenderService(QObject *parent) :
+    QObject(parent),
+    next_segment(0)
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, SIGNAL(newConnection()), this, SLOT(new_connection()));
+
+    shards = new AlbumShards(this);
+    shards->set_album(QString(), &album);
+
+    batch_timer = new QTimer(this);
+    batch_timer->setSingleShot(true);
+    batch_timer->setInterval(BatchDelayMs);
+    connect(batch_timer, SIGNAL(timeout()), this, SLOT(start_batch()));
+
+    batch_watcher = new QFutureWatcher<void>(this);
+    connect(batch_watcher, SIGNAL(finished()), this, SLOT(batch_done()));
+}
+
+RenderService::~RenderService()
+{
+    batch_watcher->waitForFinished();
+    QHash<QString, Segment>::iterator it = segments.begin();
+    for(; it != segments.end(); ++it)
+    {
+        delete it.value().memory;
+    }
+}
+
+bool RenderService::listen(const QString &name, const QString &album_path)
+{
+    this->name = name;
+    this->album_path = album_path;
+    if(!album_path.isEmpty())
+    {
+        refresh_album();
+        if(album_modified.isNull())
+        {
+            error = "Cannot read album " + album_path;
+            return false;
+        }
+    }
+
+    //A socket left behind by a service that crashed keeps the name taken,
+    //but one that is still running must be left alone
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if(probe.waitForConnected(ConnectTimeoutMs))
+    {
+        error = "A render service is already running at " + name;
+        return false;
+    }
+    QLocalServer::removeServer(name);
+
+    if(!server->listen(name))
+    {
+        error = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+//Reads the album again if its file has changed since it was last read
+void RenderService::refresh_album()
+{
+    if(album_path.isEmpty())
+        return;
+
+    QDateTime modified = QFileInfo(album_path).lastModified();
+    if(!album_modified.isNull() && modified == album_modified)
+        return;
+
+    TRACE_SCOPE("read_album", "load");
+
+    //An album that cannot be read, e.g. while it is being saved, leaves the
+    //photos as they were
+    QFile file(album_path);
+    QDomDocument document;
+    if(!file.open(QIODevice::ReadOnly) || !document.setContent(&file, true))
+        return;
+
+    album = document;
+    shards->set_album(album_path, &album);
+    album_modified = modified;
+}
+
+void RenderService::new_connection()
+{
+    while(server->hasPendingConnections())
+    {
+        QLocalSocket *socket = server->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(read_requests()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(client_disconnected()));
+        held.insert(socket, QStringList());
+    }
+}
+
+void RenderService::read_requests()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if(socket == NULL || !socket->canReadLine())
+        return;
+
+    refresh_album();
+    while(socket->canReadLine())
+    {
+        QJsonParseError parse_error;
+        QJsonDocument document = QJsonDocument::fromJson(socket->readLine(), &parse_error);
+        if(parse_error.error != QJsonParseError::NoError || !document.isObject())
+        {
+            reply_error(socket, QJsonValue(), "Request is not a JSON object");
+            continue;
+        }
+
+        QJsonObject request = document.object();
+        if(request.contains("release"))
+            release(socket, request.value("release").toString());
+        else
+            handle_request(socket, request);
+    }
+}
+
+void RenderService::client_disconnected()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if(socket == NULL)
+        return;
+
+    QStringList keys = held.value(socket);
+    for(int i = 0; i < keys.size(); i++)
+    {
+        release(socket, keys[i]);
+    }
+    held.remove(socket);
+    socket->deleteLater();
+}
+
+//Sets *path to the file of photo, an album position or a path, and
+//*element to its <photo> if it is in the album
+bool RenderService::find_photo(const QJsonValue &photo, QString *path, QDomElement *element)
+{
+    if(photo.isString())
+    {
+        *path = photo.toString();
+        *element = QDomElement();
+        return !path->isEmpty();
+    }
+
+    if(!photo.isDouble())
+        return false;
+    int index = photo.toInt(-1);
+    if(index < 0 || index >= shards->photo_count())
+        return false;
+    *element = shards->photo_at(index);
+    if(element->isNull())
+        return false;
+    *path = element->firstChildElement("file").text();
+    return true;
+}
+
+//Queues the render request asks for, unless an identical one is already
+//in shared memory or in the queue
+void RenderService::handle_request(QLocalSocket *socket, const QJsonObject &request)
+{
+    QJsonValue id = request.value("id");
+    QString path;
+    QDomElement photo;
+    if(!find_photo(request.value("photo"), &path, &photo))
+    {
+        reply_error(socket, id, "No such photo");
+        return;
+    }
+
+    //The photo's own edits come first, then the requested ones
+    QDomDocument document;
+    QDomElement holder = document.createElement("photo");
+    document.appendChild(holder);
+    QDomElement own = photo.firstChildElement(EditRecipe::TagName);
+    QDomElement edits = own.isNull() ? document.createElement(EditRecipe::TagName)
+                                     : document.importNode(own, true).toElement();
+    holder.appendChild(edits);
+
+    QJsonArray ops = request.value("ops").toArray();
+    for(int i = 0; i < ops.size(); i++)
+    {
+        QJsonObject op = ops[i].toObject();
+        QString step_name = op.value("op").toString();
+        if(step_name.isEmpty())
+        {
+            reply_error(socket, id, QString("Step %1 has no op").arg(i));
+            return;
+        }
+
+        QDomElement step = document.createElement(step_name);
+        QJsonObject::const_iterator it = op.constBegin();
+        for(; it != op.constEnd(); ++it)
+        {
+            if(it.key() != "op")
+                step.setAttribute(it.key(), it.value().toDouble());
+        }
+        edits.appendChild(step);
+    }
+
+    Render render;
+    render.edits = EditRecipe(holder);
+    render.box = QSize(request.value("width").toInt(), request.value("height").toInt());
+    render.key = path + "#" + render.edits.key() + "#" + QString::number(render.box.width())
+                 + "x" + QString::number(render.box.height());
+    render.waiting.append(qMakePair(QPointer<QLocalSocket>(socket), id));
+
+    //Still in shared memory from an earlier batch
+    if(published.contains(render.key))
+    {
+        reply_render(socket, id, published.value(render.key));
+        return;
+    }
+
+    //Renders of the same photo are queued together, and identical ones once
+    int job = queued_photos.value(path, -1);
+    if(job < 0)
+    {
+        PhotoJob photo_job;
+        photo_job.path = path;
+        queue.append(photo_job);
+        job = queue.size() - 1;
+        queued_photos.insert(path, job);
+    }
+    QList<Render> &renders = queue[job].renders;
+    for(int i = 0; i < renders.size(); i++)
+    {
+        if(renders[i].key == render.key)
+        {
+            renders[i].waiting.append(render.waiting.first());
+            return;
+        }
+    }
+    renders.append(render);
+
+    if(!batch_watcher->isRunning() && !batch_timer->isActive())
+        batch_timer->start();
+}
+
+void RenderService::start_batch()
+{
+    if(queue.isEmpty() || batch_watcher->isRunning())
+        return;
+
+    batch = queue;
+    queue.clear();
+    queued_photos.clear();
+    batch_watcher->setFuture(QtConcurrent::map(batch, render_photo));
+}
+
+//Makes every render of job from one decode of its photo. Runs on the
+//thread pool.
+void RenderService::render_photo(PhotoJob &job)
+{
+    TRACE_SCOPE("render_request", "render");
+
+    for(int i = 0; i < job.renders.size(); i++)
+    {
+        Render &render = job.renders[i];
+        QImage image = ImageCache::instance()->load_render(job.path, render.edits, ProxySize);
+        if(!render.box.isEmpty()
+           && (image.width() > render.box.width() || image.height() > render.box.height()))
+        {
+            image = image.scaled(render.box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        render.image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+}
+
+//Hands the batch's renders to the clients waiting for them, and to any
+//identical requests queued while they were being made
+void RenderService::batch_done()
+{
+    for(int i = 0; i < batch.size(); i++)
+    {
+        QList<Render> &renders = batch[i].renders;
+        for(int j = 0; j < renders.size(); j++)
+        {
+            Render &render = renders[j];
+            if(render.image.isNull())
+            {
+                error = "Cannot decode " + batch[i].path;
+                answer(render, QString());
+                continue;
+            }
+
+            QString segment_key = publish(render);
+            render.image = QImage();
+            answer(render, segment_key);
+        }
+    }
+    batch.clear();
+
+    for(int i = queue.size() - 1; i >= 0; i--)
+    {
+        QList<Render> &renders = queue[i].renders;
+        for(int j = renders.size() - 1; j >= 0; j--)
+        {
+            if(!published.contains(renders[j].key))
+                continue;
+            Render render = renders.takeAt(j);
+            answer(render, published.value(render.key));
+        }
+        if(renders.isEmpty())
+            queue.removeAt(i);
+    }
+    queued_photos.clear();
+    for(int i = 0; i < queue.size(); i++)
+    {
+        queued_photos.insert(queue[i].path, i);
+    }
+
+    start_batch();
+}
+
+//Copies the pixels of render into a new shared memory segment and returns
+//its key, or an empty string if it cannot be made
+QString RenderService::publish(const Render &render)
+{
+    QString key = QString("%1-%2-%3").arg(name).arg(QCoreApplication::applicationPid())
+                  .arg(next_segment++);
+    QSharedMemory *memory = new QSharedMemory(key);
+    int bytes = render.image.bytesPerLine() * render.image.height();
+    if(!memory->create(bytes))
+    {
+        error = "Cannot share pixels: " + memory->errorString();
+        delete memory;
+        return QString();
+    }
+
+    memory->lock();
+    std::memcpy(memory->data(), render.image.constBits(), size_t(bytes));
+    memory->unlock();
+
+    Segment segment = {memory, render.image.size(), render.image.bytesPerLine(), 0, render.key};
+    segments.insert(key, segment);
+    published.insert(render.key, key);
+    return key;
+}
+
+//Replies to every client still waiting for render with segment_key, or
+//with the last error if it is empty. A segment nobody was left to take is
+//dropped again.
+void RenderService::answer(const Render &render, const QString &segment_key)
+{
+    for(int i = 0; i < render.waiting.size(); i++)
+    {
+        QLocalSocket *socket = render.waiting[i].first;
+        if(socket == NULL)
+            continue;
+        if(segment_key.isEmpty())
+            reply_error(socket, render.waiting[i].second, error);
+        else
+            reply_render(socket, render.waiting[i].second, segment_key);
+    }
+
+    if(!segment_key.isEmpty() && segments.value(segment_key).holders == 0)
+    {
+        published.remove(render.key);
+        delete segments.take(segment_key).memory;
+    }
+}
+
+void RenderService::reply(QLocalSocket *socket, const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void RenderService::reply_render(QLocalSocket *socket, const QJsonValue &id,
+                                 const QString &segment_key)
+{
+    Segment &segment = segments[segment_key];
+    segment.holders++;
+    held[socket].append(segment_key);
+
+    QJsonObject message;
+    message.insert("id", id);
+    message.insert("key", segment_key);
+    message.insert("width", segment.size.width());
+    message.insert("height", segment.size.height());
+    message.insert("bytes_per_line", segment.bytes_per_line);
+    reply(socket, message);
+}
+
+void RenderService::reply_error(QLocalSocket *socket, const QJsonValue &id,
+                                const QString &message)
+{
+    QJsonObject object;
+    object.insert("id", id);
+    object.insert("error", message);
+    reply(socket, object);
+}
+
+//Lets go of one hold socket has on the segment. The segment is freed once
+//no client holds it.
+void RenderService::release(QLocalSocket *socket, const QString &segment_key)
+{
+    QHash<QLocalSocket *, QStringList>::iterator client = held.find(socket);
+    if(client == held.end() || !client.value().removeOne(segment_key))
+        return;
+
+    Segment &segment = segments[segment_key];
+    if(--segment.holders > 0)
+        return;
+    published.remove(segment.render_key);
+    delete segments.take(segment_key).memory;
+}
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The RenderService class, which lets other programs on the
+//same machine have photos decoded, edited and scaled by this application,
+//with the same caches and edit recipes the album uses. It listens on a
+//QLocalServer (a Unix domain socket, or a named pipe on Windows) and is
+//started with --serve.
+//
+//A client sends one request per line of JSON:
+//
+//  {"id":7,"photo":3,"ops":[{"op":"brighten","value":20}],"width":256,"height":256}
+//
+//photo is either the position of a photo in the album the service was
+//started with, whose own edits are made first, or the path of any photo
+//file. ops are further edit recipe steps, named and valued as in the album
+//(see edit_recipe.h). The result is scaled down to fit width by height,
+//if given, and never scaled up. The reply is a line of JSON too:
+//
+//  {"id":7,"key":"PhotoAlbumRender-4711-12","width":256,"height":171,"bytes_per_line":1024}
+//  {"id":7,"error":"Cannot decode /photos/a.jpg"}
+//
+//key names a QSharedMemory segment holding the pixels as rows of 32 bit
+//0xAARRGGBB words (QImage::Format_ARGB32), bytes_per_line apart. The
+//client attaches to it, copies the pixels and then sends
+//
+//  {"release":"PhotoAlbumRender-4711-12"}
+//
+//Segments still held when a client disconnects are released for it.
+//
+//Requests arriving together are rendered as one batch on the thread pool:
+//each photo is decoded once for the whole batch, and identical requests,
+//in the batch or still held in shared memory from an earlier one, share a
+//single render and segment.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef RENDER_SERVICE_H
+#define RENDER_SERVICE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QDomDocument>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QJsonValue>
+#include <QList>
+#include <QPointer>
+#include "edit_recipe.h"
+
+class AlbumShards;
+class QLocalServer;
+class QLocalSocket;
+class QSharedMemory;
+class QTimer;
+
+class RenderService : public QObject
+{
+    Q_OBJECT
+
+public:
+    //Server name clients connect to unless another is given
+    static const char *const DefaultName;
+
+    explicit RenderService(QObject *parent = 0);
+    ~RenderService();
+
+    //Starts accepting clients at name, serving the photos of the album at
+    //album_path, which may be empty. Returns false if it cannot.
+    bool listen(const QString &name, const QString &album_path = QString());
+
+    QString error_string() const { return error; }
+
+private slots:
+    void new_connection();
+    void read_requests();
+    void client_disconnected();
+    void start_batch();
+    void batch_done();
+
+private:
+    //One result to render, with every request waiting for it
+    struct Render
+    {
+        QString key; //Photo, edits and box, the same for identical requests
+        EditRecipe edits;
+        QSize box;
+        QImage image;
+        QList<QPair<QPointer<QLocalSocket>, QJsonValue> > waiting; //Client and request id
+    };
+
+    //The renders of one photo in a batch, made from a single decode
+    struct PhotoJob
+    {
+        QString path;
+        QList<Render> renders;
+    };
+
+    //Pixels of a render in shared memory, and how many times clients hold them
+    struct Segment
+    {
+        QSharedMemory *memory;
+        QSize size;
+        int bytes_per_line;
+        int holders;
+        QString render_key;
+    };
+
+    static void render_photo(PhotoJob &job);
+
+    void handle_request(QLocalSocket *socket, const QJsonObject &request);
+    bool find_photo(const QJsonValue &photo, QString *path, QDomElement *element);
+    void refresh_album();
+    QString publish(const Render &render);
+    void answer(const Render &render, const QString &segment_key);
+    void reply(QLocalSocket *socket, const QJsonObject &message);
+    void reply_render(QLocalSocket *socket, const QJsonValue &id, const QString &segment_key);
+    void reply_error(QLocalSocket *socket, const QJsonValue &id, const QString &message);
+    void release(QLocalSocket *socket, const QString &segment_key);
+
+    QLocalServer *server;
+    QString name;
+    QString error;
+
+    QString album_path;
+    QDateTime album_modified; //Of the album file when it was read
+    QDomDocument album;
+    AlbumShards *shards; //The album's photos, in order, reading shards as asked for
+
+    QTimer *batch_timer;
+    QHash<QString, int> queued_photos; //Index in queue, by path
+    QList<PhotoJob> queue; //Renders waiting for the next batch
+    QList<PhotoJob> batch; //Renders being made
+    QFutureWatcher<void> *batch_watcher;
+
+    int next_segment;
+    QHash<QString, Segment> segments; //By segment key
+    QHash<QString, QString> published; //Segment key, by render key
+    QHash<QLocalSocket *, QStringList> held; //Segment keys, by client
+};
+
+#endif // RENDER_SERVICE_H
@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the Slideshow class declared in
+//slideshow.h. Photos are prepared on the slideshow's thread pool and come
+//back to the GUI thread through a queued call of photo_prepared(). Results
+//prepared for an earlier screen size are recognized by their generation
+//and thrown away.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "slideshow.h"
+#include "exif_reader.h"
+#include "image_buffers.h"
+#include "image_cache.h"
+#include "pixel_cache.h"
+#include "trace.h"
+#include <QtGui>
+#include <QPointer>
+#include <QtConcurrent>
+
+namespace
+{
+//Refresh interval of a 60 Hz display. A crossfade frame more than two of
+//these after the one before it is counted as late.
+const qint64 FrameUs = 16667;
+
+//Crossfade frames are requested this often
+const int FrameIntervalMs = 8;
+
+//Step of the Up and Down keys, and the shortest interval they allow
+const int IntervalStepMs = 1000;
+}
+
+QString Slideshow::Stats::text() const
+{
+    double average_ahead = transitions > 0 ? double(total_ahead) / transitions : 0.0;
+    return QString("%1 transitions, %2 dropped (worst %3 ms late), at least %4 photos "
+                   "decoded ahead (%5 on average), %6 crossfade frames, %7 late "
+                   "(worst %8 ms)")
+           .arg(transitions).arg(dropped).arg(worst_latency_us / 1000.0, 0, 'f', 1)
+           .arg(qMax(min_ahead, 0)).arg(average_ahead, 0, 'f', 1)
+           .arg(frames).arg(late_frames).arg(worst_frame_us / 1000.0, 0, 'f', 1);
+}
+
+Slideshow::Slideshow(const QStringList &files, const QList<EditRecipe> &edits, int start,
+                     const Settings &settings, QWidget *parent) :
+    QWidget(parent),
+    files(files),
+    edits(edits),
+    settings(settings),
+    current(0),
+    target(-1),
+    paused(false),
+    waiting(false),
+    generation(0),
+    deadline_us(0),
+    fade_start_us(-1),
+    last_frame_us(0)
+{
+    setWindowTitle(tr("Slideshow"));
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    setCursor(Qt::BlankCursor);
+
+    qRegisterMetaType<QImage>("QImage");
+
+    current = wrap(start);
+    this->settings.decode_ahead = qMax(1, settings.decode_ahead);
+    this->settings.fade_ms = qBound(0, settings.fade_ms, settings.interval_ms);
+
+    //Enough threads to prepare the whole decode-ahead window at once, while
+    //leaving a core for painting
+    pool.setMaxThreadCount(qBound(1, this->settings.decode_ahead,
+                                  qMax(1, QThread::idealThreadCount() - 1)));
+
+    deadline_timer.setSingleShot(true);
+    deadline_timer.setTimerType(Qt::PreciseTimer);
+    connect(&deadline_timer, SIGNAL(timeout()), this, SLOT(deadline_reached()));
+    frame_timer.setTimerType(Qt::PreciseTimer);
+    frame_timer.setInterval(FrameIntervalMs);
+    connect(&frame_timer, SIGNAL(timeout()), this, SLOT(fade_frame()));
+
+    clock.start();
+}
+
+Slideshow::~Slideshow()
+{
+    pool.clear();
+    pool.waitForDone();
+    ImageBufferManager::instance()->release(QString("Slideshow:%1").arg(quintptr(this)));
+}
+
+int Slideshow::wrap(int index) const
+{
+    if(files.isEmpty())
+        return 0;
+    index %= files.size();
+    return index < 0 ? index + files.size() : index;
+}
+
+//Decodes the photo at path to fit box at ratio device pixels per pixel,
+//makes its edits, turns it upright and converts it for painting. Runs on a
+//worker thread.
+QImage Slideshow::prepare(const QString &path, const EditRecipe &edits, const QSize &box,
+                          qreal ratio)
+{
+    TRACE_SCOPE("prepare_slide", "decode");
+
+    int orientation = ExifReader::orientation(path);
+    QSize device_box(qRound(box.width() * ratio), qRound(box.height() * ratio));
+    QSize stored_box = ExifReader::upright_size(device_box, orientation);
+    QString key = edits.key();
+
+    //A photo already decoded or rendered for the album window is only
+    //scaled, and one shown in an earlier slideshow on this screen is mapped
+    //from the PixelCache. Anything else is decoded and cached for next time.
+    QImage image = edits.is_empty() ? ImageCache::instance()->find(path)
+                                    : ImageCache::instance()->find_render(path, key);
+    if(!image.isNull())
+    {
+        image = image.scaled(stored_box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    else
+    {
+        image = PixelCache::instance()->load(path, stored_box, 0, key);
+    }
+    if(image.isNull())
+    {
+        //The photo is decoded just large enough for its edited result to
+        //fill the box, and the edits are made at that scale
+        QImageReader reader(path);
+        QSize size = reader.size();
+        QSize result = edits.result_size(size);
+        if(size.isValid() && !result.isEmpty()
+           && (result.width() > stored_box.width() || result.height() > stored_box.height()))
+        {
+            double scale = qMin(double(stored_box.width()) / result.width(),
+                                double(stored_box.height()) / result.height());
+            reader.setScaledSize(QSize(qMax(1, qRound(size.width() * scale)),
+                                       qMax(1, qRound(size.height() * scale))));
+        }
+        image = reader.read();
+        if(image.isNull())
+            return image;
+        if(!edits.is_empty())
+            image = edits.render(image, size.isValid() ? double(image.width()) / size.width() : 1);
+        PixelCache::instance()->insert(path, stored_box, image, result, key);
+    }
+
+    if(orientation != 1)
+        image = image.transformed(ExifReader::transform(orientation));
+    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(ratio);
+    return image;
+}
+
+//Prepares the photo shown, the one due next and the decode-ahead window
+//after it, unless they are prepared or being prepared already
+void Slideshow::request_ahead()
+{
+    if(files.isEmpty() || size().isEmpty())
+        return;
+
+    QList<int> wanted;
+    wanted.append(current);
+    if(target >= 0)
+        wanted.append(target);
+    for(int i = 1; i <= settings.decode_ahead; i++)
+    {
+        wanted.append(wrap(current + i));
+    }
+
+    QSize box = size();
+    qreal ratio = devicePixelRatioF();
+    int request_generation = generation;
+    QPointer<Slideshow> slideshow(this);
+    for(int i = 0; i < wanted.size(); i++)
+    {
+        int index = wanted[i];
+        if(ready.contains(index) || loading.contains(index))
+            continue;
+
+        loading.insert(index);
+        QString path = files[index];
+        EditRecipe recipe = edits.value(index);
+        QtConcurrent::run(&pool, [slideshow, path, recipe, box, ratio, request_generation, index]()
+        {
+            QImage image = prepare(path, recipe, box, ratio);
+            if(slideshow)
+            {
+                QMetaObject::invokeMethod(slideshow, "photo_prepared", Qt::QueuedConnection,
+                                          Q_ARG(int, request_generation), Q_ARG(int, index),
+                                          Q_ARG(QImage, image));
+            }
+        });
+    }
+}
+
+void Slideshow::photo_prepared(int generation, int index, QImage image)
+{
+    if(generation != this->generation)
+        return;
+
+    loading.remove(index);
+    ready.insert(index, image);
+    drop_unneeded();
+
+    //The first photo is shown as soon as it is ready, and the photo shown
+    //is replaced when it was prepared again for a new screen size
+    if(index == current && fade_start_us < 0)
+    {
+        bool first = shown.isNull() && target < 0;
+        shown = image;
+        update();
+        if(first)
+            schedule_next();
+        return;
+    }
+
+    if(waiting && index == target)
+        begin_transition();
+}
+
+//Due time of the next photo, counted from the start of this one
+void Slideshow::schedule_next()
+{
+    deadline_timer.stop();
+    if(paused || files.size() < 2)
+    {
+        target = -1;
+        return;
+    }
+
+    target = wrap(current + 1);
+    deadline_us = clock.nsecsElapsed() / 1000 + qint64(settings.interval_ms) * 1000;
+    deadline_timer.start(settings.interval_ms);
+    request_ahead();
+}
+
+void Slideshow::deadline_reached()
+{
+    if(paused || target < 0)
+        return;
+
+    if(ready.contains(target))
+    {
+        begin_transition();
+    }
+    else
+    {
+        //The photo is late. It is shown as soon as it has been prepared.
+        waiting = true;
+        timing.dropped++;
+    }
+}
+
+//Steps to the photo at index right away, as the arrow keys do
+void Slideshow::go_to(int index)
+{
+    deadline_timer.stop();
+    target = wrap(index);
+    deadline_us = clock.nsecsElapsed() / 1000;
+    if(ready.contains(target))
+    {
+        begin_transition();
+    }
+    else
+    {
+        waiting = true;
+        request_ahead();
+    }
+}
+
+//Starts showing the photo at target, crossfading from the one shown
+void Slideshow::begin_transition()
+{
+    TRACE_SCOPE("slide_transition", "paint");
+
+    qint64 now = clock.nsecsElapsed() / 1000;
+    timing.transitions++;
+    timing.worst_latency_us = qMax(timing.worst_latency_us, now - deadline_us);
+
+    //Photos prepared ahead of the one about to be shown
+    int ahead = 0;
+    while(ahead < settings.decode_ahead && ready.contains(wrap(target + 1 + ahead)))
+    {
+        ahead++;
+    }
+    timing.min_ahead = timing.min_ahead < 0 ? ahead : qMin(timing.min_ahead, ahead);
+    timing.total_ahead += ahead;
+
+    previous = shown;
+    shown = ready.value(target);
+    current = target;
+    target = -1;
+    waiting = false;
+
+    if(settings.fade_ms > 0 && !previous.isNull())
+    {
+        fade_start_us = now;
+        last_frame_us = now;
+        frame_timer.start();
+    }
+    else
+    {
+        previous = QImage();
+        fade_start_us = -1;
+    }
+
+    update();
+    schedule_next();
+}
+
+void Slideshow::fade_frame()
+{
+    update();
+}
+
+//Forgets prepared photos outside the decode-ahead window. The photo before
+//the one shown is kept, so stepping back is immediate.
+void Slideshow::drop_unneeded()
+{
+    QSet<int> keep;
+    for(int i = -1; i <= settings.decode_ahead; i++)
+    {
+        keep.insert(wrap(current + i));
+    }
+    if(target >= 0)
+        keep.insert(target);
+
+    qint64 bytes = 0;
+    QMap<int, QImage>::iterator it = ready.begin();
+    while(it != ready.end())
+    {
+        if(keep.contains(it.key()))
+        {
+            bytes += ImageBufferManager::image_bytes(it.value());
+            ++it;
+        }
+        else
+        {
+            it = ready.erase(it);
+        }
+    }
+    ImageBufferManager::instance()->track_bytes(QString("Slideshow:%1").arg(quintptr(this)),
+                                                bytes);
+}
+
+void Slideshow::paintEvent(QPaintEvent *)
+{
+    TRACE_SCOPE("slide_frame", "paint");
+
+    QPainter painter(this);
+
+    //Where a prepared photo goes, centered
+    auto placed = [this](const QImage &image)
+    {
+        QSizeF size = QSizeF(image.size()) / image.devicePixelRatio();
+        return QRectF(QPointF((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+    };
+
+    double opacity = 1.0;
+    if(fade_start_us >= 0)
+    {
+        qint64 now = clock.nsecsElapsed() / 1000;
+        qint64 gap = now - last_frame_us;
+        timing.frames++;
+        if(gap > 2 * FrameUs)
+            timing.late_frames++;
+        timing.worst_frame_us = qMax(timing.worst_frame_us, gap);
+        last_frame_us = now;
+
+        opacity = double(now - fade_start_us) / (qint64(settings.fade_ms) * 1000);
+        if(opacity >= 1.0)
+        {
+            opacity = 1.0;
+            previous = QImage();
+            fade_start_us = -1;
+            frame_timer.stop();
+        }
+    }
+
+    painter.fillRect(rect(), Qt::black);
+    if(!previous.isNull())
+    {
+        //The photo faded out turns black where the new one does not cover it
+        painter.drawImage(placed(previous), previous);
+        painter.setOpacity(opacity);
+        QRegion outside(rect());
+        if(!shown.isNull())
+            outside -= QRegion(placed(shown).toRect());
+        const QVector<QRect> rects = outside.rects();
+        for(int i = 0; i < rects.size(); i++)
+        {
+            painter.fillRect(rects[i], Qt::black);
+        }
+    }
+    if(!shown.isNull())
+    {
+        painter.setOpacity(opacity);
+        painter.drawImage(placed(shown), shown);
+    }
+
+    if(paused || shown.isNull())
+    {
+        painter.setOpacity(1.0);
+        painter.setPen(Qt::gray);
+        QString text = paused ? tr("Paused") : QFileInfo(files.value(current)).fileName();
+        painter.drawText(rect().adjusted(20, 20, -20, -20), Qt::AlignLeft | Qt::AlignBottom, text);
+    }
+}
+
+//A new screen size needs every photo prepared again
+void Slideshow::resizeEvent(QResizeEvent *)
+{
+    generation++;
+    loading.clear();
+    ready.clear();
+    request_ahead();
+}
+
+void Slideshow::keyPressEvent(QKeyEvent *event)
+{
+    switch(event->key())
+    {
+    case Qt::Key_Escape:
+        close();
+        break;
+    case Qt::Key_Right:
+        go_to(current + 1);
+        break;
+    case Qt::Key_Left:
+        go_to(current - 1);
+        break;
+    case Qt::Key_Space:
+        paused = !paused;
+        waiting = false;
+        schedule_next();
+        update();
+        break;
+    case Qt::Key_Up:
+        settings.interval_ms += IntervalStepMs;
+        schedule_next();
+        break;
+    case Qt::Key_Down:
+        settings.interval_ms = qMax(IntervalStepMs, settings.interval_ms - IntervalStepMs);
+        settings.fade_ms = qMin(settings.fade_ms, settings.interval_ms);
+        schedule_next();
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
+
+void Slideshow::closeEvent(QCloseEvent *event)
+{
+    deadline_timer.stop();
+    frame_timer.stop();
+    emit finished(current, timing.text());
+    QWidget::closeEvent(event);
+}
@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The Slideshow class, a full screen window that shows the
+//album's photos one after another, crossfading between them.
+//
+//Decoding a 30 MP photo takes longer than a crossfade frame, so the photos
+//after the one shown are prepared ahead on the slideshow's own thread pool:
+//each is decoded straight to the screen's size in device pixels (JPEGs
+//scale while decoding), edited, turned upright for its EXIF orientation
+//and converted to the format the screen paints fastest. Painting a photo is
+//then a plain copy, and only the crossfade blends two of them.
+//
+//Every transition is timed against its deadline. A transition whose photo
+//was not prepared in time is counted as dropped and happens as soon as the
+//photo arrives. Crossfade frames are timed too, and how many photos were
+//prepared ahead is sampled at every transition. The stats are reported
+//when the slideshow closes.
+//
+//Right and Left step forward and back, Space pauses, Up and Down change the
+//interval by a second, and Escape ends the slideshow.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SLIDESHOW_H
+#define SLIDESHOW_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include "edit_recipe.h"
+
+class Slideshow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    struct Settings
+    {
+        int interval_ms;  //Time each photo is shown, crossfade included
+        int fade_ms;      //Length of the crossfade, 0 to cut
+        int decode_ahead; //Photos prepared ahead of the one shown
+
+        Settings() : interval_ms(5000), fade_ms(800), decode_ahead(3) {}
+    };
+
+    //Timing of the slideshow so far
+    struct Stats
+    {
+        int transitions;
+        int dropped;             //Transitions whose photo was not ready in time
+        qint64 worst_latency_us; //Longest a transition happened after its deadline
+        int min_ahead;           //Fewest photos prepared ahead at a transition
+        qint64 total_ahead;      //Sum over transitions, for the average
+        int frames;              //Crossfade frames painted
+        int late_frames;         //Frames later than two refresh intervals
+        qint64 worst_frame_us;   //Longest time between two crossfade frames
+
+        Stats() : transitions(0), dropped(0), worst_latency_us(0), min_ahead(-1),
+                  total_ahead(0), frames(0), late_frames(0), worst_frame_us(0) {}
+        QString text() const;
+    };
+
+    //Shows files, each with the edits at the same index, starting at start
+    Slideshow(const QStringList &files, const QList<EditRecipe> &edits, int start,
+              const Settings &settings, QWidget *parent = 0);
+    ~Slideshow();
+
+    const Stats &stats() const { return timing; }
+
+signals:
+    //Emitted when the slideshow closes, with the photo it was showing
+    void finished(int index, QString stats);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+    void closeEvent(QCloseEvent *event);
+
+private slots:
+    void photo_prepared(int generation, int index, QImage image);
+    void deadline_reached();
+    void fade_frame();
+
+private:
+    static QImage prepare(const QString &path, const EditRecipe &edits, const QSize &box,
+                          qreal ratio);
+
+    int wrap(int index) const;
+    void request_ahead();
+    void go_to(int index);
+    void begin_transition();
+    void schedule_next();
+    void drop_unneeded();
+
+    QStringList files;
+    QList<EditRecipe> edits;
+    Settings settings;
+    Stats timing;
+
+    int current;             //Index of the photo shown
+    int target;              //Index of the next photo, -1 if none is due
+    bool paused;
+    bool waiting;            //A transition is due but its photo is not ready
+    QImage shown;            //Prepared photo shown
+    QImage previous;         //Photo faded out, while a crossfade runs
+    QMap<int, QImage> ready; //Prepared photos by index
+    QSet<int> loading;       //Indices being prepared
+    int generation;          //Bumped when the screen size changes
+
+    QTimer deadline_timer;
+    QTimer frame_timer;
+    QElapsedTimer clock;
+    qint64 deadline_us;      //When the next transition is due, on clock
+    qint64 fade_start_us;    //When the running crossfade began, or -1
+    qint64 last_frame_us;
+    QThreadPool pool;        //Declared last so it finishes preparing first
+};
+
+#endif // SLIDESHOW_H
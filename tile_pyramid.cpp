@@ -0,0 +1,351 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the TilePyramid class declared in
+//tile_pyramid.h. Tiles are stored as JPEGs under the user's cache directory
+//in pyramids/<hash of path>/<hash of size and mtime>/, with a small manifest
+//that is only written once every tile exists. A pyramid without a manifest
+//was interrupted and is rebuilt.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tile_pyramid.h"
+#include "image_buffers.h"
+#include "image_cache.h"
+#include "jpeg_scanline_reader.h"
+#include "trace.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace
+{
+const char *ManifestName = "manifest";
+const int TileQuality = 90;
+
+//Box a photo with edits is rendered to fit when the whole photo does not
+//fit in the image memory budget
+const QSize ProxySize(4096, 4096);
+
+//Share of the image memory budget a proxy of a photo that can be neither
+//held nor decoded in strips may use
+const int ProxyBudgetShare = 2;
+
+QString hash(const QString &text)
+{
+    return QString(QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+//Directory holding every cached pyramid of the file at path
+QString cache_root(const QString &path)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/pyramids/" + hash(QFileInfo(path).absoluteFilePath());
+}
+}
+
+TilePyramid::TilePyramid(const QString &path, const EditRecipe &edits, QObject *parent) :
+    QObject(parent),
+    source(path),
+    edits(edits),
+    levels(0),
+    proxy(false),
+    ready_flag(false),
+    cancelled(false)
+{
+    //A changed file gets a new directory, so stale tiles are never used
+    QFileInfo info(path);
+    QString version = QString("%1:%2").arg(info.size())
+                      .arg(info.lastModified().toMSecsSinceEpoch());
+    if(!edits.is_empty())
+        version += ":" + edits.key();
+    directory = cache_root(path) + "/" + hash(version);
+}
+
+TilePyramid::~TilePyramid()
+{
+    cancelled = true;
+    future.waitForFinished();
+}
+
+void TilePyramid::remove_cached(const QString &path)
+{
+    QDir(cache_root(path)).removeRecursively();
+}
+
+QSize TilePyramid::level_size(int level) const
+{
+    int divisor = 1 << level;
+    return QSize((size.width() + divisor - 1) / divisor,
+                 (size.height() + divisor - 1) / divisor);
+}
+
+QSize TilePyramid::tile_grid(int level) const
+{
+    QSize level_pixels = level_size(level);
+    return QSize((level_pixels.width() + TileSize - 1) / TileSize,
+                 (level_pixels.height() + TileSize - 1) / TileSize);
+}
+
+QString TilePyramid::tile_path(int level, int column, int row) const
+{
+    return QString("%1/%2/%3_%4.jpg").arg(directory).arg(level).arg(column).arg(row);
+}
+
+QImage TilePyramid::load_tile(int level, int column, int row) const
+{
+    TRACE_SCOPE("load_tile", "decode");
+    return QImage(tile_path(level, column, row));
+}
+
+bool TilePyramid::read_manifest()
+{
+    QFile file(directory + "/" + ManifestName);
+    if(!file.open(QFile::ReadOnly | QFile::Text))
+        return false;
+
+    QTextStream in(&file);
+    int width = 0, height = 0, proxied = 0;
+    in >> width >> height >> levels >> proxied;
+    size = QSize(width, height);
+    proxy = proxied != 0;
+    return !size.isEmpty() && levels > 0;
+}
+
+void TilePyramid::build()
+{
+    if(read_manifest())
+    {
+        ready_flag = true;
+        emit ready();
+        return;
+    }
+
+    if(future.isRunning())
+        return;
+
+    future = QtConcurrent::run(this, &TilePyramid::build_pyramid);
+}
+
+//Runs on a worker thread
+void TilePyramid::build_pyramid()
+{
+    TRACE_SCOPE("build_pyramid", "pyramid");
+
+    QImageReader probe(source);
+    size = probe.size();
+    if(!size.isValid())
+    {
+        emit failed("Cannot read " + source + ": " + probe.errorString());
+        return;
+    }
+
+    ImageBufferManager *buffers = ImageBufferManager::instance();
+    qint64 whole_bytes = qint64(size.width()) * size.height() * 4;
+    if(!edits.is_empty())
+    {
+        //Edits are made over the whole photo, so the pyramid is cut from the
+        //render, at whatever size it came out
+        whole = ImageCache::instance()->load_render(source, edits, ProxySize, &proxy);
+    }
+    else
+    {
+        //Use the decode the main window already has, else decode once if it
+        //fits. A JPEG that does not is decoded in strips instead.
+        whole = ImageCache::instance()->find(source);
+        if(whole.isNull() && buffers->reserve(whole_bytes))
+        {
+            TRACE_SCOPE("decode", "decode");
+            whole = probe.read();
+            buffers->track("TilePyramid:" + source, whole);
+        }
+        else if(whole.isNull() && !JpegScanlineReader(source).open())
+        {
+            TRACE_SCOPE("decode_proxy", "decode");
+            double factor = std::sqrt(double(buffers->budget() / ProxyBudgetShare) / whole_bytes);
+            proxy = factor < 1;
+            if(proxy)
+            {
+                probe.setScaledSize(size.scaled(qMax(1, int(size.width() * factor)),
+                                                qMax(1, int(size.height() * factor)),
+                                                Qt::KeepAspectRatio));
+            }
+            whole = probe.read();
+            buffers->track("TilePyramid:" + source, whole);
+        }
+    }
+    if(!edits.is_empty() || proxy)
+    {
+        if(whole.isNull())
+        {
+            buffers->release("TilePyramid:" + source);
+            emit failed("Cannot decode " + source);
+            return;
+        }
+        size = whole.size();
+    }
+
+    //Every level down to the one that fits in a single tile
+    levels = 1;
+    while(level_size(levels - 1).width() > TileSize || level_size(levels - 1).height() > TileSize)
+    {
+        levels++;
+    }
+
+    QDir().mkpath(directory);
+    for(int level = 0; level < levels; level++)
+    {
+        QDir(directory).mkpath(QString::number(level));
+    }
+
+    QString error;
+    bool built = build_base_level(&error);
+    whole = QImage();
+    buffers->release("TilePyramid:" + source);
+    if(!built)
+    {
+        emit failed(error);
+        return;
+    }
+
+    for(int level = 1; level < levels; level++)
+    {
+        if(!build_level(level))
+            return;
+        emit progress(50 + 50 * level / levels);
+    }
+
+    //Only a complete pyramid gets a manifest
+    QFile file(directory + "/" + ManifestName);
+    if(file.open(QFile::WriteOnly | QFile::Text))
+    {
+        QTextStream out(&file);
+        out << size.width() << " " << size.height() << " " << levels << " "
+            << (proxy ? 1 : 0) << "\n";
+    }
+
+    ready_flag = true;
+    emit ready();
+}
+
+//Cuts the full resolution photo into level 0 tiles, one strip of tiles at a
+//time, from whole or else straight from the decoder. The tiles of a strip
+//are encoded in parallel.
+bool TilePyramid::build_base_level(QString *error)
+{
+    TRACE_SCOPE("build_base_level", "pyramid");
+
+    JpegScanlineReader reader(source);
+    if(whole.isNull() && (!reader.open() || reader.size() != size))
+    {
+        *error = "Cannot decode " + source + ": " + reader.error_string();
+        return false;
+    }
+
+    QSize grid = tile_grid(0);
+    for(int row = 0; row < grid.height(); row++)
+    {
+        if(cancelled)
+            break;
+
+        QRect strip_rect(0, row * TileSize, size.width(),
+                         qMin(TileSize, size.height() - row * TileSize));
+        QImage strip;
+        if(!whole.isNull())
+        {
+            strip = whole.copy(strip_rect);
+        }
+        else
+        {
+            strip = reader.read(strip_rect.height());
+        }
+
+        if(strip.isNull())
+        {
+            *error = "Cannot decode " + source;
+            break;
+        }
+
+        QVector<int> columns(grid.width());
+        for(int column = 0; column < columns.size(); column++)
+        {
+            columns[column] = column;
+        }
+
+        QtConcurrent::blockingMap(columns, [this, &strip, row](int column)
+        {
+            TRACE_SCOPE("encode_tile", "pyramid");
+            QImage tile = strip.copy(column * TileSize, 0,
+                                     qMin(TileSize, size.width() - column * TileSize),
+                                     strip.height());
+            tile.save(tile_path(0, column, row), "JPG", TileQuality);
+        });
+
+        emit progress(50 * (row + 1) / grid.height());
+    }
+
+    return error->isEmpty() && !cancelled;
+}
+
+//Builds level from the level below it: each tile is the 2x2 block of tiles
+//beneath it scaled down by half
+bool TilePyramid::build_level(int level)
+{
+    TRACE_SCOPE("build_level", "pyramid");
+
+    QSize grid = tile_grid(level);
+    QSize below = tile_grid(level - 1);
+    QVector<int> tiles(grid.width() * grid.height());
+    for(int i = 0; i < tiles.size(); i++)
+    {
+        tiles[i] = i;
+    }
+
+    QtConcurrent::blockingMap(tiles, [this, level, grid, below](int index)
+    {
+        if(cancelled)
+            return;
+
+        int column = index % grid.width();
+        int row = index / grid.width();
+
+        QImage block(TileSize * 2, TileSize * 2, QImage::Format_RGB32);
+        block.fill(Qt::black);
+        int width = 0, height = 0;
+        {
+            QPainter painter(&block);
+            for(int dy = 0; dy < 2; dy++)
+            {
+                for(int dx = 0; dx < 2; dx++)
+                {
+                    int c = column * 2 + dx, r = row * 2 + dy;
+                    if(c >= below.width() || r >= below.height())
+                        continue;
+
+                    QImage child = load_tile(level - 1, c, r);
+                    painter.drawImage(dx * TileSize, dy * TileSize, child);
+                    if(dy == 0)
+                        width += child.width();
+                    if(dx == 0)
+                        height += child.height();
+                }
+            }
+        }
+
+        QImage tile = block.copy(0, 0, width, height)
+                      .scaled((width + 1) / 2, (height + 1) / 2,
+                              Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        tile.save(tile_path(level, column, row), "JPG", TileQuality);
+    });
+
+    return !cancelled;
+}
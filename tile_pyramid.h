@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The TilePyramid class, a multi-resolution tile pyramid of one
+//photo cached on disk. Level 0 is the photo at full resolution cut into
+//TileSize square tiles, and every further level halves the previous one
+//until it fits in a single tile. A viewer only has to load the few tiles
+//that intersect its viewport at the level matching its zoom.
+//
+//build() creates the pyramid on a background thread, unless a finished one
+//for the same file (path, size and modification time) and edits is already
+//cached. Photos that fit in the image memory budget are decoded once; larger
+//JPEGs are decoded top to bottom a strip of tiles at a time. Upper levels are
+//made from the tiles of the level below, so memory stays bounded by a few
+//strips. A photo with edits is rendered whole. Anything else too large to
+//hold is made into a pyramid of a proxy that fits, and is_proxy() says so.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include <QObject>
+#include <QImage>
+#include <QFuture>
+#include <atomic>
+#include "edit_recipe.h"
+
+class TilePyramid : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int TileSize = 256;
+
+    //Pyramid of the photo at path with edits made
+    TilePyramid(const QString &path, const EditRecipe &edits, QObject *parent = 0);
+    ~TilePyramid();
+
+    //Starts building the pyramid in the background, or emits ready() right
+    //away if it is already cached
+    void build();
+
+    bool is_ready() const { return ready_flag.load(); }
+
+    //These are only valid once the pyramid is ready
+    QSize image_size() const { return size; }
+    bool is_proxy() const { return proxy; } //Smaller than the photo itself
+    int level_count() const { return levels; }
+    QSize level_size(int level) const;
+    QSize tile_grid(int level) const; //Columns x rows of tiles
+
+    //Loads one tile from disk. Safe to call from any thread.
+    QImage load_tile(int level, int column, int row) const;
+
+    //Deletes every cached pyramid of the file at path
+    static void remove_cached(const QString &path);
+
+signals:
+    void progress(int percent);
+    void ready();
+    void failed(QString error);
+
+private:
+    QString tile_path(int level, int column, int row) const;
+    bool read_manifest();
+    void build_pyramid();
+    bool build_base_level(QString *error);
+    bool build_level(int level);
+
+    QString source;     //Path of the photo
+    EditRecipe edits;
+    QImage whole;       //The photo decoded or rendered whole, if it fit,
+                        //while the base level is built
+    QString directory;  //Directory the tiles are cached in
+    QSize size;
+    int levels;
+    bool proxy;
+    std::atomic<bool> ready_flag;
+    std::atomic<bool> cancelled;
+    QFuture<void> future;
+};
+
+#endif // TILE_PYRAMID_H
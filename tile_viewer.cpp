@@ -0,0 +1,339 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the TileViewer class declared in
+//tile_viewer.h. Tile loads run on the viewer's own thread pool and come back
+//to the GUI thread through a queued call of tile_loaded(). The pool is
+//waited on before the viewer (and its pyramid) are destroyed.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tile_viewer.h"
+#include "exif_reader.h"
+#include "image_buffers.h"
+#include "trace.h"
+#include <QtGui>
+#include <QPointer>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace
+{
+//Zoom limits relative to showing the whole photo, and to 1:1
+const double MinZoomOfFit = 0.5;
+const double MaxScale = 8.0;
+}
+
+TileViewer::TileViewer(const QString &path, const EditRecipe &edits, QWidget *parent) :
+    QWidget(parent),
+    orientation(ExifReader::orientation(path)),
+    scale(1.0),
+    build_progress(0)
+{
+    setWindowTitle(tr("Zoom Viewer - %1").arg(QFileInfo(path).fileName()));
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    resize(1024, 768);
+
+    qRegisterMetaType<QImage>("QImage");
+
+    pyramid = new TilePyramid(path, edits, this);
+    connect(pyramid, SIGNAL(ready()), this, SLOT(pyramid_ready()));
+    connect(pyramid, SIGNAL(progress(int)), this, SLOT(pyramid_progress(int)));
+    connect(pyramid, SIGNAL(failed(QString)), this, SLOT(pyramid_failed(QString)));
+    pyramid->build();
+
+    update_cache_limit();
+}
+
+TileViewer::~TileViewer()
+{
+    pool.clear();
+    pool.waitForDone();
+    ImageBufferManager::instance()->release(QString("TileViewer:%1").arg(quintptr(this)));
+}
+
+quint64 TileViewer::tile_key(int level, int column, int row)
+{
+    return (quint64(level) << 56) | (quint64(row) << 28) | quint64(column);
+}
+
+void TileViewer::pyramid_ready()
+{
+    fit_to_window();
+    update();
+}
+
+void TileViewer::pyramid_progress(int percent)
+{
+    build_progress = percent;
+    update();
+}
+
+void TileViewer::pyramid_failed(QString error)
+{
+    error_message = error;
+    update();
+}
+
+//Picks the coarsest level that still has at least one pixel per screen pixel
+int TileViewer::level_for_scale() const
+{
+    int level = int(std::floor(std::log2(1.0 / scale)));
+    return qBound(0, level, pyramid->level_count() - 1);
+}
+
+//The size of the photo as it is shown, turned upright
+QSize TileViewer::upright_size() const
+{
+    return ExifReader::upright_size(pyramid->image_size(), orientation);
+}
+
+//Maps stored full resolution pixels to screen pixels
+QTransform TileViewer::view_transform() const
+{
+    QSize stored = pyramid->image_size();
+    QTransform upright = QImage::trueMatrix(ExifReader::transform(orientation),
+                                            stored.width(), stored.height());
+    return upright * QTransform::fromTranslate(-offset.x(), -offset.y())
+                   * QTransform::fromScale(scale, scale);
+}
+
+void TileViewer::fit_to_window()
+{
+    QSize image_size = upright_size();
+    scale = qMin(double(width()) / image_size.width(), double(height()) / image_size.height());
+    offset = QPointF(0, 0);
+    clamp_offset();
+}
+
+//Keeps the photo on screen, centering it along any axis where it is
+//smaller than the window
+void TileViewer::clamp_offset()
+{
+    QSizeF view(width() / scale, height() / scale);
+    QSizeF image_size = upright_size();
+
+    if(view.width() >= image_size.width())
+        offset.setX((image_size.width() - view.width()) / 2);
+    else
+        offset.setX(qBound(0.0, offset.x(), image_size.width() - view.width()));
+
+    if(view.height() >= image_size.height())
+        offset.setY((image_size.height() - view.height()) / 2);
+    else
+        offset.setY(qBound(0.0, offset.y(), image_size.height() - view.height()));
+}
+
+//Zooms by factor keeping the photo pixel under position where it is
+void TileViewer::zoom_at(QPointF position, double factor)
+{
+    if(!pyramid->is_ready())
+        return;
+
+    QSize image_size = upright_size();
+    double fit = qMin(double(width()) / image_size.width(), double(height()) / image_size.height());
+
+    QPointF anchor = offset + position / scale;
+    scale = qBound(fit * MinZoomOfFit, scale * factor, MaxScale);
+    offset = anchor - position / scale;
+    clamp_offset();
+    update();
+}
+
+//Allows a few screens worth of tiles to stay loaded
+void TileViewer::update_cache_limit()
+{
+    qreal ratio = devicePixelRatioF();
+    qint64 screen_bytes = qint64(width() * ratio) * qint64(height() * ratio) * 4;
+    qint64 tile_bytes = qint64(TilePyramid::TileSize) * TilePyramid::TileSize * 4;
+    tiles.setMaxCost(int((3 * screen_bytes + 16 * tile_bytes) / 1024));
+}
+
+const QImage *TileViewer::find_tile(int level, int column, int row)
+{
+    return tiles.object(tile_key(level, column, row));
+}
+
+//Loads a tile in the background unless it is already loaded or loading
+void TileViewer::request_tile(int level, int column, int row)
+{
+    quint64 key = tile_key(level, column, row);
+    if(loading.contains(key) || tiles.contains(key))
+        return;
+
+    loading.insert(key);
+    TilePyramid *source = pyramid;
+    QPointer<TileViewer> viewer(this);
+    QtConcurrent::run(&pool, [source, viewer, key, level, column, row]()
+    {
+        QImage tile = source->load_tile(level, column, row);
+        if(viewer)
+        {
+            QMetaObject::invokeMethod(viewer, "tile_loaded", Qt::QueuedConnection,
+                                      Q_ARG(quint64, key), Q_ARG(QImage, tile));
+        }
+    });
+}
+
+void TileViewer::tile_loaded(quint64 key, QImage tile)
+{
+    loading.remove(key);
+    if(tile.isNull())
+        return;
+
+    tiles.insert(key, new QImage(tile), qMax(1, int(ImageBufferManager::image_bytes(tile) / 1024)));
+    ImageBufferManager::instance()->track_bytes(QString("TileViewer:%1").arg(quintptr(this)),
+                                                qint64(tiles.totalCost()) * 1024);
+    update();
+}
+
+//Draws the area of a missing tile from the nearest coarser loaded tile.
+//Returns false if no coarser tile is loaded either.
+bool TileViewer::draw_fallback(QPainter &painter, int level, int column, int row)
+{
+    for(int coarse = level + 1; coarse < pyramid->level_count(); coarse++)
+    {
+        int shift = coarse - level;
+        const QImage *tile = find_tile(coarse, column >> shift, row >> shift);
+        if(tile == NULL)
+            continue;
+
+        //The part of the coarse tile covering this tile, in coarse pixels
+        double part = double(TilePyramid::TileSize) / (1 << shift);
+        QRectF source_rect((column - ((column >> shift) << shift)) * part,
+                           (row - ((row >> shift) << shift)) * part, part, part);
+        source_rect &= QRectF(tile->rect());
+
+        //The same area in full resolution pixels
+        double tile_span = double(TilePyramid::TileSize) * (1 << level);
+        QRectF target(column * tile_span, row * tile_span,
+                      source_rect.width() * (1 << coarse),
+                      source_rect.height() * (1 << coarse));
+
+        painter.drawImage(target, *tile, source_rect);
+        return true;
+    }
+    return false;
+}
+
+void TileViewer::paintEvent(QPaintEvent *event)
+{
+    TRACE_SCOPE("tile_viewer_paint", "display");
+
+    QPainter painter(this);
+    painter.fillRect(event->rect(), Qt::black);
+
+    if(!pyramid->is_ready())
+    {
+        painter.setPen(Qt::white);
+        QString text = error_message.isEmpty()
+                       ? tr("Building tiles... %1%").arg(build_progress)
+                       : error_message;
+        painter.drawText(rect(), Qt::AlignCenter, text);
+        return;
+    }
+
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+    //Tiles are drawn in stored full resolution pixels through the view,
+    //which turns them upright
+    QTransform view = view_transform();
+    painter.setTransform(view);
+
+    int level = level_for_scale();
+    int level_factor = 1 << level;
+    QSize grid = pyramid->tile_grid(level);
+
+    //Tiles covering the damaged area, in this level's tile coordinates
+    QRectF damaged = view.inverted().mapRect(QRectF(event->rect()));
+    double tile_span = double(TilePyramid::TileSize) * level_factor;
+    int first_column = qMax(0, int(damaged.left() / tile_span));
+    int last_column = qMin(grid.width() - 1, int(damaged.right() / tile_span));
+    int first_row = qMax(0, int(damaged.top() / tile_span));
+    int last_row = qMin(grid.height() - 1, int(damaged.bottom() / tile_span));
+
+    for(int row = first_row; row <= last_row; row++)
+    {
+        for(int column = first_column; column <= last_column; column++)
+        {
+            const QImage *tile = find_tile(level, column, row);
+            if(tile == NULL)
+            {
+                request_tile(level, column, row);
+                draw_fallback(painter, level, column, row);
+                continue;
+            }
+
+            QRectF target(column * tile_span, row * tile_span,
+                          tile->width() * level_factor, tile->height() * level_factor);
+            painter.drawImage(target, *tile);
+        }
+    }
+
+    if(pyramid->is_proxy())
+    {
+        painter.resetTransform();
+        QSize reduced = upright_size();
+        QString text = tr("Too large to decode in memory, shown at %1 x %2")
+                       .arg(reduced.width()).arg(reduced.height());
+        painter.setPen(Qt::white);
+        painter.drawText(rect().adjusted(8, 8, -8, -8), Qt::AlignLeft | Qt::AlignBottom, text);
+    }
+}
+
+void TileViewer::resizeEvent(QResizeEvent *)
+{
+    update_cache_limit();
+    if(pyramid->is_ready())
+        clamp_offset();
+}
+
+void TileViewer::wheelEvent(QWheelEvent *event)
+{
+    double steps = event->angleDelta().y() / 120.0;
+    zoom_at(event->posF(), std::pow(1.25, steps));
+}
+
+void TileViewer::mousePressEvent(QMouseEvent *event)
+{
+    last_mouse = event->pos();
+}
+
+//Dragging pans the photo
+void TileViewer::mouseMoveEvent(QMouseEvent *event)
+{
+    if(!(event->buttons() & Qt::LeftButton) || !pyramid->is_ready())
+        return;
+
+    offset -= QPointF(event->pos() - last_mouse) / scale;
+    last_mouse = event->pos();
+    clamp_offset();
+    update();
+}
+
+void TileViewer::keyPressEvent(QKeyEvent *event)
+{
+    QPointF center(width() / 2.0, height() / 2.0);
+    switch(event->key())
+    {
+    case Qt::Key_Plus:
+    case Qt::Key_Equal:
+        zoom_at(center, 1.25);
+        break;
+    case Qt::Key_Minus:
+        zoom_at(center, 0.8);
+        break;
+    case Qt::Key_0:
+        if(pyramid->is_ready())
+        {
+            fit_to_window();
+            update();
+        }
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
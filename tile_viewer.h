@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The TileViewer class, a window for zooming and panning around
+//a photo of any size using a TilePyramid. Only the tiles that intersect the
+//viewport at the pyramid level matching the current zoom are loaded, on a
+//background thread pool. Until a tile arrives, the area is drawn from a
+//coarser level that is already loaded, so panning never blocks.
+//
+//Mouse wheel or +/- zoom around the cursor, dragging pans, and 0 fits the
+//whole photo in the window. Loaded tiles are kept in a small cache sized to
+//a few screens, so memory is bounded by the window size, not the photo.
+//
+//Tiles hold stored pixels like the rest of the album's caches and are turned
+//upright for the file's EXIF orientation as they are painted.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TILE_VIEWER_H
+#define TILE_VIEWER_H
+
+#include <QWidget>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+#include <QTransform>
+#include "tile_pyramid.h"
+
+class TileViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //Shows the photo at path with edits made
+    TileViewer(const QString &path, const EditRecipe &edits, QWidget *parent = 0);
+    ~TileViewer();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void wheelEvent(QWheelEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+
+private slots:
+    void pyramid_ready();
+    void pyramid_progress(int percent);
+    void pyramid_failed(QString error);
+    void tile_loaded(quint64 key, QImage tile);
+
+private:
+    static quint64 tile_key(int level, int column, int row);
+
+    QSize upright_size() const;
+    QTransform view_transform() const;
+    void fit_to_window();
+    void zoom_at(QPointF position, double factor);
+    void clamp_offset();
+    int level_for_scale() const;
+    const QImage *find_tile(int level, int column, int row);
+    void request_tile(int level, int column, int row);
+    bool draw_fallback(QPainter &painter, int level, int column, int row);
+    void update_cache_limit();
+
+    TilePyramid *pyramid;
+    int orientation;        //EXIF orientation of the photo
+    double scale;           //Screen pixels per full resolution pixel
+    QPointF offset;         //Upright full resolution pixel at the top left corner
+    QPoint last_mouse;
+    int build_progress;
+    QString error_message;
+    QCache<quint64, QImage> tiles; //Loaded tiles, cost in KB
+    QSet<quint64> loading;         //Tiles requested but not loaded yet
+    QThreadPool pool;              //Declared last so it finishes loads first
+};
+
+#endif // TILE_VIEWER_H
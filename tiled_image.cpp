@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the TiledImage class declared in
+//tiled_image.h. Tiles are plain QImages, so sharing a tile between versions
+//is just QImage's implicit sharing. All tiles are TileSize square even at
+//the edges, which keeps a cropped window's grid identical to the grid it
+//was cut from. Pixels are always stored as 32 bit words.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tiled_image.h"
+#include "image_buffers.h"
+#include "trace.h"
+#include <QtConcurrent>
+#include <cstring>
+
+namespace
+{
+const int BytesPerPixel = 4;
+
+int tiles_needed(int offset, int length)
+{
+    return (offset + length + TiledImage::TileSize - 1) / TiledImage::TileSize;
+}
+
+//Returns true if area of image matches tile, whose top left pixel is at
+//corner in image coordinates
+bool same_pixels(const QImage &tile, const QImage &image, const QRect &area, const QPoint &corner)
+{
+    int bytes = area.width() * BytesPerPixel;
+    for(int y = area.top(); y <= area.bottom(); y++)
+    {
+        const uchar *old_line = tile.constScanLine(y - corner.y())
+                                + (area.left() - corner.x()) * BytesPerPixel;
+        const uchar *new_line = image.constScanLine(y) + area.left() * BytesPerPixel;
+        if(std::memcmp(old_line, new_line, bytes) != 0)
+            return false;
+    }
+    return true;
+}
+}
+
+TiledImage::TiledImage() :
+    format(QImage::Format_RGB32),
+    columns(0)
+{
+}
+
+QRect TiledImage::cell(int column, int row) const
+{
+    return QRect(column * TileSize - origin.x(), row * TileSize - origin.y(), TileSize, TileSize);
+}
+
+TiledImage TiledImage::from_image(const QImage &image, const TiledImage &reference)
+{
+    TRACE_SCOPE("tile_image", "history");
+
+    QImage source = image;
+    if(source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32
+       && source.format() != QImage::Format_ARGB32_Premultiplied)
+    {
+        source = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                               : QImage::Format_RGB32);
+    }
+
+    TiledImage result;
+    if(source.isNull())
+        return result;
+
+    //Lay the grid out like the reference so the same tiles cover the same pixels
+    bool compare = !reference.is_null() && reference.image_size == source.size()
+                   && reference.format == source.format();
+
+    result.image_size = source.size();
+    result.format = source.format();
+    result.origin = compare ? reference.origin : QPoint(0, 0);
+    result.columns = tiles_needed(result.origin.x(), source.width());
+    int rows = tiles_needed(result.origin.y(), source.height());
+    result.tiles.resize(result.columns * rows);
+
+    QVector<int> indices(result.tiles.size());
+    for(int i = 0; i < indices.size(); i++)
+    {
+        indices[i] = i;
+    }
+
+    //Each thread only assigns its own elements, so take the pointer up front
+    QImage *tiles = result.tiles.data();
+    QtConcurrent::blockingMap(indices, [&](int index)
+    {
+        QRect cell = result.cell(index % result.columns, index / result.columns);
+        QRect area = cell & source.rect();
+
+        if(compare && same_pixels(reference.tiles[index], source, area, cell.topLeft()))
+        {
+            tiles[index] = reference.tiles[index];
+            return;
+        }
+
+        QImage tile(TileSize, TileSize, source.format());
+        tile.fill(0);
+        int bytes = area.width() * BytesPerPixel;
+        for(int y = area.top(); y <= area.bottom(); y++)
+        {
+            std::memcpy(tile.scanLine(y - cell.top()) + (area.left() - cell.left()) * BytesPerPixel,
+                        source.constScanLine(y) + area.left() * BytesPerPixel, bytes);
+        }
+        tiles[index] = tile;
+    });
+
+    return result;
+}
+
+TiledImage TiledImage::cropped(const QRect &rect) const
+{
+    QRect area = rect & QRect(QPoint(0, 0), image_size);
+
+    TiledImage result;
+    if(area.isEmpty())
+        return result;
+
+    //Drop the rows and columns of tiles left entirely outside the crop
+    QPoint start = origin + area.topLeft();
+    int first_column = start.x() / TileSize;
+    int first_row = start.y() / TileSize;
+
+    result.image_size = area.size();
+    result.format = format;
+    result.origin = QPoint(start.x() - first_column * TileSize, start.y() - first_row * TileSize);
+    result.columns = tiles_needed(result.origin.x(), area.width());
+    int rows = tiles_needed(result.origin.y(), area.height());
+
+    result.tiles.reserve(result.columns * rows);
+    for(int row = 0; row < rows; row++)
+    {
+        for(int column = 0; column < result.columns; column++)
+        {
+            result.tiles.append(tiles[(first_row + row) * columns + first_column + column]);
+        }
+    }
+    return result;
+}
+
+QImage TiledImage::to_image() const
+{
+    TRACE_SCOPE("assemble_tiles", "history");
+
+    if(is_null())
+        return QImage();
+
+    QImage image(image_size, format);
+    for(int index = 0; index < tiles.size(); index++)
+    {
+        QRect cell = this->cell(index % columns, index / columns);
+        QRect area = cell & image.rect();
+        const QImage &tile = tiles[index];
+
+        int bytes = area.width() * BytesPerPixel;
+        for(int y = area.top(); y <= area.bottom(); y++)
+        {
+            std::memcpy(image.scanLine(y) + area.left() * BytesPerPixel,
+                        tile.constScanLine(y - cell.top()) + (area.left() - cell.left()) * BytesPerPixel,
+                        bytes);
+        }
+    }
+    return image;
+}
+
+qint64 TiledImage::count_unique_bytes(QSet<qint64> *keys) const
+{
+    qint64 bytes = 0;
+    for(int index = 0; index < tiles.size(); index++)
+    {
+        qint64 key = tiles[index].cacheKey();
+        if(!keys->contains(key))
+        {
+            keys->insert(key);
+            bytes += ImageBufferManager::image_bytes(tiles[index]);
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: The TiledImage class, an image stored as a grid of square
+//tiles that are shared copy-on-write between versions of the same photo.
+//It is how the undo history keeps many versions of a photo without keeping
+//a full frame per version.
+//
+//Building a TiledImage from an edited image against the previous version
+//reuses every tile whose pixels did not change, so a version only costs
+//memory for the tiles an edit actually touched. A crop does not copy any
+//pixels at all: the cropped version is a window onto the same tiles.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TILED_IMAGE_H
+#define TILED_IMAGE_H
+
+#include <QImage>
+#include <QSet>
+#include <QVector>
+
+class TiledImage
+{
+public:
+    static const int TileSize = 128;
+
+    TiledImage();
+
+    //Cuts image into tiles. Where reference is a version of the same size,
+    //tiles whose pixels match it are shared with it instead of copied.
+    static TiledImage from_image(const QImage &image,
+                                 const TiledImage &reference = TiledImage());
+
+    bool is_null() const { return tiles.isEmpty(); }
+    QSize size() const { return image_size; }
+
+    //The area rect of this image, sharing all of its tiles
+    TiledImage cropped(const QRect &rect) const;
+
+    //Assembles the tiles back into one image
+    QImage to_image() const;
+
+    //Adds the cacheKey() of every tile to keys and returns the bytes of the
+    //tiles that were not in keys yet. Used to count shared tiles only once.
+    qint64 count_unique_bytes(QSet<qint64> *keys) const;
+
+private:
+    //Area of tile (column, row) in image coordinates, before clipping
+    QRect cell(int column, int row) const;
+
+    QSize image_size;
+    QImage::Format format;
+    QPoint origin;      //Position of the image's top left within the grid
+    int columns;
+    QVector<QImage> tiles; //Row by row; every tile is TileSize square
+};
+
+#endif // TILED_IMAGE_H
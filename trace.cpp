@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: Implementation of the Tracer class declared in trace.h. Every
+//thread that records a span gets its own ring buffer, registered once in a
+//global list so that dump() can find it. Buffers are never freed, so spans
+//recorded by worker threads that have since exited still show up in a dump.
+//Only the owning thread ever changes a buffer's count of spans written;
+//clear() just marks how far a dump should skip.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "trace.h"
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <chrono>
+
+namespace
+{
+//Number of spans each thread keeps before it starts overwriting the oldest
+const int RingCapacity = 1 << 16;
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 start_us;
+    qint64 duration_us;
+};
+
+struct ThreadBuffer
+{
+    ThreadBuffer() : events(RingCapacity), written(0), cleared(0), tid(0) {}
+
+    QVector<TraceEvent> events;
+    std::atomic<quint64> written; //Total spans ever recorded by this thread
+    std::atomic<quint64> cleared; //Value of written at the last clear()
+    quint64 tid;
+    QString thread_name;
+};
+
+QMutex registry_mutex;
+QVector<ThreadBuffer *> registry;
+thread_local ThreadBuffer *local_buffer = NULL;
+
+//Returns the calling thread's buffer, registering a new one on first use
+ThreadBuffer *thread_buffer()
+{
+    if(local_buffer == NULL)
+    {
+        ThreadBuffer *buffer = new ThreadBuffer;
+
+        QMutexLocker lock(&registry_mutex);
+        buffer->tid = registry.size() + 1;
+        buffer->thread_name = QThread::currentThread()->objectName();
+        registry.append(buffer);
+        local_buffer = buffer;
+    }
+    return local_buffer;
+}
+
+//Escapes a string for use inside a JSON string literal
+QString json_escape(const QString &text)
+{
+    QString escaped;
+    escaped.reserve(text.size());
+    for(int i = 0; i < text.size(); i++)
+    {
+        QChar c = text.at(i);
+        if(c == '"' || c == '\\')
+            escaped += QChar('\\');
+        if(c.unicode() < 0x20)
+            escaped += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+}
+
+std::atomic<bool> Tracer::enabled(false);
+
+void Tracer::set_enabled(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::set_thread_name(const QString &name)
+{
+    ThreadBuffer *buffer = thread_buffer();
+
+    QMutexLocker lock(&registry_mutex);
+    buffer->thread_name = name;
+}
+
+qint64 Tracer::now_us()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *name, const char *category,
+                    qint64 start_us, qint64 duration_us)
+{
+    ThreadBuffer *buffer = thread_buffer();
+
+    //Only this thread ever writes to its buffer, so no lock is needed. The
+    //release store publishes the event to a concurrent dump().
+    quint64 index = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[index % RingCapacity];
+    event.name = name;
+    event.category = category;
+    event.start_us = start_us;
+    event.duration_us = duration_us;
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+//Resetting written here would race with a thread recording into its
+//buffer, so the spans before the current count are skipped instead
+void Tracer::clear()
+{
+    QMutexLocker lock(&registry_mutex);
+    for(int i = 0; i < registry.size(); i++)
+    {
+        ThreadBuffer *buffer = registry[i];
+        buffer->cleared.store(buffer->written.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+    }
+}
+
+//Writes the buffered spans as "complete" (ph = X) trace events, plus one
+//metadata event per thread so the viewer shows readable thread names.
+//Dumping while other threads are still recording is allowed; at worst a
+//span that is overwritten mid-dump shows up with mixed fields.
+bool Tracer::dump(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate))
+    {
+        qDebug() << "Error opening trace file" << path;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    QMutexLocker lock(&registry_mutex);
+    bool first = true;
+    for(int i = 0; i < registry.size(); i++)
+    {
+        ThreadBuffer *buffer = registry[i];
+
+        QString thread_name = buffer->thread_name;
+        if(thread_name.isEmpty())
+            thread_name = QString("thread %1").arg(buffer->tid);
+
+        if(!first)
+            out << ",\n";
+        first = false;
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+            << buffer->tid << ",\"args\":{\"name\":\""
+            << json_escape(thread_name) << "\"}}";
+
+        quint64 written = buffer->written.load(std::memory_order_acquire);
+        quint64 begin = written > quint64(RingCapacity) ? written - RingCapacity : 0;
+        begin = qMax(begin, buffer->cleared.load(std::memory_order_relaxed));
+        for(quint64 j = begin; j < written; j++)
+        {
+            const TraceEvent &event = buffer->events[j % RingCapacity];
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"name\":\"" << event.name
+                << "\",\"cat\":\"" << event.category
+                << "\",\"ts\":" << event.start_us
+                << ",\"dur\":" << event.duration_us << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return out.status() == QTextStream::Ok;
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+//Authors: Colton Fuhrmann, Kevin Hilt
+//Date: October 19, 2026
+//Course: CSC421
+//Instructor: Dr. Weiss
+//
+//Description: A lightweight tracing layer used to find out where the time
+//goes when loading, decoding, scaling, filtering, encoding and saving images.
+//Code is instrumented with TRACE_SCOPE("name", "category"), which records a
+//span from the point of declaration to the end of the enclosing scope. Each
+//thread records into its own fixed-size ring buffer, so recording never takes
+//a lock and old events are simply overwritten. When tracing is disabled a
+//span costs a single relaxed atomic load.
+//
+//Tracer::dump() writes all buffered spans as Chrome trace-event JSON that
+//can be opened in chrome://tracing or https://ui.perfetto.dev
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+
+class Tracer
+{
+public:
+    static void set_enabled(bool enable);
+    static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+    //Names the calling thread in the trace output (optional)
+    static void set_thread_name(const QString &name);
+
+    //Writes every buffered event to path as Chrome trace-event JSON
+    static bool dump(const QString &path);
+
+    //Drops every buffered event
+    static void clear();
+
+    //Monotonic timestamp in microseconds used for all span times
+    static qint64 now_us();
+
+    //Records a finished span. name and category must be string literals
+    //(or otherwise outlive the tracer), since only the pointers are stored.
+    static void record(const char *name, const char *category,
+                       qint64 start_us, qint64 duration_us);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+//Records the lifetime of the enclosing scope. Use through TRACE_SCOPE.
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name, const char *category)
+        : name(name), category(category),
+          start(Tracer::is_enabled() ? Tracer::now_us() : -1) {}
+
+    ~TraceSpan()
+    {
+        if(start >= 0)
+            Tracer::record(name, category, start, Tracer::now_us() - start);
+    }
+
+private:
+    TraceSpan(const TraceSpan &);
+    TraceSpan &operator=(const TraceSpan &);
+
+    const char *name;
+    const char *category;
+    qint64 start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name, category) \
+    TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, category)
+
+#endif // TRACE_H